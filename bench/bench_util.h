@@ -0,0 +1,31 @@
+#pragma once
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+// Seconds elapsed since `begin`
+inline double elapsedSec(std::chrono::steady_clock::time_point begin) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+// Writes OBJ of grid x grid vertices with uv, (grid - 1)^2 * 2 triangles
+inline void writeGrid(const std::string& path, size_t grid) {
+    FILE* out = std::fopen(path.c_str(), "wb");
+    ASSERT_NE(out, nullptr);
+    for (size_t y = 0; y < grid; ++y) {
+        for (size_t x = 0; x < grid; ++x) {
+            std::fprintf(out, "v %f %f %f\n", x * 0.01f, y * 0.01f, ((x * 7 + y * 13) % 100) * 0.001f);
+            std::fprintf(out, "vt %f %f\n", x / float(grid), y / float(grid));
+        }
+    }
+    for (size_t y = 0; y + 1 < grid; ++y) {
+        for (size_t x = 0; x + 1 < grid; ++x) {
+            const size_t i = y * grid + x + 1;
+            std::fprintf(out, "f %zu/%zu %zu/%zu %zu/%zu\n", i, i, i + 1, i + 1, i + grid, i + grid);
+            std::fprintf(out, "f %zu/%zu %zu/%zu %zu/%zu\n", i + 1, i + 1, i + grid + 1, i + grid + 1, i + grid, i + grid);
+        }
+    }
+    std::fclose(out);
+}
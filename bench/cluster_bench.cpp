@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+#include "kk_renderer/kk_renderer.h"
+#include "kk_renderer/MeshOptimizer.h"
+#include "kk_renderer/ObjLoader.h"
+#include "bench_util.h"
+#include <chrono>
+#include <cmath>
+#include <glm/gtc/quaternion.hpp>
+#include <iostream>
+#ifndef TEST_RESOURCE_DIR
+#define TEST_RESOURCE_DIR "./resources"
+#endif
+
+using namespace kk;
+using namespace kk::renderer;
+
+static constexpr size_t kViews = 64;      // Camera positions around the model
+static constexpr size_t kIterations = 200; // Culls per view
+
+// Object space frustum and eye of a camera orbiting the model, looking at its centre
+struct ClusterBenchView {
+    Frustum frustum;
+    Vec3 eye;
+};
+
+static std::vector<ClusterBenchView> createViews(const Bounds& bounds) {
+    std::vector<ClusterBenchView> views;
+    for (size_t i = 0; i < kViews; ++i) {
+        const float angle = 6.2831853f * i / kViews;
+        PerspectiveCamera camera(45.0f, 16.0f / 9.0f, 0.1f, 100.0f);
+        camera.transform.position = bounds.center + Vec3(std::sin(angle), 0.3f, std::cos(angle)) * (bounds.radius * 1.5f);
+        // NOTE: quatLookAt() maps -z to the direction, while Camera looks toward +z
+        camera.transform.rotation = glm::quatLookAt(glm::normalize(camera.transform.position - bounds.center), Vec3(0.0f, -1.0f, 0.0f));
+        views.push_back({ Frustum::create(camera.getProjection() * camera.getView()), camera.transform.position });
+    }
+    return views;
+}
+
+TEST(ClusterBench, CullsPerSecond) {
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    loadObj(TEST_RESOURCE_DIR + std::string("/models/viking_room.obj"), vertices, indices);
+    optimizeMesh(vertices, indices);
+
+    std::vector<Meshlet> meshlets;
+    const auto build_begin = std::chrono::steady_clock::now();
+    buildMeshlets(vertices, indices, meshlets);
+    const double build_sec = elapsedSec(build_begin);
+    const ClusterBounds clusters = getClusterBounds(meshlets);
+    const std::vector<ClusterBenchView> views = createViews(Bounds::create(vertices));
+    std::cout << "[meshlets] " << indices.size() / 3 << " triangles -> " << meshlets.size() << " meshlets in " << build_sec * 1e3 << " ms" << std::endl;
+
+    // Scalar reference: sphere test only, one cluster at a time
+    std::vector<uint8_t> visible(clusters.size());
+    size_t scalar_visible = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t it = 0; it < kIterations; ++it) {
+        for (const auto& view : views) {
+            for (size_t i = 0; i < clusters.size(); ++i) {
+                visible[i] = view.frustum.intersects(Vec3(clusters.x[i], clusters.y[i], clusters.z[i]), clusters.radius[i]) ? 1 : 0;
+                scalar_visible += visible[i];
+            }
+        }
+    }
+    const double scalar_rate = kIterations * kViews * clusters.size() / elapsedSec(begin);
+
+    // Batched sphere and normal cone test
+    size_t batch_visible = 0, triangles = 0;
+    begin = std::chrono::steady_clock::now();
+    for (size_t it = 0; it < kIterations; ++it) {
+        for (const auto& view : views) {
+            batch_visible += view.frustum.cullClusters(clusters, view.eye, 1.0f, visible.data());
+        }
+    }
+    const double batch_rate = kIterations * kViews * clusters.size() / elapsedSec(begin);
+    for (const auto& view : views) {
+        view.frustum.cullClusters(clusters, view.eye, 1.0f, visible.data());
+        for (size_t i = 0; i < meshlets.size(); ++i) {
+            triangles += visible[i] ? meshlets[i].index_count / 3 : 0;
+        }
+    }
+
+    const double total = static_cast<double>(kIterations * kViews * clusters.size());
+    std::cout << "[scalar spheres]     " << scalar_rate << " clusters/s, " << 100.0 * scalar_visible / total << " % visible" << std::endl;
+    std::cout << "[batch sphere+cone]  " << batch_rate << " clusters/s (x" << batch_rate / scalar_rate << "), "
+        << 100.0 * batch_visible / total << " % visible" << std::endl;
+    std::cout << "[triangles drawn]    " << 100.0 * triangles / (kViews * indices.size() / 3) << " % of full mesh" << std::endl;
+}
@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+#include "kk_renderer/kk_renderer.h"
+#include "kk_renderer/Frustum.h"
+#include "bench_util.h"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace kk;
+using namespace kk::renderer;
+
+static constexpr size_t kObjectCount = 100000;
+static constexpr size_t kFrames = 50;
+
+TEST(CullingBench, SpheresPerSecond) {
+    // Open scene: objects scattered on a large plane around the camera
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> dist(-500.0f, 500.0f);
+    std::vector<float> xs(kObjectCount), ys(kObjectCount), zs(kObjectCount), radii(kObjectCount, 1.0f);
+    for (size_t i = 0; i < kObjectCount; ++i) {
+        xs[i] = dist(rng);
+        ys[i] = dist(rng) * 0.01f;
+        zs[i] = dist(rng);
+    }
+
+    PerspectiveCamera camera(60.0f, 16.0f / 9.0f, 0.1f, 300.0f);
+    const Frustum frustum = Frustum::create(camera.getProjection() * camera.getView());
+    std::vector<uint8_t> visible(kObjectCount);
+
+    size_t scalar_visible = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t frame = 0; frame < kFrames; ++frame) {
+        scalar_visible = 0;
+        for (size_t i = 0; i < kObjectCount; ++i) {
+            scalar_visible += frustum.intersects(Vec3(xs[i], ys[i], zs[i]), radii[i]) ? 1 : 0;
+        }
+    }
+    const double scalar = kFrames * kObjectCount / elapsedSec(begin);
+
+    size_t batch_visible = 0;
+    begin = std::chrono::steady_clock::now();
+    for (size_t frame = 0; frame < kFrames; ++frame) {
+        batch_visible = frustum.cullSpheres(xs.data(), ys.data(), zs.data(), radii.data(), kObjectCount, visible.data());
+    }
+    const double batch = kFrames * kObjectCount / elapsedSec(begin);
+
+    EXPECT_EQ(scalar_visible, batch_visible);
+    std::cout << "[scalar] " << scalar << " spheres/s" << std::endl;
+    std::cout << "[batch]  " << batch << " spheres/s (x" << batch / scalar << ")" << std::endl;
+    std::cout << "culled: " << kObjectCount - batch_visible << " / " << kObjectCount << std::endl;
+}
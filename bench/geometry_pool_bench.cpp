@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+#include "kk_renderer/kk_renderer.h"
+#include "bench_util.h"
+#include <chrono>
+#include <iostream>
+#ifndef TEST_RESOURCE_DIR
+#define TEST_RESOURCE_DIR "./resources"
+#endif
+
+using namespace kk;
+using namespace kk::renderer;
+
+static constexpr uint32_t kWidth = 1280;
+static constexpr uint32_t kHeight = 720;
+static constexpr size_t kFrames = 100;
+static constexpr size_t kGeometryCount = 1024; // Distinct meshes, each drawn once per frame
+
+struct PoolBenchResult {
+    double fps;
+    Renderer::FrameStats stats; // Of the last frame
+};
+
+static PoolBenchResult benchDraws(RenderingContext& ctx, Renderer& renderer, std::vector<Renderable>& renderables) {
+    std::vector<uint8_t> pixels;
+    PoolBenchResult result{};
+    const auto begin = std::chrono::steady_clock::now();
+    for (size_t frame = 0; frame < kFrames; ++frame) {
+        if (!renderer.beginFrame(ctx)) {
+            continue;
+        }
+        for (size_t i = 0; i < renderables.size(); ++i) {
+            Mat4 mvp(0.05f);
+            mvp[3] = Vec4((i % 32) / 16.0f - 1.0f, (i / 32) / 16.0f - 1.0f, 0.5f, 1.0f);
+            renderer.render(ctx, renderables[i], mvp);
+        }
+        renderer.endFrame(ctx);
+        result.stats = renderer.getFrameStats();
+        renderer.readback(ctx, pixels, false);
+    }
+    vkDeviceWaitIdle(ctx.device);
+    result.fps = kFrames / elapsedSec(begin);
+
+    return result;
+}
+
+TEST(GeometryPoolBench, BindsPerFrame) {
+    RenderingContext ctx = RenderingContext::createHeadless();
+    ctx.geometry_pool = std::make_shared<GeometryPool>(GeometryPool::create(ctx, GeometryPool::kDefaultVertexSize, GeometryPool::kDefaultIndexSize));
+    Renderer renderer = Renderer::createOffscreen(ctx, kWidth, kHeight);
+    renderer.setSubmitMode(Renderer::SubmitMode::kDeferred);
+
+    auto vert = std::make_shared<Shader>(Shader::create(ctx, TEST_RESOURCE_DIR + std::string("/shaders/triangle.vert.spv")));
+    auto frag = std::make_shared<Shader>(Shader::create(ctx, TEST_RESOURCE_DIR + std::string("/shaders/triangle.frag.spv")));
+    auto texture = std::make_shared<Texture>(Texture::create(ctx, TEST_RESOURCE_DIR + std::string("/textures/statue.jpg")));
+    auto material = std::make_shared<Material>();
+    material->setVertexShader(vert);
+    material->setFragmentShader(frag);
+    material->setTexture(texture);
+
+    // Distinct small meshes, so that draws are never merged into instanced draws
+    std::vector<Renderable> owned, pooled;
+    for (size_t i = 0; i < kGeometryCount; ++i) {
+        const float s = 1.0f + i * 1e-3f;
+        const std::vector<Vertex> vertices = {
+            {{ 0.0f, -0.5f * s, 0.0f}, {}, {1.0f, 0.0f, 0.0f, 1.0f}},
+            {{ 0.5f * s,  0.5f, 0.0f}, {}, {0.0f, 1.0f, 0.0f, 1.0f}},
+            {{-0.5f * s,  0.5f, 0.0f}, {}, {0.0f, 0.0f, 1.0f, 1.0f}},
+        };
+        const std::vector<uint32_t> indices = { 0, 1, 2 };
+        owned.push_back({ std::make_shared<Geometry>(Geometry::create(ctx, vertices, indices)), material });
+        pooled.push_back({ std::make_shared<Geometry>(Geometry::create(ctx, vertices, indices, kGeometryPooled)), material });
+    }
+
+    const PoolBenchResult without = benchDraws(ctx, renderer, owned);
+    const PoolBenchResult with = benchDraws(ctx, renderer, pooled);
+    std::cout << "[own buffers] " << without.stats.vertex_buffer_binds << " vertex / " << without.stats.index_buffer_binds
+        << " index binds per frame, " << without.fps << " fps" << std::endl;
+    std::cout << "[pooled]      " << with.stats.vertex_buffer_binds << " vertex / " << with.stats.index_buffer_binds
+        << " index binds per frame, " << with.fps << " fps (x" << with.fps / without.fps << ")" << std::endl;
+
+    for (auto& renderable : owned) {
+        renderable.geometry->destroy(ctx);
+    }
+    for (auto& renderable : pooled) {
+        renderable.geometry->destroy(ctx);
+    }
+    material->destroy(ctx);
+    texture->destroy(ctx);
+    frag->destroy(ctx);
+    vert->destroy(ctx);
+    renderer.destroy(ctx);
+    ctx.destroy();
+}
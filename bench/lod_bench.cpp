@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+#include "kk_renderer/kk_renderer.h"
+#include "bench_util.h"
+#include <chrono>
+#include <iostream>
+#ifndef TEST_RESOURCE_DIR
+#define TEST_RESOURCE_DIR "./resources"
+#endif
+
+using namespace kk;
+using namespace kk::renderer;
+
+static constexpr uint32_t kWidth = 1280;
+static constexpr uint32_t kHeight = 720;
+static constexpr size_t kFrames = 100;
+static constexpr size_t kGridSize = 24; // Rooms per side, receding from the camera
+
+struct LodBenchResult {
+    double fps;
+    size_t triangles; // Per frame
+};
+
+static LodBenchResult benchGrid(RenderingContext& ctx, Renderer& renderer, Renderable& renderable, const Camera& camera) {
+    std::vector<Transform> transforms;
+    for (size_t z = 0; z < kGridSize; ++z) {
+        for (size_t x = 0; x < kGridSize; ++x) {
+            Transform tf{};
+            tf.position = Vec3((x - kGridSize * 0.5f) * 3.0f, 0.0f, z * 3.0f);
+            transforms.push_back(tf);
+        }
+    }
+
+    std::vector<uint8_t> pixels;
+    size_t triangles = 0;
+    const auto begin = std::chrono::steady_clock::now();
+    for (size_t frame = 0; frame < kFrames; ++frame) {
+        if (!renderer.beginFrame(ctx)) {
+            continue;
+        }
+        for (const auto& tf : transforms) {
+            renderer.render(ctx, renderable, tf, camera);
+        }
+        renderer.endFrame(ctx);
+        triangles = renderer.getFrameStats().triangle_count;
+        renderer.readback(ctx, pixels, false);
+    }
+    vkDeviceWaitIdle(ctx.device);
+
+    return { kFrames / elapsedSec(begin), triangles };
+}
+
+TEST(LodBench, TrianglesPerFrame) {
+    RenderingContext ctx = RenderingContext::createHeadless();
+    Renderer renderer = Renderer::createOffscreen(ctx, kWidth, kHeight);
+    renderer.setSubmitMode(Renderer::SubmitMode::kDeferred);
+
+    const std::string path = TEST_RESOURCE_DIR + std::string("/models/viking_room.obj");
+    auto full = std::make_shared<Geometry>(Geometry::create(ctx, path, kGeometryOptimize));
+    const auto begin = std::chrono::steady_clock::now();
+    auto lod = std::make_shared<Geometry>(Geometry::create(ctx, path, kGeometryOptimize | kGeometryGenerateLods));
+    const double generate_sec = elapsedSec(begin);
+
+    auto vert = std::make_shared<Shader>(Shader::create(ctx, TEST_RESOURCE_DIR + std::string("/shaders/texture.vert.spv")));
+    auto frag = std::make_shared<Shader>(Shader::create(ctx, TEST_RESOURCE_DIR + std::string("/shaders/texture.frag.spv")));
+    auto texture = std::make_shared<Texture>(Texture::create(ctx, TEST_RESOURCE_DIR + std::string("/textures/viking_room.png")));
+    auto material = std::make_shared<Material>();
+    material->setFrontFace(VK_FRONT_FACE_COUNTER_CLOCKWISE);
+    material->setVertexShader(vert);
+    material->setFragmentShader(frag);
+    material->setTexture(texture);
+    Renderable full_renderable{ full, material };
+    Renderable lod_renderable{ lod, material };
+
+    PerspectiveCamera camera(45.0f, kWidth / static_cast<float>(kHeight), 0.1f, 200.0f);
+    camera.transform.position = Vec3(0.0f, -2.0f, -4.0f);
+
+    std::cout << "[lods] load + generation: " << generate_sec * 1e3 << " ms" << std::endl;
+    for (size_t i = 0; i < lod->lods.size(); ++i) {
+        std::cout << "    LOD " << i << ": " << lod->lods[i].index_count / 3 << " triangles, error " << lod->lods[i].error << std::endl;
+    }
+
+    const LodBenchResult without = benchGrid(ctx, renderer, full_renderable, camera);
+    const LodBenchResult with = benchGrid(ctx, renderer, lod_renderable, camera);
+    std::cout << "[without LOD] " << without.triangles << " triangles/frame, " << without.fps << " fps" << std::endl;
+    std::cout << "[with LOD]    " << with.triangles << " triangles/frame, " << with.fps << " fps (x" << with.fps / without.fps << ")" << std::endl;
+
+    material->destroy(ctx);
+    texture->destroy(ctx);
+    frag->destroy(ctx);
+    vert->destroy(ctx);
+    lod->destroy(ctx);
+    full->destroy(ctx);
+    renderer.destroy(ctx);
+    ctx.destroy();
+}
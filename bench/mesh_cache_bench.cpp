@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+#include "kk_renderer/kk_renderer.h"
+#include "bench_util.h"
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#ifndef TEST_RESOURCE_DIR
+#define TEST_RESOURCE_DIR "./resources"
+#endif
+
+using namespace kk;
+using namespace kk::renderer;
+
+// Grid of (kGridSize - 1)^2 * 2 = 2M triangles
+static constexpr size_t kGridSize = 1001;
+
+static void benchCache(RenderingContext& ctx, const std::string& label, const std::string& path) {
+    const std::string cache_path = "mesh_cache_bench.kkmesh";
+    std::remove(cache_path.c_str());
+
+    // Cache miss: parse OBJ and write cache
+    auto begin = std::chrono::steady_clock::now();
+    Geometry from_obj = Geometry::create(ctx, path, cache_path);
+    ctx.transfer.flush(ctx);
+    ctx.transfer.wait(ctx);
+    const double obj_sec = elapsedSec(begin);
+
+    // Cache hit
+    begin = std::chrono::steady_clock::now();
+    Geometry from_cache = Geometry::create(ctx, path, cache_path);
+    ctx.transfer.flush(ctx);
+    ctx.transfer.wait(ctx);
+    const double cache_sec = elapsedSec(begin);
+    EXPECT_EQ(from_cache.indices.size(), from_obj.indices.size());
+
+    // Cache hit without CPU copies
+    Geometry dropped = Geometry::create(ctx, path, cache_path, kGeometryDropCpuData);
+    const size_t kept_bytes = sizeof(Vertex) * from_cache.vertices.capacity() + sizeof(uint32_t) * from_cache.indices.capacity();
+    const size_t dropped_bytes = sizeof(Vertex) * dropped.vertices.capacity() + sizeof(uint32_t) * dropped.indices.capacity();
+
+    std::cout << "[" << label << "] " << from_obj.indices.size() / 3 << " triangles" << std::endl;
+    std::cout << "  OBJ + cache write: " << obj_sec * 1000.0 << " ms" << std::endl;
+    std::cout << "  .kkmesh:           " << cache_sec * 1000.0 << " ms (x" << obj_sec / cache_sec << ")" << std::endl;
+    std::cout << "  CPU copies:        " << kept_bytes << " byte, " << dropped_bytes << " byte with kGeometryDropCpuData" << std::endl;
+
+    dropped.destroy(ctx);
+    from_cache.destroy(ctx);
+    from_obj.destroy(ctx);
+    std::remove(cache_path.c_str());
+}
+
+TEST(MeshCacheBench, ColdStart) {
+    RenderingContext ctx = RenderingContext::createHeadless();
+
+    benchCache(ctx, "viking_room.obj", TEST_RESOURCE_DIR + std::string("/models/viking_room.obj"));
+
+    const std::string grid_path = "mesh_cache_bench_grid.obj";
+    writeGrid(grid_path, kGridSize);
+    benchCache(ctx, "synthetic grid", grid_path);
+    std::remove(grid_path.c_str());
+
+    ctx.destroy();
+}
@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+#include "kk_renderer/kk_renderer.h"
+#include "kk_renderer/MeshOptimizer.h"
+#include "kk_renderer/ObjLoader.h"
+#include "bench_util.h"
+#include <algorithm>
+#include <random>
+#include <chrono>
+#include <iostream>
+#ifndef TEST_RESOURCE_DIR
+#define TEST_RESOURCE_DIR "./resources"
+#endif
+
+using namespace kk;
+using namespace kk::renderer;
+
+static constexpr size_t kGridSize = 512;
+
+// Grid with triangles shuffled, as exported by tools that do not care about vertex order
+static void makeShuffledGrid(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+    for (size_t y = 0; y < kGridSize; ++y) {
+        for (size_t x = 0; x < kGridSize; ++x) {
+            Vertex vertex{};
+            vertex.position = Vec3(x * 0.01f, y * 0.01f, 0.0f);
+            vertices.push_back(vertex);
+        }
+    }
+    std::vector<std::array<uint32_t, 3>> triangles;
+    const uint32_t stride = static_cast<uint32_t>(kGridSize);
+    for (uint32_t y = 0; y + 1 < stride; ++y) {
+        for (uint32_t x = 0; x + 1 < stride; ++x) {
+            const uint32_t i = y * stride + x;
+            triangles.push_back({ i, i + 1, i + stride });
+            triangles.push_back({ i + 1, i + stride + 1, i + stride });
+        }
+    }
+    std::shuffle(triangles.begin(), triangles.end(), std::mt19937(7));
+    for (const auto& triangle : triangles) {
+        indices.insert(indices.end(), triangle.begin(), triangle.end());
+    }
+}
+
+static void printStats(const char* label, const std::vector<uint32_t>& indices, size_t vertex_count) {
+    const VertexCacheStats stats = analyzeVertexCache(indices, vertex_count);
+    std::cout << "    " << label << " ACMR: " << stats.acmr << ", ATVR: " << stats.atvr << std::endl;
+}
+
+static void benchOptimizer(const std::string& label, std::vector<Vertex> vertices, std::vector<uint32_t> indices) {
+    const double triangles = indices.size() / 3.0;
+    std::cout << "[" << label << "] " << static_cast<size_t>(triangles) << " triangles" << std::endl;
+    printStats("before  ", indices, vertices.size());
+
+    auto begin = std::chrono::steady_clock::now();
+    optimizeVertexCache(indices, vertices.size());
+    const double cache_sec = elapsedSec(begin);
+    printStats("cache   ", indices, vertices.size());
+
+    begin = std::chrono::steady_clock::now();
+    optimizeOverdraw(indices, vertices);
+    const double overdraw_sec = elapsedSec(begin);
+    printStats("overdraw", indices, vertices.size());
+
+    begin = std::chrono::steady_clock::now();
+    optimizeVertexFetch(vertices, indices);
+    const double fetch_sec = elapsedSec(begin);
+
+    std::cout << "    vertex cache: " << triangles / cache_sec / 1e6 << " Mtri/s, "
+              << "overdraw: " << triangles / overdraw_sec / 1e6 << " Mtri/s, "
+              << "vertex fetch: " << triangles / fetch_sec / 1e6 << " Mtri/s" << std::endl;
+}
+
+TEST(MeshOptimizerBench, TrianglesPerSecond) {
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    loadObj(TEST_RESOURCE_DIR + std::string("/models/viking_room.obj"), vertices, indices);
+    benchOptimizer("viking_room.obj", vertices, indices);
+
+    vertices.clear();
+    indices.clear();
+    makeShuffledGrid(vertices, indices);
+    benchOptimizer("shuffled grid", vertices, indices);
+}
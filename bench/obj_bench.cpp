@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+#include "kk_renderer/kk_renderer.h"
+#include "kk_renderer/ObjLoader.h"
+#include "bench_util.h"
+#define TINYOBJLOADER_IMPLEMENTATION
+#include <tinyobjloader/tiny_obj_loader.h>
+#include <unordered_map>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#ifndef TEST_RESOURCE_DIR
+#define TEST_RESOURCE_DIR "./resources"
+#endif
+
+using namespace kk;
+using namespace kk::renderer;
+
+// Grid of (kGridSize - 1)^2 * 2 = 10M triangles
+static constexpr size_t kGridSize = 2237;
+
+namespace std {
+    template<> struct hash<Vertex> {
+        size_t operator()(Vertex const& vertex) const {
+            return ((hash<Vec3>()(vertex.position) ^ (hash<Vec4>()(vertex.color) << 1)) >> 1) ^ (hash<Vec2>()(vertex.uv) << 1);
+        }
+    };
+}
+
+// Loading path before the native loader: tinyobj, then deduplication by value
+static void loadWithTinyobj(const std::string& path, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+    tinyobj::attrib_t attr;
+    std::vector<tinyobj::shape_t> shapes;
+    std::vector<tinyobj::material_t> materials;
+    std::string warn, err;
+    ASSERT_TRUE(tinyobj::LoadObj(&attr, &shapes, &materials, &warn, &err, path.c_str())) << err;
+
+    std::unordered_map<Vertex, uint32_t> unique_vertices{};
+    for (const auto& shape : shapes) {
+        for (const auto& index : shape.mesh.indices) {
+            Vertex vertex{};
+            vertex.position = {
+                attr.vertices[3 * index.vertex_index + 0],
+                attr.vertices[3 * index.vertex_index + 1],
+                attr.vertices[3 * index.vertex_index + 2]
+            };
+            vertex.uv = {
+                attr.texcoords[2 * index.texcoord_index + 0],
+                1.0f - attr.texcoords[2 * index.texcoord_index + 1]
+            };
+            vertex.color = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+            if (unique_vertices.count(vertex) == 0) {
+                unique_vertices[vertex] = static_cast<uint32_t>(vertices.size());
+                vertices.push_back(vertex);
+            }
+            indices.push_back(unique_vertices[vertex]);
+        }
+    }
+}
+
+static void benchLoaders(const std::string& label, const std::string& path) {
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+
+    auto begin = std::chrono::steady_clock::now();
+    loadWithTinyobj(path, vertices, indices);
+    const double tinyobj_sec = elapsedSec(begin);
+    const size_t triangle_count = indices.size() / 3;
+
+    vertices.clear();
+    indices.clear();
+    begin = std::chrono::steady_clock::now();
+    loadObj(path, vertices, indices);
+    const double native_sec = elapsedSec(begin);
+    EXPECT_EQ(indices.size() / 3, triangle_count);
+
+    std::cout << "[" << label << "] " << triangle_count << " triangles, " << vertices.size() << " vertices" << std::endl;
+    std::cout << "  tinyobj: " << tinyobj_sec * 1000.0 << " ms" << std::endl;
+    std::cout << "  loadObj: " << native_sec * 1000.0 << " ms (x" << tinyobj_sec / native_sec << ", "
+              << std::thread::hardware_concurrency() << " threads)" << std::endl;
+}
+
+TEST(ObjBench, VikingRoom) {
+    benchLoaders("viking_room.obj", TEST_RESOURCE_DIR + std::string("/models/viking_room.obj"));
+}
+
+TEST(ObjBench, SyntheticGrid) {
+    const std::string path = "obj_bench_grid.obj";
+    writeGrid(path, kGridSize);
+    benchLoaders("synthetic grid", path);
+    std::remove(path.c_str());
+}
@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+#include "kk_renderer/kk_renderer.h"
+#include "bench_util.h"
+#include <chrono>
+#include <iostream>
+#ifndef TEST_RESOURCE_DIR
+#define TEST_RESOURCE_DIR "./resources"
+#endif
+
+using namespace kk;
+using namespace kk::renderer;
+
+static constexpr uint32_t kWidth = 1280;
+static constexpr uint32_t kHeight = 720;
+static constexpr size_t kFrames = 200;
+
+// Renders kFrames frames, reading back every frame.
+// If `is_async`, frame N is read back after frame N+1 is submitted, otherwise right after its own submission.
+static double benchReadback(RenderingContext& ctx, Renderer& renderer, Renderable& renderable, const Camera& camera, bool is_async) {
+    std::vector<uint8_t> pixels;
+    size_t read_count = 0;
+    Transform tf{};
+
+    const auto begin = std::chrono::steady_clock::now();
+    for (size_t frame = 0; frame < kFrames; ++frame) {
+        if (!renderer.beginFrame(ctx)) {
+            continue;
+        }
+        tf.rotation = Vec3(0.0f, frame * 0.01f, 0.0f);
+        renderer.render(ctx, renderable, tf, camera);
+        renderer.endFrame(ctx);
+
+        if (!is_async || frame > 0) {
+            read_count += renderer.readback(ctx, pixels, true) ? 1 : 0;
+        }
+    }
+    while (renderer.readback(ctx, pixels, true)) {
+        ++read_count;
+    }
+    const double sec = elapsedSec(begin);
+
+    EXPECT_EQ(read_count, kFrames);
+    return kFrames / sec;
+}
+
+TEST(OffscreenBench, FramesPerSecond) {
+    RenderingContext ctx = RenderingContext::createHeadless();
+    Renderer renderer = Renderer::createOffscreen(ctx, kWidth, kHeight);
+
+    auto model = std::make_shared<Geometry>(Geometry::create(ctx, TEST_RESOURCE_DIR + std::string("/models/viking_room.obj")));
+    auto vert = std::make_shared<Shader>(Shader::create(ctx, TEST_RESOURCE_DIR + std::string("/shaders/texture.vert.spv")));
+    auto frag = std::make_shared<Shader>(Shader::create(ctx, TEST_RESOURCE_DIR + std::string("/shaders/texture.frag.spv")));
+    auto texture = std::make_shared<Texture>(Texture::create(ctx, TEST_RESOURCE_DIR + std::string("/textures/viking_room.png")));
+    auto material = std::make_shared<Material>();
+    material->setFrontFace(VK_FRONT_FACE_COUNTER_CLOCKWISE);
+    material->setVertexShader(vert);
+    material->setFragmentShader(frag);
+    material->setTexture(texture);
+    Renderable renderable{ model, material };
+
+    PerspectiveCamera camera(45.0f, kWidth / static_cast<float>(kHeight), 0.1f, 10.0f);
+    camera.transform.position.z = -3.0f;
+
+    const double sync = benchReadback(ctx, renderer, renderable, camera, false);
+    const double async = benchReadback(ctx, renderer, renderable, camera, true);
+    std::cout << "[blocking readback] " << kWidth << "x" << kHeight << ": " << sync << " fps" << std::endl;
+    std::cout << "[async readback]    " << kWidth << "x" << kHeight << ": " << async << " fps (x" << async / sync << ")" << std::endl;
+
+    vkDeviceWaitIdle(ctx.device);
+    material->destroy(ctx);
+    texture->destroy(ctx);
+    frag->destroy(ctx);
+    vert->destroy(ctx);
+    model->destroy(ctx);
+    renderer.destroy(ctx);
+    ctx.destroy();
+}
+
+// Renders a field of small, distant copies of viking_room, so that its 1024x1024 texture is heavily minified
+static double benchMinified(RenderingContext& ctx, Renderer& renderer, const std::shared_ptr<Geometry>& model, const std::shared_ptr<Texture>& texture) {
+    auto vert = std::make_shared<Shader>(Shader::create(ctx, TEST_RESOURCE_DIR + std::string("/shaders/texture.vert.spv")));
+    auto frag = std::make_shared<Shader>(Shader::create(ctx, TEST_RESOURCE_DIR + std::string("/shaders/texture.frag.spv")));
+    auto material = std::make_shared<Material>();
+    material->setFrontFace(VK_FRONT_FACE_COUNTER_CLOCKWISE);
+    material->setVertexShader(vert);
+    material->setFragmentShader(frag);
+    material->setTexture(texture);
+    Renderable renderable{ model, material };
+
+    PerspectiveCamera camera(45.0f, kWidth / static_cast<float>(kHeight), 0.1f, 100.0f);
+    camera.transform.position.z = -20.0f;
+
+    std::vector<uint8_t> pixels;
+    const int grid = 16;
+    const auto begin = std::chrono::steady_clock::now();
+    for (size_t frame = 0; frame < kFrames; ++frame) {
+        if (!renderer.beginFrame(ctx)) {
+            continue;
+        }
+        for (int y = 0; y < grid; ++y) {
+            for (int x = 0; x < grid; ++x) {
+                Transform tf{};
+                tf.position = Vec3(x - grid / 2, y - grid / 2, 0.0f) * 1.2f;
+                tf.rotation = Vec3(0.0f, frame * 0.01f, 0.0f);
+                renderer.render(ctx, renderable, tf, camera);
+            }
+        }
+        renderer.endFrame(ctx);
+        if (frame > 0) {
+            renderer.readback(ctx, pixels, true);
+        }
+    }
+    while (renderer.readback(ctx, pixels, true)) {}
+    const double sec = elapsedSec(begin);
+
+    vkDeviceWaitIdle(ctx.device);
+    material->destroy(ctx);
+    frag->destroy(ctx);
+    vert->destroy(ctx);
+    return kFrames / sec;
+}
+
+TEST(OffscreenBench, MinifiedTexture) {
+    RenderingContext ctx = RenderingContext::createHeadless();
+    Renderer renderer = Renderer::createOffscreen(ctx, kWidth, kHeight);
+    auto model = std::make_shared<Geometry>(Geometry::create(ctx, TEST_RESOURCE_DIR + std::string("/models/viking_room.obj")));
+    const std::string path = TEST_RESOURCE_DIR + std::string("/textures/viking_room.png");
+    const float max_anisotropy = ctx.max_anisotropy;
+
+    // NOTE: Sampler anisotropy is taken from context at texture creation
+    ctx.max_anisotropy = 1.0f;
+    auto single = std::make_shared<Texture>(Texture::create(ctx, path, kTextureNoMipmaps));
+    auto mipmapped = std::make_shared<Texture>(Texture::create(ctx, path));
+    ctx.max_anisotropy = max_anisotropy;
+    auto anisotropic = std::make_shared<Texture>(Texture::create(ctx, path));
+
+    const double single_fps = benchMinified(ctx, renderer, model, single);
+    const double mipmapped_fps = benchMinified(ctx, renderer, model, mipmapped);
+    const double anisotropic_fps = benchMinified(ctx, renderer, model, anisotropic);
+    std::cout << "[no mipmaps]         " << single_fps << " fps" << std::endl;
+    std::cout << "[mipmaps]            " << mipmapped_fps << " fps (x" << mipmapped_fps / single_fps << ")" << std::endl;
+    std::cout << "[mipmaps, " << max_anisotropy << "x aniso] " << anisotropic_fps << " fps (x" << anisotropic_fps / single_fps << ")" << std::endl;
+
+    vkDeviceWaitIdle(ctx.device);
+    single->destroy(ctx);
+    mipmapped->destroy(ctx);
+    anisotropic->destroy(ctx);
+    model->destroy(ctx);
+    renderer.destroy(ctx);
+    ctx.destroy();
+}
@@ -0,0 +1,6 @@
+#include <gtest/gtest.h>
+
+int main(int ac, char** av) {
+    ::testing::InitGoogleTest(&ac, av);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+#include "kk_renderer/kk_renderer.h"
+#include "kk_renderer/TextureLoader.h"
+#include "bench_util.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#ifndef TEST_RESOURCE_DIR
+#define TEST_RESOURCE_DIR "./resources"
+#endif
+
+using namespace kk::renderer;
+
+static constexpr size_t kIterations = 20;
+
+// Writes KTX2 of `format` with a full mip chain. Blocks are arbitrary, since they are not decoded on load.
+static void writeKtx2(const std::string& path, VkFormat format, uint32_t width, uint32_t height) {
+    static const uint8_t identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+    const uint32_t level_count = Texture::getMipLevels(width, height);
+    const uint32_t header[9] = { static_cast<uint32_t>(format), 1, width, height, 0, 0, 1, level_count, 0 };
+    const uint64_t index[4] = {};
+
+    std::vector<uint64_t> levels(level_count * 3);
+    uint64_t offset = sizeof(identifier) + sizeof(header) + sizeof(index) + sizeof(uint64_t) * levels.size();
+    for (uint32_t level = 0; level < level_count; ++level) {
+        const uint64_t size = getBlockCompressedSize(format, std::max(width >> level, 1u), std::max(height >> level, 1u));
+        levels[level * 3 + 0] = offset;
+        levels[level * 3 + 1] = size;
+        levels[level * 3 + 2] = size;
+        offset += size;
+    }
+
+    FILE* out = std::fopen(path.c_str(), "wb");
+    ASSERT_NE(out, nullptr);
+    std::fwrite(identifier, 1, sizeof(identifier), out);
+    std::fwrite(header, 1, sizeof(header), out);
+    std::fwrite(index, 1, sizeof(index), out);
+    std::fwrite(levels.data(), sizeof(uint64_t), levels.size(), out);
+    for (uint32_t level = 0; level < level_count; ++level) {
+        const std::vector<char> blocks(levels[level * 3 + 1], static_cast<char>(level));
+        std::fwrite(blocks.data(), 1, blocks.size(), out);
+    }
+    std::fclose(out);
+}
+
+// Seconds per TextureData::load() of `path`, and bytes of the loaded data
+static double benchLoad(const std::string& path, TextureData& data) {
+    const auto begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < kIterations; ++i) {
+        data = TextureData::load(path);
+    }
+    return elapsedSec(begin) / kIterations;
+}
+
+TEST(TextureLoadBench, DecodedVsBlockCompressed) {
+    // Decoded image gets its mips on upload, so its VRAM is mip 0 with a full chain (4/3 of mip 0)
+    TextureData png{};
+    const double png_sec = benchLoad(TEST_RESOURCE_DIR + std::string("/textures/viking_room.png"), png);
+    const size_t png_bytes = png.texels.size() * 4 / 3;
+    std::cout << "[png decode]  " << png.width << "x" << png.height << ": " << png_sec * 1000.0 << " ms, " << png_bytes / 1024 << " KiB" << std::endl;
+
+    const struct {
+        const char* label;
+        VkFormat format;
+    } formats[] = {
+        { "[ktx2 bc7]  ", VK_FORMAT_BC7_SRGB_BLOCK },
+        { "[ktx2 bc1]  ", VK_FORMAT_BC1_RGBA_SRGB_BLOCK },
+    };
+    for (const auto& format : formats) {
+        const std::string path = "texture_load_bench.ktx2";
+        writeKtx2(path, format.format, png.width, png.height);
+        TextureData ktx2{};
+        const double ktx2_sec = benchLoad(path, ktx2);
+        std::remove(path.c_str());
+        EXPECT_EQ(ktx2.getMipLevels(), Texture::getMipLevels(png.width, png.height));
+
+        std::cout << format.label << png.width << "x" << png.height << ": " << ktx2_sec * 1000.0 << " ms (x" << png_sec / ktx2_sec << "), "
+            << ktx2.texels.size() / 1024 << " KiB (x" << static_cast<double>(png_bytes) / ktx2.texels.size() << " smaller)" << std::endl;
+    }
+}
+
+TEST(TextureLoadBench, BatchCreation) {
+    const size_t kTextureCount = 64;
+    RenderingContext ctx = RenderingContext::createHeadless();
+    const std::vector<std::string> paths(kTextureCount, TEST_RESOURCE_DIR + std::string("/textures/viking_room.png"));
+
+    // One by one: decode on this thread, and flush each upload
+    size_t submits_before = ctx.transfer.getSubmitCount();
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<Texture> sequential;
+    for (const auto& path : paths) {
+        sequential.push_back(Texture::create(ctx, path));
+        ctx.transfer.flush(ctx);
+    }
+    ctx.transfer.wait(ctx);
+    const double sequential_sec = elapsedSec(begin);
+    const size_t sequential_submits = ctx.transfer.getSubmitCount() - submits_before;
+
+    submits_before = ctx.transfer.getSubmitCount();
+    begin = std::chrono::steady_clock::now();
+    std::vector<Texture> batch = Texture::createBatch(ctx, paths);
+    ctx.transfer.wait(ctx);
+    const double batch_sec = elapsedSec(begin);
+    const size_t batch_submits = ctx.transfer.getSubmitCount() - submits_before;
+
+    std::cout << "[sequential] " << kTextureCount << " textures: " << sequential_sec * 1000.0 << " ms, " << sequential_submits << " submits" << std::endl;
+    std::cout << "[batch]      " << kTextureCount << " textures: " << batch_sec * 1000.0 << " ms (x" << sequential_sec / batch_sec << "), "
+        << batch_submits << " submits" << std::endl;
+
+    for (auto& texture : sequential) {
+        texture.destroy(ctx);
+    }
+    for (auto& texture : batch) {
+        texture.destroy(ctx);
+    }
+    ctx.destroy();
+}
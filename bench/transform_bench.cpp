@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+#include "kk_renderer/kk_renderer.h"
+#include "kk_renderer/TransformStore.h"
+#include "bench_util.h"
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+using namespace kk;
+using namespace kk::renderer;
+
+static constexpr size_t kObjectCount = 100000;
+static constexpr size_t kFrames = 20;
+
+static std::vector<Transform> makeTransforms() {
+    std::vector<Transform> transforms(kObjectCount);
+    for (size_t i = 0; i < transforms.size(); ++i) {
+        transforms[i].position = Vec3(i % 100, (i / 100) % 100, i / 10000);
+        transforms[i].rotation = Quat(Vec3(i * 0.01f, i * 0.02f, 0.0f));
+    }
+    return transforms;
+}
+
+TEST(TransformBench, MatricesPerSecond) {
+    const std::vector<Transform> transforms = makeTransforms();
+    PerspectiveCamera camera(45.0f, 16.0f / 9.0f, 0.1f, 100.0f);
+    camera.transform.position.z = -10.0f;
+
+    // Path before transform store: model, view and projection per draw
+    Mat4 sink(0.0f);
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t frame = 0; frame < kFrames; ++frame) {
+        for (const auto& tf : transforms) {
+            const Mat4 model =
+                glm::scale(glm::mat4(1.0f), tf.scale) *
+                glm::mat4_cast(tf.rotation) *
+                glm::translate(glm::mat4(1.0f), tf.position);
+            const Mat4 view = glm::lookAt(
+                camera.transform.position,
+                camera.transform.position + camera.transform.rotation * Vec3(0.0f, 0.0f, 1.0f),
+                Vec3(0.0f, -1.0f, 0.0f)
+            );
+            sink += camera.getProjection() * view * model;
+        }
+    }
+    const double per_draw = kFrames * kObjectCount / elapsedSec(begin);
+
+    TransformStore store;
+    std::vector<TransformStore::Handle> handles;
+    for (const auto& tf : transforms) {
+        handles.push_back(store.add(tf));
+    }
+
+    // Every transform modified every frame, camera moving
+    begin = std::chrono::steady_clock::now();
+    for (size_t frame = 0; frame < kFrames; ++frame) {
+        for (size_t i = 0; i < handles.size(); ++i) {
+            store.set(handles[i], transforms[i]);
+        }
+        camera.transform.position.x = frame * 0.1f;
+        store.update(camera.getProjection() * camera.getView());
+        sink += store.getMvp(handles[frame]);
+    }
+    const double dynamic = kFrames * kObjectCount / elapsedSec(begin);
+
+    // Static transforms, camera moving
+    begin = std::chrono::steady_clock::now();
+    for (size_t frame = 0; frame < kFrames; ++frame) {
+        camera.transform.position.x = frame * 0.2f;
+        store.update(camera.getProjection() * camera.getView());
+        sink += store.getMvp(handles[frame]);
+    }
+    const double static_moving_camera = kFrames * kObjectCount / elapsedSec(begin);
+
+    std::cout << "[per-draw glm]                  " << per_draw << " matrices/s" << std::endl;
+    std::cout << "[store, all dirty]              " << dynamic << " matrices/s (x" << dynamic / per_draw << ")" << std::endl;
+    std::cout << "[store, static, moving camera]  " << static_moving_camera << " matrices/s (x" << static_moving_camera / per_draw << ")" << std::endl;
+    std::cout << "(checksum " << sink[0][0] << ")" << std::endl;
+}
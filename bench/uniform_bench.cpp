@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+#include "kk_renderer/kk_renderer.h"
+#include "bench_util.h"
+#include <unordered_map>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+using namespace kk;
+using namespace kk::renderer;
+
+static constexpr size_t kFrames = 200;
+
+// Uniform update path before dynamic uniform buffer: one host visible buffer per renderable per frame
+static double benchPerObjectBuffers(RenderingContext& ctx, size_t object_count) {
+    std::unordered_map<size_t, std::array<Buffer, kMaxConcurrentFrames>> uniforms;
+    const Mat4 mvp(1.0f);
+
+    const auto begin = std::chrono::steady_clock::now();
+    for (size_t frame = 0; frame < kFrames; ++frame) {
+        const size_t current_frame = frame % kMaxConcurrentFrames;
+        for (size_t id = 0; id < object_count; ++id) {
+            if (uniforms.find(id) == uniforms.end()) {
+                for (size_t i = 0; i < kMaxConcurrentFrames; ++i) {
+                    Buffer& uniform = uniforms[id][i];
+                    uniform = Buffer::create(
+                        ctx,
+                        sizeof(Mat4),
+                        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+                    );
+                }
+            }
+            std::memcpy(uniforms[id][current_frame].mapped, &mvp, sizeof(Mat4));
+        }
+    }
+    const double sec = elapsedSec(begin);
+
+    for (auto& uniform : uniforms) {
+        for (auto& buffer : uniform.second) {
+            buffer.destroy(ctx);
+        }
+    }
+
+    return (kFrames * object_count) / sec;
+}
+
+static double benchFrameAllocator(RenderingContext& ctx, size_t object_count) {
+    std::array<UniformAllocator, kMaxConcurrentFrames> uniforms;
+    for (auto& uniform : uniforms) {
+        uniform = UniformAllocator::create(ctx, 8 * 1024 * 1024);
+    }
+    const Mat4 mvp(1.0f);
+
+    const auto begin = std::chrono::steady_clock::now();
+    for (size_t frame = 0; frame < kFrames; ++frame) {
+        UniformAllocator& uniform = uniforms[frame % kMaxConcurrentFrames];
+        uniform.reset();
+        for (size_t id = 0; id < object_count; ++id) {
+            uint32_t block = 0, offset = 0;
+            std::memcpy(uniform.allocate(ctx, sizeof(Mat4), block, offset), &mvp, sizeof(Mat4));
+        }
+    }
+    const double sec = elapsedSec(begin);
+
+    for (auto& uniform : uniforms) {
+        uniform.destroy(ctx);
+    }
+
+    return (kFrames * object_count) / sec;
+}
+
+TEST(UniformBench, DrawsPerSecond) {
+    RenderingContext ctx = RenderingContext::create();
+
+    // NOTE: Per-object path allocates 2 VkDeviceMemory per object, so keep it under maxMemoryAllocationCount
+    const size_t legacy_count = 1024;
+    const double legacy = benchPerObjectBuffers(ctx, legacy_count);
+    const double linear = benchFrameAllocator(ctx, legacy_count);
+    std::cout << "[per-object buffers] " << legacy_count << " objects: " << legacy << " draws/s" << std::endl;
+    std::cout << "[frame allocator]    " << legacy_count << " objects: " << linear << " draws/s (x" << linear / legacy << ")" << std::endl;
+
+    const size_t large_count = 20000;
+    std::cout << "[frame allocator]    " << large_count << " objects: " << benchFrameAllocator(ctx, large_count) << " draws/s" << std::endl;
+
+    const MemoryAllocator::Stats stats = ctx.allocator.getStats();
+    std::cout << "[memory] blocks: " << stats.block_count << ", reserved: " << stats.reserved_size << " byte" << std::endl;
+
+    ctx.destroy();
+}
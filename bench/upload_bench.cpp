@@ -0,0 +1,40 @@
+#include <gtest/gtest.h>
+#include "kk_renderer/kk_renderer.h"
+#include "bench_util.h"
+#include <chrono>
+#include <iostream>
+#ifndef TEST_RESOURCE_DIR
+#define TEST_RESOURCE_DIR "./resources"
+#endif
+
+using namespace kk::renderer;
+
+TEST(UploadBench, ThousandMeshes) {
+    const size_t kMeshCount = 1000;
+    RenderingContext ctx = RenderingContext::create();
+
+    // Parse once, so that only upload cost is measured
+    Geometry source = Geometry::create(ctx, TEST_RESOURCE_DIR + std::string("/models/sphere.obj"));
+    ctx.transfer.flush(ctx);
+    ctx.transfer.wait(ctx);
+    const size_t submits_before = ctx.transfer.getSubmitCount();
+
+    std::vector<Geometry> geometries;
+    geometries.reserve(kMeshCount);
+    const auto begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < kMeshCount; ++i) {
+        geometries.push_back(Geometry::create(ctx, source.vertices, source.indices));
+    }
+    ctx.transfer.flush(ctx);
+    ctx.transfer.wait(ctx);
+    const double sec = elapsedSec(begin);
+
+    std::cout << "[upload] " << kMeshCount << " meshes: " << sec * 1000.0 << " ms, ";
+    std::cout << ctx.transfer.getSubmitCount() - submits_before << " submits" << std::endl;
+
+    for (auto& geometry : geometries) {
+        geometry.destroy(ctx);
+    }
+    source.destroy(ctx);
+    ctx.destroy();
+}
@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+#include "kk_renderer/kk_renderer.h"
+#include "kk_renderer/VertexWeldTable.h"
+#include "bench_util.h"
+#include <unordered_map>
+#include <chrono>
+#include <iostream>
+
+using namespace kk;
+using namespace kk::renderer;
+
+// Grid mesh: every vertex is referenced by 6 triangle corners, as in a typical closed mesh
+static constexpr size_t kGridSize = 1000;
+
+// Hash used by the model loader before the weld table
+struct LegacyVertexHash {
+    size_t operator()(Vertex const& vertex) const {
+        return ((std::hash<Vec3>()(vertex.position) ^ (std::hash<Vec4>()(vertex.color) << 1)) >> 1) ^ (std::hash<Vec2>()(vertex.uv) << 1);
+    }
+};
+
+static std::vector<Vertex> makeCorners() {
+    const auto makeVertex = [](size_t x, size_t y) {
+        Vertex vertex{};
+        vertex.position = Vec3(x * 0.01f, y * 0.01f, 0.0f);
+        vertex.uv = Vec2(x / float(kGridSize), y / float(kGridSize));
+        vertex.color = Vec4(1.0f);
+        return vertex;
+    };
+
+    std::vector<Vertex> corners;
+    corners.reserve((kGridSize - 1) * (kGridSize - 1) * 6);
+    for (size_t y = 0; y + 1 < kGridSize; ++y) {
+        for (size_t x = 0; x + 1 < kGridSize; ++x) {
+            corners.push_back(makeVertex(x, y));
+            corners.push_back(makeVertex(x + 1, y));
+            corners.push_back(makeVertex(x, y + 1));
+            corners.push_back(makeVertex(x + 1, y));
+            corners.push_back(makeVertex(x + 1, y + 1));
+            corners.push_back(makeVertex(x, y + 1));
+        }
+    }
+    return corners;
+}
+
+TEST(WeldBench, LookupsPerSecond) {
+    const std::vector<Vertex> corners = makeCorners();
+
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    indices.reserve(corners.size());
+
+    // Before: unordered_map, hashing twice per corner
+    auto begin = std::chrono::steady_clock::now();
+    {
+        std::unordered_map<Vertex, uint32_t, LegacyVertexHash> unique_vertices{};
+        for (const auto& vertex : corners) {
+            if (unique_vertices.count(vertex) == 0) {
+                unique_vertices[vertex] = static_cast<uint32_t>(vertices.size());
+                vertices.push_back(vertex);
+            }
+            indices.push_back(unique_vertices[vertex]);
+        }
+    }
+    const double map_sec = elapsedSec(begin);
+    const size_t map_unique = vertices.size();
+    const std::vector<uint32_t> map_indices = indices;
+
+    vertices.clear();
+    indices.clear();
+    begin = std::chrono::steady_clock::now();
+    {
+        VertexWeldTable table(kGridSize * kGridSize);
+        for (const auto& vertex : corners) {
+            indices.push_back(table.weld(vertex, vertices));
+        }
+    }
+    const double table_sec = elapsedSec(begin);
+    EXPECT_EQ(vertices.size(), map_unique);
+    EXPECT_EQ(indices, map_indices);
+
+    const double map_rate = corners.size() / map_sec;
+    const double table_rate = corners.size() / table_sec;
+    std::cout << corners.size() << " lookups, " << map_unique << " unique vertices" << std::endl;
+    std::cout << "[unordered_map]   " << map_rate << " lookups/s" << std::endl;
+    std::cout << "[VertexWeldTable] " << table_rate << " lookups/s (x" << table_rate / map_rate << ")" << std::endl;
+}
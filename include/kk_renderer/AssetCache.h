@@ -0,0 +1,90 @@
+#pragma once
+
+#include "Geometry.h"
+#include "Texture.h"
+#include "Shader.h"
+#include <vulkan/vulkan.h>
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace kk {
+    namespace renderer {
+        struct RenderingContext;
+
+        // Registry of loaded assets, so that an asset file is created once however many times it is requested.
+        // Assets are keyed by content hash of the file (and creation flags), so that files of identical content
+        // at different paths share one asset too. Paths are remembered with their file stamp, so that unchanged files are not hashed again.
+        //
+        // Returned assets are shared. Assets no longer referenced outside the cache are kept until the memory budget is exceeded,
+        // then destroyed in least recently used order.
+        // NOTE: Not thread-safe. Use from the render thread.
+        class AssetCache {
+        public:
+            static constexpr VkDeviceSize kDefaultBudget = 256 * 1024 * 1024;
+
+            struct Stats {
+                size_t hit_count, miss_count;
+                size_t eviction_count;
+                size_t entry_count;
+                VkDeviceSize memory_used; // GPU memory of cached assets, referenced or not
+            };
+
+            explicit AssetCache(VkDeviceSize budget = kDefaultBudget);
+
+            AssetCache(const AssetCache&) = delete;
+            AssetCache& operator=(const AssetCache&) = delete;
+
+            // Cached counterparts of Texture::create(), Shader::create() and Geometry::create() from file.
+            // Throw std::runtime_error if the file cannot be read.
+            std::shared_ptr<Texture> getTexture(RenderingContext& ctx, const std::string& path, uint32_t flags = 0);
+            std::shared_ptr<Shader> getShader(RenderingContext& ctx, const std::string& path);
+            std::shared_ptr<Geometry> getGeometry(RenderingContext& ctx, const std::string& path, uint32_t flags = 0);
+
+            // Destroys unreferenced assets in least recently used order, until memory used fits in budget.
+            // Called by every get after a miss.
+            void trim(RenderingContext& ctx);
+            // Destroys every cached asset
+            // NOTE: Assets still referenced outside are destroyed too, so call this once they are no longer used
+            void destroy(RenderingContext& ctx);
+
+            inline void setBudget(VkDeviceSize budget) { budget_ = budget; }
+            inline VkDeviceSize getBudget() const { return budget_; }
+            inline const Stats& getStats() const { return stats_; }
+
+        private:
+            struct Entry {
+                std::string key;
+                std::shared_ptr<void> asset;
+                // NOTE: Takes the asset, so that only `asset` refers to it and use count tells outside references
+                std::function<void(RenderingContext&, const std::shared_ptr<void>&)> destroy;
+                VkDeviceSize size;
+            };
+
+            struct PathInfo {
+                std::string key;
+                uint64_t file_size;
+                int64_t file_mtime;
+            };
+
+            // Returns cached asset of `path` loaded by `load` (which sets size and destroy of the entry), or loads it.
+            // `type` and `flags` separate assets created from the same file differently.
+            std::shared_ptr<void> get(
+                RenderingContext& ctx,
+                const std::string& path,
+                char type,
+                uint32_t flags,
+                const std::function<void(Entry&)>& load
+            );
+            std::string getContentKey(const std::string& path, char type, uint32_t flags);
+
+            VkDeviceSize budget_;
+            Stats stats_;
+            std::list<Entry> entries_; // Most recently used first
+            std::unordered_map<std::string, std::list<Entry>::iterator> entry_map_;
+            std::unordered_map<std::string, PathInfo> paths_; // Of type, flags and path
+        };
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "Geometry.h"
+#include "Texture.h"
+#include "Shader.h"
+#include "ThreadPool.h"
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace kk {
+    namespace renderer {
+        struct RenderingContext;
+
+        // Asset being loaded by AssetLoader.
+        // `asset` is a placeholder (is_pending == true) until AssetLoader::update() creates it, and can be given to
+        // Renderable or Material right away. Renderer skips renderables using assets not ready.
+        template <class T>
+        struct AssetHandle {
+            std::shared_ptr<T> asset;
+            std::shared_future<void> loaded; // Ready once `asset` is created. Rethrows the exception if loading failed.
+
+            // NOTE: `asset` is written by AssetLoader::update(), so read it on the same thread
+            inline bool isReady() const { return asset != nullptr && !asset->is_pending; }
+        };
+
+        // Loads assets in background. File I/O, decoding and mesh processing run on worker threads,
+        // then update() creates GPU objects on the render thread, whose uploads go through RenderingContext::transfer.
+        // NOTE: Not thread-safe. Request and update from the render thread.
+        class AssetLoader {
+        public:
+            explicit AssetLoader(size_t thread_count);
+
+            AssetLoader(const AssetLoader&) = delete;
+            AssetLoader& operator=(const AssetLoader&) = delete;
+
+            // See Geometry::create(). Flags are applied on the worker (e.g. kGeometryOptimize), except upload.
+            AssetHandle<Geometry> loadGeometryAsync(const std::string& path, uint32_t flags = 0);
+            AssetHandle<Texture> loadTextureAsync(const std::string& path);
+            AssetHandle<Shader> loadShaderAsync(const std::string& path);
+
+            // Creates assets decoded since last call. Returns number of assets finished (created or failed).
+            // Call once per frame between beginFrame() and endFrame(), so that uploads are flushed with the frame.
+            size_t update(RenderingContext& ctx);
+            // Blocks until every requested asset is finished, then creates them
+            void wait(RenderingContext& ctx);
+
+            inline size_t getPendingCount() const { return pending_.size(); }
+
+        private:
+            // Finishes an asset if its data is decoded (or always if `is_blocking`). Returns true if finished.
+            using Finisher = std::function<bool(RenderingContext& ctx, bool is_blocking)>;
+
+            template <class T, class Data, class Load, class Create>
+            AssetHandle<T> enqueue(Load load, Create create);
+
+            std::shared_ptr<ThreadPool> workers_;
+            std::vector<Finisher> pending_; // In request order
+        };
+    }
+}
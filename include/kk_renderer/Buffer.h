@@ -10,11 +10,13 @@ namespace kk {
             static Buffer create(RenderingContext& ctx, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags mem_props);
             void destroy(RenderingContext& ctx);
             void setData(RenderingContext& ctx, const void* src, size_t src_size);
+            // Copies are recorded into transfer batch after pending uploads, and submitted with its next flush.
+            // NOTE: `dst` texture must be in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
             void copyTo(RenderingContext& ctx, Buffer& dst, VkDeviceSize copy_size) const;
             void copyTo(RenderingContext& ctx, Texture& dst, VkExtent2D copy_extent) const;
 
             VkBuffer buffer;
-            VkDeviceMemory memory;
+            Allocation allocation;
             VkDeviceSize size;
             VkBufferUsageFlags usage;
             VkMemoryPropertyFlags memory_props;
@@ -2,6 +2,7 @@
 
 #include "Transform.h"
 #include "Mat4.h"
+#include <glm/gtc/matrix_transform.hpp>
 
 namespace kk {
     namespace renderer {
@@ -10,6 +11,14 @@ namespace kk {
 
             Transform transform;
             virtual Mat4 getProjection() const = 0;
+
+            inline Mat4 getView() const {
+                return glm::lookAt(
+                    transform.position,
+                    transform.position + transform.rotation * Vec3(0.0f, 0.0f, 1.0f),
+                    Vec3(0.0f, -1.0f, 0.0f)
+                );
+            }
         };
     }
 }
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <functional>
+#include <deque>
+#include <vector>
+
+namespace kk {
+    namespace renderer {
+        struct RenderingContext;
+
+        // Defers destruction of GPU objects until every frame that may refer to them has completed.
+        // Each deleter is tagged with the serial of the frame being recorded, and runs once
+        // the fence in RenderingContext::fences of that frame (or a later one) has signaled.
+        class DeletionQueue {
+        public:
+            using Deleter = std::function<void(RenderingContext&)>;
+
+            static DeletionQueue create(size_t frame_count);
+
+            void push(const Deleter& deleter);
+
+            // Frame owner must call this right after submitting a frame with the fence of `frame`.
+            void onSubmit(size_t frame);
+
+            // Runs deleters whose frames have completed. Never blocks.
+            void collect(RenderingContext& ctx);
+
+            // Runs every deleter. GPU must be idle.
+            void flush(RenderingContext& ctx);
+
+            inline size_t getPendingCount() const { return entries_.size(); }
+
+        private:
+            struct Entry {
+                uint64_t serial;
+                Deleter deleter;
+            };
+
+            std::deque<Entry> entries_;
+            uint64_t frame_serial_; // Serial of the frame being recorded
+            std::vector<uint64_t> fence_serials_; // Serial last submitted with each fence
+        };
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "Vec3.h"
+#include "Vec4.h"
+#include "Mat4.h"
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace kk {
+    namespace renderer {
+        // Bounding spheres and normal cones of triangle clusters in structure-of-arrays form (see Meshlet)
+        struct ClusterBounds {
+            std::vector<float> x, y, z, radius;
+            std::vector<float> axis_x, axis_y, axis_z, cutoff;
+
+            inline size_t size() const { return radius.size(); }
+        };
+
+        struct Frustum {
+            // Normalized planes (xyz: normal toward inside, w: distance). Point p is inside if dot(xyz, p) + w >= 0.
+            // Order: left, right, bottom, top, near, far
+            std::array<Vec4, 6> planes;
+
+            // Extracts planes from view-projection matrix (Gribb-Hartmann)
+            static Frustum create(const Mat4& view_proj);
+
+            bool intersects(const Vec3& center, float radius) const;
+
+            // Tests spheres given in structure-of-arrays form, 4 spheres per SIMD iteration.
+            // Sets visible[i] to 1 if sphere i intersects the frustum, 0 otherwise. Returns the number of visible spheres.
+            size_t cullSpheres(const float* xs, const float* ys, const float* zs, const float* radii, size_t count, uint8_t* visible) const;
+
+            // Tests clusters as cullSpheres(), and also culls clusters whose every triangle faces away from `eye`.
+            // `facing` is 1 if front faces are those whose normal (p1 - p0) x (p2 - p0) points to the viewer, -1 if opposite,
+            // and 0 to test spheres only.
+            // NOTE: Planes, `eye` and bounds must be in the same space (e.g. object space with frustum of MVP)
+            size_t cullClusters(const ClusterBounds& clusters, const Vec3& eye, float facing, uint8_t* visible) const;
+        };
+    }
+}
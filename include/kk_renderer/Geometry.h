@@ -3,25 +3,133 @@
 #include "RenderingContext.h"
 #include "Vertex.h"
 #include "Buffer.h"
+#include "MeshOptimizer.h"
+#include "GeometryPool.h"
 #include <vector>
 #include <string>
+#include <memory>
 
 namespace kk {
     namespace renderer {
-        struct Geometry {
+        // Bounding volumes in local space
+        struct Bounds {
+            Vec3 min, max; // AABB
+            Vec3 center;   // Bounding sphere
+            float radius;
+
+            static Bounds create(const std::vector<Vertex>& vertices);
+        };
+
+        enum GeometryFlagBits : uint32_t {
+            // Reorders triangles and vertices for post-transform cache, overdraw and vertex fetch (see MeshOptimizer.h)
+            kGeometryOptimize = 1 << 0,
+            // Uploads PackedVertex instead of Vertex (VertexFormat::kPacked or kPackedConstantColor if every vertex has the same color)
+            kGeometryPackVertices = 1 << 1,
+            // Appends simplified LODs to indices (LodSettings::getDefault() unless settings are given, see generateLods())
+            kGeometryGenerateLods = 1 << 2,
+            // Partitions LOD 0 into meshlets, which Renderer culls individually (see buildMeshlets())
+            kGeometryBuildMeshlets = 1 << 3,
+            // Sub-allocates GPU data from RenderingContext::geometry_pool instead of own buffers.
+            // Falls back to own buffers if the pool is full.
+            kGeometryPooled = 1 << 4,
+            // Frees vertices and indices after upload. Counts, bounds, LODs and meshlets are kept for drawing and culling.
+            kGeometryDropCpuData = 1 << 5,
+        };
+
+        // CPU content of a geometry. Loading and processing need no RenderingContext, so they can run on any thread
+        // (see AssetLoader), leaving only upload by Geometry::create() to the render thread.
+        struct GeometryData {
             std::vector<Vertex> vertices;
+            std::vector<uint32_t> indices; // LOD 0, followed by coarser LODs if any
+            std::vector<MeshLod> lods;
+            std::vector<Meshlet> meshlets;
+            Bounds bounds;
+            uint32_t flags;
+
+            // Loads OBJ at `path` and applies processing requested by `flags`
+            static GeometryData load(const std::string& path, uint32_t flags = 0);
+            // Applies processing requested by `flags` (e.g. kGeometryOptimize) in place, taking over `vertices` and `indices`
+            static GeometryData create(
+                std::vector<Vertex>&& vertices,
+                std::vector<uint32_t>&& indices,
+                uint32_t flags,
+                const LodSettings& lod_settings
+            );
+        };
+
+        struct Geometry {
+            std::vector<Vertex> vertices;  // Empty if kGeometryDropCpuData
             Buffer vertex_buffer;
-            std::vector<uint32_t> indices;
+            std::vector<uint32_t> indices; // LOD 0, followed by coarser LODs if any. Empty if kGeometryDropCpuData.
             Buffer index_buffer;
+            size_t vertex_count, index_count; // Of uploaded data, valid regardless of kGeometryDropCpuData
+            std::vector<MeshLod> lods;     // lods[0] is the full mesh
+            std::vector<Meshlet> meshlets; // Clusters of LOD 0, empty unless kGeometryBuildMeshlets
+            ClusterBounds meshlet_bounds;  // Bounds of meshlets, for Frustum::cullClusters()
+            uint32_t id;
+            Bounds bounds;
+            uint32_t flags; // GeometryFlagBits given at creation
+
+            // Layout of GPU buffers. `vertices` and `indices` are kept in Vertex and uint32_t regardless.
+            VertexFormat vertex_format;
+            VkDeviceSize color_offset; // Color stream in vertex_buffer (packed formats)
+            Mat4 dequantize;           // Maps packed position [0, 1] to local space. Identity for VertexFormat::kFloat.
+            VkIndexType index_type;    // VK_INDEX_TYPE_UINT16 if every index fits
+
+            // Pool the data lives in, or nullptr if vertex_buffer and index_buffer are owned.
+            // NOTE: Buffers of pooled geometry are those of the pool. Draws add getPoolRange() offsets.
+            std::shared_ptr<GeometryPool> pool;
+            GeometryPool::Handle pool_handle;
 
-            static Geometry create(RenderingContext& ctx, const std::string& path);
+            // True while this is a placeholder of AssetLoader, whose content is not loaded yet. Renderer skips it.
+            bool is_pending;
+
+            static Geometry create(RenderingContext& ctx, const std::string& path, uint32_t flags = 0);
+            // Uploads `data` with flags of it, taking over its vertices and indices
+            static Geometry create(RenderingContext& ctx, GeometryData&& data);
+            // Loads OBJ at `path` through binary cache at `cache_path` (.kkmesh).
+            // If the cache is missing, stale, of another format version or written with other flags, loads the OBJ and rewrites the cache.
+            static Geometry create(RenderingContext& ctx, const std::string& path, const std::string& cache_path, uint32_t flags = 0);
 
             static Geometry create(
                 RenderingContext& ctx,
                 const std::vector<Vertex>& vertices,
-                const std::vector<uint32_t> indices
+                const std::vector<uint32_t>& indices,
+                uint32_t flags = 0
+            );
+            // Takes over `vertices` and `indices` without copy. Processing (e.g. kGeometryOptimize) is done in place.
+            static Geometry create(
+                RenderingContext& ctx,
+                std::vector<Vertex>&& vertices,
+                std::vector<uint32_t>&& indices,
+                uint32_t flags = 0
+            );
+            // Generates LODs with `lod_settings`, regardless of kGeometryGenerateLods
+            static Geometry create(
+                RenderingContext& ctx,
+                const std::vector<Vertex>& vertices,
+                const std::vector<uint32_t>& indices,
+                const LodSettings& lod_settings,
+                uint32_t flags = 0
+            );
+            static Geometry create(
+                RenderingContext& ctx,
+                std::vector<Vertex>&& vertices,
+                std::vector<uint32_t>&& indices,
+                const LodSettings& lod_settings,
+                uint32_t flags = 0
             );
             void destroy(RenderingContext& ctx);
+
+            // Offsets of the data in pool buffers (zero if not pooled). Changes on GeometryPool::compact().
+            inline GeometryPool::Range getPoolRange() const {
+                return (pool != nullptr) ? pool->getRange(pool_handle) : GeometryPool::Range{};
+            }
+
+            // Writes vertices, indices, LODs, meshlets and bounds to `cache_path` in .kkmesh format,
+            // stamped with size and modification time of `source_path`. Returns false on failure.
+            // NOTE: Fails for geometry created with kGeometryDropCpuData
+            bool writeCache(const std::string& cache_path, const std::string& source_path) const;
         };
     }
 }
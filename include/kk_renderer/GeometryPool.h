@@ -0,0 +1,86 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <cstdint>
+#include "Buffer.h"
+#include "Tlsf.h"
+
+namespace kk {
+    namespace renderer {
+        struct RenderingContext;
+
+        // Sub-allocates vertex and index data of many geometries from one vertex buffer and one index buffer,
+        // so that draws of pooled geometries share bound buffers and differ only in firstIndex / vertexOffset.
+        // Ranges are managed by TLSF. Capacity is fixed at creation.
+        class GeometryPool {
+        public:
+            using Handle = uint32_t;
+            static constexpr Handle kInvalidHandle = UINT32_MAX;
+            static constexpr VkDeviceSize kDefaultVertexSize = 64 * 1024 * 1024;
+            static constexpr VkDeviceSize kDefaultIndexSize = 32 * 1024 * 1024;
+
+            // Location of a geometry in the pool buffers
+            struct Range {
+                int32_t base_vertex;         // vertexOffset of vkCmdDrawIndexed
+                uint32_t first_index;        // Added to firstIndex of vkCmdDrawIndexed
+                VkDeviceSize vertex_offset;  // Byte offset of vertex data (== base_vertex * vertex stride)
+                VkDeviceSize vertex_size;
+                VkDeviceSize index_size;
+                VkIndexType index_type;
+            };
+
+            struct Stats {
+                uint32_t allocation_count;
+                VkDeviceSize vertex_capacity, vertex_used, vertex_largest_free;
+                VkDeviceSize index_capacity, index_used, index_largest_free;
+            };
+
+            static GeometryPool create(RenderingContext& ctx, VkDeviceSize vertex_size, VkDeviceSize index_size);
+            void destroy(RenderingContext& ctx);
+
+            // Copies vertex data (elements of `vertex_stride` byte) and index data into the pool, through transfer batch.
+            // Returns kInvalidHandle if either buffer has no space.
+            // NOTE: Trailing bytes of vertex data after the vertices (e.g. color stream of packed formats) are kept as is
+            Handle allocate(
+                RenderingContext& ctx,
+                const void* vertex_data,
+                VkDeviceSize vertex_size,
+                VkDeviceSize vertex_stride,
+                const void* index_data,
+                VkDeviceSize index_size,
+                VkIndexType index_type
+            );
+            // Releases ranges of `handle` once frames in flight are done with them (see DeletionQueue)
+            void free(RenderingContext& ctx, Handle handle);
+
+            // Moves every live range to the front of its buffer, so that freed space is one contiguous range.
+            // Ranges (and firstIndex / vertexOffset) of handles change, handles stay valid.
+            // NOTE: Blocks until done. GPU must not be reading the pool, e.g. call after vkDeviceWaitIdle().
+            void compact(RenderingContext& ctx);
+
+            inline const Range& getRange(Handle handle) const { return entries_[handle].range; }
+            inline const Buffer& getVertexBuffer() const { return vertex_buffer_; }
+            inline const Buffer& getIndexBuffer() const { return index_buffer_; }
+            Stats getStats() const;
+
+        private:
+            struct Entry {
+                Range range;
+                uint32_t vertex_node, index_node;
+                VkDeviceSize vertex_stride;
+                bool is_used;
+            };
+
+            static VkDeviceSize getIndexSize(VkIndexType index_type);
+            // Allocates ranges of `entry` sized by its current range
+            bool allocateRanges(Entry& entry);
+            void release(Handle handle);
+
+            Buffer vertex_buffer_, index_buffer_;
+            Tlsf vertex_space_, index_space_;
+            std::vector<Entry> entries_;
+            std::vector<Handle> free_handles_;
+        };
+    }
+}
@@ -19,7 +19,7 @@ namespace kk {
             void destroy(RenderingContext& ctx);
 
             VkImage image;
-            VkDeviceMemory memory;
+            Allocation allocation;
             VkImageView view;
 
             uint32_t width;
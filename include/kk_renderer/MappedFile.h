@@ -0,0 +1,26 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+namespace kk {
+    namespace renderer {
+        // Read-only memory mapping of a whole file.
+        struct MappedFile {
+            // Throws std::runtime_error if `path` cannot be opened or mapped
+            static MappedFile create(const std::string& path);
+            void destroy();
+
+            const char* data;
+            size_t size;
+
+        private:
+            void* handle_;  // File handle. Unused on POSIX.
+            void* mapping_; // File mapping handle. Unused on POSIX.
+        };
+
+        // Size and modification time of `path`, to detect stale caches. Returns false if it does not exist.
+        bool getFileStamp(const std::string& path, uint64_t& size, int64_t& mtime);
+    }
+}
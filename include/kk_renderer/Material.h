@@ -1,10 +1,12 @@
 #pragma once
 
 #include <memory>
+#include <array>
 #include "RenderingContext.h"
 #include "Texture.h"
 #include "Buffer.h"
 #include "Shader.h"
+#include "Vertex.h"
 
 namespace kk {
     namespace renderer{
@@ -22,6 +24,18 @@ namespace kk {
                 frag_ = frag;
             }
 
+            // Vertex shader taking MVP from per-instance input (InstanceData) instead of uniform.
+            // If set, Renderer merges draws sharing this material and a geometry into one instanced draw.
+            inline void setInstancedVertexShader(const std::shared_ptr<Shader>& vert) {
+                vert_instanced_ = vert;
+            }
+
+            // Vertex buffer layout whose pipelines are built by compile(). Default is VertexFormat::kFloat.
+            // Pipelines of other layouts are built when a geometry in them (Geometry::vertex_format) is first drawn.
+            inline void setVertexFormat(VertexFormat format) {
+                vertex_format_ = format;
+            }
+
             inline void setTexture(const std::shared_ptr<Texture>& texture) {
                 texture_ = texture;
                 // TODO: set dirty flag true
@@ -37,23 +51,45 @@ namespace kk {
             }
 
             void compile(RenderingContext& ctx, VkRenderPass render_pass);
+            // Builds pipelines of `format` if not built yet. Material must be compiled.
+            void preparePipelines(RenderingContext& ctx, VertexFormat format);
 
             inline bool isCompiled() const { return is_compiled_; }
-            inline VkPipeline getPipeline() const { return pipeline_; }
+            // False while the texture or a shader is a placeholder of AssetLoader. Renderer skips materials not ready.
+            inline bool isReady() const {
+                return
+                    (texture_ == nullptr || !texture_->is_pending) &&
+                    (vert_ == nullptr || !vert_->is_pending) &&
+                    (frag_ == nullptr || !frag_->is_pending) &&
+                    (vert_instanced_ == nullptr || !vert_instanced_->is_pending);
+            }
+            // VK_NULL_HANDLE until preparePipelines() of `format`
+            inline VkPipeline getPipeline(VertexFormat format) const { return pipelines_[static_cast<size_t>(format)]; }
+            // VK_NULL_HANDLE if no instanced vertex shader is set
+            inline VkPipeline getInstancedPipeline(VertexFormat format) const { return instanced_pipelines_[static_cast<size_t>(format)]; }
             inline VkPipelineLayout getPipelineLayout() const { return pipeline_layout_; }
             inline const std::vector<VkDescriptorSetLayout>& getDescriptorSetLayouts() const { return desc_layouts_; }
+            // Descriptor set 0 (texture), shared by every renderable of this material
+            inline VkDescriptorSet getDescriptorSet() const { return desc_set_; }
+            inline uint32_t getId() const { return id_; }
+            inline VertexFormat getVertexFormat() const { return vertex_format_; }
+            inline VkFrontFace getFrontFace() const { return rasterizer_.frontFace; }
+            inline VkCullModeFlags getCullMode() const { return rasterizer_.cullMode; }
 
         private:
             void setDefault();
             void buildDescLayout(RenderingContext& ctx);
             void buildPipelineLayout(RenderingContext& ctx, const std::vector<VkDescriptorSetLayout>& desc_layouts);
-            void buildPipeline(RenderingContext& ctx, VkPipelineLayout layout, VkRenderPass render_pass);
+            VkPipeline buildPipeline(RenderingContext& ctx, VertexFormat format, const Shader& vert, bool is_instanced);
+            void buildDescSet(RenderingContext& ctx);
 
+            uint32_t id_;
             bool is_compiled_;
 
             std::shared_ptr<Texture> texture_;
 
-            std::shared_ptr<Shader> vert_, frag_;
+            std::shared_ptr<Shader> vert_, frag_, vert_instanced_;
+            VertexFormat vertex_format_;
             VkPipelineInputAssemblyStateCreateInfo input_asm_;
             VkPipelineViewportStateCreateInfo viewport_;
             VkPipelineRasterizationStateCreateInfo rasterizer_;
@@ -64,9 +100,13 @@ namespace kk {
             std::vector<VkDynamicState> dynamic_states_;
 
             std::vector<VkDescriptorSetLayout> desc_layouts_;
+            VkDescriptorSet desc_set_;
 
             VkPipelineLayout pipeline_layout_;
-            VkPipeline pipeline_;
+            VkRenderPass render_pass_; // Of compile(), for pipelines built later
+            // Indexed by VertexFormat
+            std::array<VkPipeline, kVertexFormatCount> pipelines_;
+            std::array<VkPipeline, kVertexFormatCount> instanced_pipelines_;
         };
     }
 }
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <array>
+#include "Tlsf.h"
+
+namespace kk {
+    namespace renderer {
+        struct Allocation {
+            VkDeviceMemory memory;
+            VkDeviceSize offset;
+            VkDeviceSize size;
+            void* mapped; // Persistently mapped pointer to offset, nullptr if not host visible
+            uint32_t pool;
+            uint32_t block; // kDedicatedBlock if memory is owned by this allocation only
+            uint32_t node;
+        };
+
+        // Sub-allocates VkDeviceMemory blocks per memory type with TLSF.
+        // Linear resources (buffers) and optimal images live in separated pools,
+        // so that bufferImageGranularity conflicts can't happen inside a block.
+        class MemoryAllocator {
+        public:
+            static constexpr uint32_t kDedicatedBlock = UINT32_MAX;
+            static constexpr VkDeviceSize kDefaultBlockSize = 64 * 1024 * 1024;
+
+            struct Stats {
+                uint32_t block_count;
+                uint32_t allocation_count;
+                uint32_t dedicated_count;
+                VkDeviceSize reserved_size; // Total size of VkDeviceMemory allocated from driver
+                VkDeviceSize used_size;
+                VkDeviceSize largest_free_range;
+                float fragmentation; // 1 - (largest free range / total free size)
+            };
+
+            static MemoryAllocator create(VkPhysicalDevice gpu, VkDevice device);
+            void destroy();
+
+            Allocation allocate(const VkMemoryRequirements& reqs, VkMemoryPropertyFlags props, bool is_linear);
+            void free(const Allocation& allocation);
+
+            Stats getStats() const;
+
+        private:
+            struct Block {
+                VkDeviceMemory memory;
+                void* mapped;
+                Tlsf tlsf;
+            };
+
+            struct Pool {
+                uint32_t memory_type;
+                VkDeviceSize block_size;
+                std::vector<Block> blocks;
+            };
+
+            uint32_t findMemoryType(uint32_t type_filter, VkMemoryPropertyFlags props) const;
+            VkDeviceMemory allocateMemory(VkDeviceSize size, uint32_t memory_type, void** mapped);
+
+            VkDevice device_;
+            VkPhysicalDeviceMemoryProperties mem_props_;
+            VkDeviceSize granularity_;
+            // Index: memory type * 2 + (0: linear, 1: optimal)
+            std::array<Pool, VK_MAX_MEMORY_TYPES * 2> pools_;
+            uint32_t dedicated_count_;
+            VkDeviceSize dedicated_size_;
+        };
+    }
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "Vertex.h"
+#include "Frustum.h"
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace kk {
+    namespace renderer {
+        // Post-transform cache efficiency of a triangle list, simulated with a FIFO cache
+        struct VertexCacheStats {
+            float acmr; // Average cache miss ratio: transformed vertices per triangle (0.5 to 3)
+            float atvr; // Average transform to vertex ratio: transformed vertices per referenced vertex (1 is optimal)
+        };
+
+        static constexpr size_t kDefaultVertexCacheSize = 16;
+
+        VertexCacheStats analyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertex_count, size_t cache_size = kDefaultVertexCacheSize);
+
+        // Reorders triangles for post-transform cache locality (Tipsify, Sander et al. 2007). Winding is preserved.
+        void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertex_count, size_t cache_size = kDefaultVertexCacheSize);
+
+        // Reorders clusters of cache-optimised triangles so that outward facing ones are drawn first, reducing overdraw.
+        // Clusters are cut where the cache restarts, so the cache efficiency of optimizeVertexCache() is mostly kept.
+        void optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, size_t cache_size = kDefaultVertexCacheSize);
+
+        // Reorders vertices by first use in `indices` for vertex fetch locality, and remaps `indices`.
+        // Vertices not referenced are removed.
+        void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+        // All of the above in order
+        void optimizeMesh(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+        // Simplifies triangles [indices, indices + index_count) by edge collapse ordered by quadric error (Garland and Heckbert 1997),
+        // until `target_index_count` is reached or the next collapse deviates more than `target_error` (object space distance).
+        // Vertices are only removed, never moved, so `dst` indexes the same `vertices`.
+        // Mesh borders and UV seams are kept by collapsing only along them. Returns `dst.size()`.
+        size_t simplifyMesh(
+            const std::vector<Vertex>& vertices,
+            const uint32_t* indices,
+            size_t index_count,
+            size_t target_index_count,
+            float target_error,
+            std::vector<uint32_t>& dst,
+            float* result_error = nullptr
+        );
+
+        // Index range of a level of detail
+        struct MeshLod {
+            uint32_t first_index;
+            uint32_t index_count;
+            float error; // Object space deviation from LOD 0
+        };
+
+        struct LodSettings {
+            std::vector<float> ratios; // Target index count of each LOD relative to LOD 0, in decreasing order
+            float max_error;           // Deviation bound relative to mesh radius. The chain ends when it is reached.
+
+            static LodSettings getDefault();
+        };
+
+        // Appends simplified LODs of `indices` (LOD 0) to `indices`, each simplified from the previous one and cache optimised.
+        // `lods` receives LOD 0 and every LOD generated. LODs barely smaller than the previous one are dropped.
+        void generateLods(const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, const LodSettings& settings, std::vector<MeshLod>& lods);
+
+        static constexpr size_t kMaxMeshletVertices = 64;
+        static constexpr size_t kMaxMeshletTriangles = 124;
+
+        // Cluster of adjacent triangles, a contiguous range of the index buffer
+        struct Meshlet {
+            uint32_t first_index;
+            uint32_t index_count;
+            Vec3 center;       // Bounding sphere
+            float radius;
+            Vec3 cone_axis;    // Normal cone. Cluster faces away from eye e if dot(center - e, cone_axis) >= cone_cutoff * |center - e| + radius.
+            float cone_cutoff; // 1 if normals spread too much to ever face away
+        };
+
+        // Partitions triangles into meshlets of at most `max_vertices` vertices and `max_triangles` triangles, grown over shared vertices.
+        // Triangles of `indices` are reordered so that each meshlet is contiguous. Order within a meshlet is kept.
+        void buildMeshlets(
+            const std::vector<Vertex>& vertices,
+            std::vector<uint32_t>& indices,
+            std::vector<Meshlet>& meshlets,
+            size_t max_vertices = kMaxMeshletVertices,
+            size_t max_triangles = kMaxMeshletTriangles
+        );
+
+        // Meshlet bounds in the form Frustum::cullClusters() takes
+        ClusterBounds getClusterBounds(const std::vector<Meshlet>& meshlets);
+    }
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "Vertex.h"
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace kk {
+    namespace renderer {
+        // Loads the OBJ at `path` as a triangle list of deduplicated vertices.
+        // The file is memory mapped and split into line aligned chunks, parsed by `thread_count` threads (hardware concurrency if 0).
+        // Only v, vt and f are read. Polygons are triangulated as fans. Negative (relative) indices are supported.
+        // Throws std::runtime_error if the file cannot be read or a face is malformed.
+        void loadObj(const std::string& path, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, size_t thread_count = 0);
+
+        // Parses a decimal float (e.g. "-1.25e-3") in [cur, end) after leading blanks, and advances `cur` past it.
+        // Returns 0 without advancing if no number is found.
+        float parseFloat(const char*& cur, const char* end);
+    }
+}
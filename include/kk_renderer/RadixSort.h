@@ -0,0 +1,18 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace kk {
+    namespace renderer {
+        struct SortItem {
+            uint64_t key;
+            uint32_t value;
+        };
+
+        // Stable LSD radix sort by `key` in ascending order.
+        // `tmp` is scratch storage, kept by caller to avoid reallocation every frame.
+        void radixSort(std::vector<SortItem>& items, std::vector<SortItem>& tmp);
+    }
+}
@@ -1,7 +1,6 @@
 #pragma once
 
 #include <vulkan/vulkan.h>
-#include <unordered_map>
 #include "RenderingContext.h"
 #include "Swapchain.h"
 #include "Geometry.h"
@@ -10,32 +9,184 @@
 #include "Camera.h"
 #include "ResourceDescriptor.h"
 #include "Image.h"
+#include "Buffer.h"
+#include "UniformAllocator.h"
+#include "RadixSort.h"
+#include "TransformStore.h"
+#include "Frustum.h"
+#include "ThreadPool.h"
 
 namespace kk {
     namespace renderer {
         class Renderer {
         public:
+            enum class SubmitMode {
+                kImmediate, // render() records draw commands at once
+                kDeferred,  // render() appends a draw packet. Packets are sorted and recorded at flush() or endFrame().
+                            // Draws sharing geometry and a material with instanced pipeline are merged into instanced draws.
+                kParallel   // Same as kDeferred, but the draw list is recorded into secondary command buffers by worker threads.
+                            // Requires enableParallelRecording().
+            };
+
+            struct FrameStats {
+                size_t visible_count, culled_count; // Renderables passed to render()
+                size_t draw_count;
+                size_t instanced_draw_count, instance_count;
+                size_t pipeline_binds, pipeline_binds_saved;
+                size_t desc_set_binds, desc_set_binds_saved; // Material set. Uniform set is rebound every draw for its dynamic offset.
+                size_t vertex_buffer_binds, vertex_buffer_binds_saved;
+                size_t index_buffer_binds, index_buffer_binds_saved;
+                size_t triangle_count; // Triangles of every draw and instance, after LOD selection
+                size_t cluster_count, cluster_culled_count; // Meshlets tested by render() with camera (see kGeometryBuildMeshlets)
+                size_t pending_count; // Renderables skipped since geometry or material is still loaded by AssetLoader
+            };
+
             static Renderer create(RenderingContext& ctx, Swapchain& swapchain);
+            // Renders into its own colour (RGBA8) and depth images instead of swapchain, so no window is required.
+            // Each frame in flight has its own colour image and host visible readback buffer,
+            // so frame N+1 is rendered while frame N is copied back.
+            static Renderer createOffscreen(RenderingContext& ctx, uint32_t width, uint32_t height);
             void destroy(RenderingContext& ctx);
 
             bool beginFrame(RenderingContext& ctx, Swapchain& swapchain);
             void endFrame(RenderingContext& ctx, Swapchain& swapchain);
+            // Offscreen counterparts. endFrame() records copy of the colour image into the readback buffer of the frame.
+            bool beginFrame(RenderingContext& ctx);
+            void endFrame(RenderingContext& ctx);
+
+            // Copies pixels (tightly packed RGBA8) of the oldest offscreen frame not read yet into `pixels`,
+            // and its index in submission order into `frame` if given.
+            // Returns false without blocking if that frame is still in flight, unless `wait` is true.
+            // NOTE: A frame not read until beginFrame() reuses its readback buffer is dropped.
+            bool readback(RenderingContext& ctx, std::vector<uint8_t>& pixels, bool wait = false, uint64_t* frame = nullptr);
+            inline bool isOffscreen() const { return is_offscreen_; }
+            // Geometry with meshlets drawn at LOD 0 is also culled per meshlet, against frustum and by normal cone,
+            // and only the ranges of visible meshlets are drawn (never instanced).
+            // NOTE: Camera must not be modified between beginFrame() and endFrame(), since view-projection is cached per frame
             void render(RenderingContext& ctx, Renderable& renderable, const Transform& transform, const Camera& camera);
+            // Draws with precomputed MVP (e.g. by TransformStore). Not frustum culled, and always drawn with LOD 0.
+            void render(RenderingContext& ctx, Renderable& renderable, const Mat4& mvp);
+
+            // render() with camera draws the coarsest LOD (Geometry::lods) whose error projects to at most `pixels` on screen.
+            // Default is 1 pixel.
+            inline void setLodThreshold(float pixels) { lod_threshold_ = pixels; }
+            inline float getLodThreshold() const { return lod_threshold_; }
+
+            // Records pending draw packets. Call before recording other commands into getCmdBuf() (e.g. editor).
+            void flush(RenderingContext& ctx);
 
+            // Builds pipelines of `material` ahead of its first draw.
+            // Does nothing while it uses assets still loading. Those are compiled on first draw after being loaded.
             void compileMaterial(RenderingContext& ctx, const std::shared_ptr<Material>& material);
 
+            // NOTE: Must be called outside of beginFrame() and endFrame()
+            void setSubmitMode(SubmitMode mode);
+            // Creates `thread_count` recording workers, each with a command pool per frame in flight, and switches to kParallel.
+            void enableParallelRecording(RenderingContext& ctx, size_t thread_count);
+            inline SubmitMode getSubmitMode() const { return mode_; }
+
+            // Counters of the frame being recorded, or the last frame after endFrame()
+            inline const FrameStats& getFrameStats() const { return stats_; }
+
             // FIXME: For editor initialization, render pass should be public.
             inline VkRenderPass getRenderPass() const {
                 return render_pass_;
             }
 
             // FIXME: For editor rendering, cmd buf should be public.
+            // NOTE: In kParallel mode, this is a secondary command buffer executed after every draw of the frame (overlay).
             inline VkCommandBuffer getCmdBuf() const {
-                return cmd_bufs_[current_frame_];
+                return (mode_ == SubmitMode::kParallel) ? overlay_bufs_[current_frame_] : cmd_bufs_[current_frame_];
             }
 
         private:
-            void prepareRendering(RenderingContext& ctx, Renderable& renderable);
+            // Index range of visible meshlets, adjacent ones merged
+            struct DrawRange {
+                uint32_t first_index;
+                uint32_t index_count;
+            };
+
+            struct DrawPacket {
+                Material* material;
+                Geometry* geometry;
+                Mat4 mvp;
+                uint32_t lod;
+                uint32_t first_range; // Ranges in ranges_ to draw instead of the whole LOD, if range_count > 0
+                uint32_t range_count;
+            };
+
+            // Draw prepared on the calling thread. Its uniform or instance data is already written.
+            struct DrawCommand {
+                const Material* material;
+                const Geometry* geometry;
+                uint32_t data_block;     // Block of the frame's UniformAllocator holding data
+                uint32_t data_offset;    // Dynamic uniform offset, or instance buffer offset if instanced
+                uint32_t instance_count; // 0 if not instanced
+                uint32_t lod;
+                uint32_t first_range;
+                uint32_t range_count;
+            };
+
+            // Bound state of the current command buffer, to skip redundant binds
+            struct BoundState {
+                VkPipeline pipeline;
+                VkDescriptorSet material_set;
+                VkBuffer vertex_buffer;
+                VkDeviceSize color_offset; // Color stream of packed formats, VK_WHOLE_SIZE if not bound
+                VkBuffer index_buffer;
+                VkIndexType index_type;
+            };
+
+            struct Recorder {
+                VkCommandBuffer cmd_buf;
+                BoundState bound;
+                FrameStats* stats;
+            };
+
+            // Command pool of a recording worker for a frame in flight
+            struct WorkerFrame {
+                VkCommandPool pool;
+                std::vector<VkCommandBuffer> cmd_bufs;
+                size_t used;
+            };
+
+            // Readback buffer of an offscreen frame in flight
+            struct Readback {
+                Buffer buffer;
+                VkMappedMemoryRange range; // Invalidated before reading, if size > 0 (memory is not coherent)
+                uint64_t frame;
+                bool is_pending;
+            };
+
+            static Renderer createBase(RenderingContext& ctx, VkFormat color_format, VkImageLayout color_final_layout, VkExtent2D extent);
+            // Waits for the frame in flight to be reused, then releases its per-frame resources
+            bool waitFrame(RenderingContext& ctx);
+            bool beginCommands(RenderingContext& ctx);
+            void endRenderPass(RenderingContext& ctx);
+            // `wait` and `signal` may be VK_NULL_HANDLE
+            bool submitFrame(RenderingContext& ctx, VkSemaphore wait, VkSemaphore signal);
+            void submit(RenderingContext& ctx, Renderable& renderable, const Mat4& mvp, uint32_t lod, uint32_t range_count = 0);
+            // Culls meshlets of `geometry` drawn with `model`, and appends index ranges of visible ones to ranges_.
+            // Returns the number of ranges appended.
+            uint32_t cullClusters(const Geometry& geometry, const Material& material, const Mat4& model, const Transform& transform, const Camera& camera);
+            // LOD of `geometry` for world space bounding sphere under current camera
+            uint32_t selectLod(const Geometry& geometry, const Vec3& center, float radius, float scale) const;
+            void pushCullSphere(const Vec3& center, float radius);
+            // Tests packets submitted since last call against current frustum
+            void cullPending();
+            DrawCommand prepareDraw(RenderingContext& ctx, const DrawPacket& packet);
+            // Prepares sorted packets [first, first + count) as one instanced draw
+            DrawCommand prepareInstancedDraw(RenderingContext& ctx, size_t first, uint32_t count);
+            // Allocates uniform or instance data of this frame. Creates uniform sets of new blocks.
+            void* allocateData(RenderingContext& ctx, VkDeviceSize size, uint32_t& block, uint32_t& offset);
+            // NOTE: Thread safe as long as each thread uses its own recorder
+            void recordDraws(Recorder& recorder, const DrawCommand* draws, size_t count) const;
+            void recordParallel();
+            VkCommandBuffer beginSecondary(WorkerFrame& worker_frame) const;
+            static void bindPipeline(Recorder& recorder, VkPipeline pipeline);
+            static void bindGeometry(Recorder& recorder, const Geometry& geometry);
+
+            VkDevice device_;
 
             VkRenderPass render_pass_;
             Image depth_;
@@ -44,8 +195,39 @@ namespace kk {
             std::array<VkCommandBuffer, kMaxConcurrentFrames> cmd_bufs_;
             size_t current_frame_;
             uint32_t img_idx_;
+            VkExtent2D extent_;
+
+            std::array<UniformAllocator, kMaxConcurrentFrames> uniforms_;
+            VkDescriptorSetLayout uniform_layout_;
+            std::array<std::vector<VkDescriptorSet>, kMaxConcurrentFrames> uniform_sets_; // One per uniform block
+
+            SubmitMode mode_;
+            std::vector<DrawPacket> packets_;
+            std::vector<SortItem> sort_items_, sort_tmp_;
+            std::vector<DrawCommand> draws_;
+            Recorder recorder_; // Records into primary command buffer
+            const Camera* view_proj_camera_;
+            Mat4 view_proj_;
+            Frustum frustum_;
+            float lod_threshold_;
+            float lod_pixel_scale_; // Pixels per unit length at unit view depth
+
+            // World space bounding spheres of draw packets in structure-of-arrays form
+            std::vector<float> cull_x_, cull_y_, cull_z_, cull_r_;
+            std::vector<uint8_t> visible_;
+            size_t culled_count_; // Number of packets already tested
+            std::vector<uint8_t> cluster_visible_;
+            std::vector<DrawRange> ranges_; // Meshlet ranges of pending draw packets
+            FrameStats stats_;
+
+            std::shared_ptr<ThreadPool> workers_;
+            std::vector<std::array<WorkerFrame, kMaxConcurrentFrames>> worker_frames_; // [worker][frame]
+            std::array<VkCommandBuffer, kMaxConcurrentFrames> overlay_bufs_;
 
-            std::unordered_map<size_t, std::array<Buffer, kMaxConcurrentFrames>> uniforms_;
+            bool is_offscreen_;
+            std::array<Image, kMaxConcurrentFrames> color_targets_;
+            std::array<Readback, kMaxConcurrentFrames> readbacks_;
+            uint64_t submitted_count_;
         };
     }
 }
@@ -4,10 +4,18 @@
 #include <vector>
 #include <array>
 #include <functional>
+#include <memory>
+#include "MemoryAllocator.h"
+#include "TransferBatcher.h"
+#include "DeletionQueue.h"
+#include "SamplerCache.h"
 
 namespace kk {
     namespace renderer {
         constexpr size_t kMaxConcurrentFrames = 2;
+        constexpr float kDefaultMaxAnisotropy = 16.0f;
+
+        class GeometryPool;
 
         struct RenderingContext {
             VkInstance instance;
@@ -21,10 +29,22 @@ namespace kk {
             std::array<VkFence, kMaxConcurrentFrames> fences;
             std::array<VkSemaphore, kMaxConcurrentFrames> render_complete;
             std::array<VkSemaphore, kMaxConcurrentFrames> present_complete;
+            MemoryAllocator allocator;
+            TransferBatcher transfer;
+            DeletionQueue deletion_queue;
+            SamplerCache sampler_cache;
+            // Optional. Geometry created with kGeometryPooled is sub-allocated from this pool. Destroyed with the context.
+            std::shared_ptr<GeometryPool> geometry_pool;
+            // Max anisotropy of samplers of textures created afterwards. 1 disables anisotropic filtering.
+            // Defaults to kDefaultMaxAnisotropy clamped to the device limit, or 1 if samplerAnisotropy is unsupported.
+            float max_anisotropy;
 
             static RenderingContext create();
+            // Context without window system integration, for offscreen rendering on machines without display.
+            // Validation layer is enabled only if available.
+            static RenderingContext createHeadless();
             void destroy();
-            VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags);
+            VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mip_levels = 1);
             uint32_t findMemoryType(uint32_t type_filter, VkMemoryPropertyFlags props);
             // VkCommandBuffer beginSingleTimeCommandBuffer();
             // void endSingleTimeCommandBuffer(VkCommandBuffer cmd);
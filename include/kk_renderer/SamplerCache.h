@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+
+namespace kk {
+    namespace renderer {
+        struct RenderingContext;
+
+        // Samplers shared by every user of identical settings, since devices allow few of them (maxSamplerAllocationCount).
+        // Samplers live until the cache is destroyed with RenderingContext, so that they can be referenced freely,
+        // e.g. as immutable samplers of descriptor set layouts.
+        class SamplerCache {
+        public:
+            static SamplerCache create();
+            // Destroys every sampler. GPU must be idle.
+            void destroy(RenderingContext& ctx);
+
+            // Returns the sampler of `info`, creating it on first request.
+            // NOTE: Extension structures (pNext) are not supported
+            VkSampler get(RenderingContext& ctx, const VkSamplerCreateInfo& info);
+
+            inline size_t getSamplerCount() const { return samplers_.size(); }
+
+        private:
+            // Fields of VkSamplerCreateInfo after sType / pNext, floats as bits
+            using Key = std::array<uint32_t, 15>;
+
+            struct KeyHash {
+                size_t operator()(const Key& key) const;
+            };
+
+            static Key makeKey(const VkSamplerCreateInfo& info);
+
+            std::unordered_map<Key, VkSampler, KeyHash> samplers_;
+        };
+    }
+}
@@ -3,16 +3,26 @@
 #include "RenderingContext.h"
 #include <unordered_map>
 #include <string>
+#include <vector>
 
 namespace kk {
     namespace renderer {
         struct Shader {
             static Shader create(RenderingContext& ctx, const std::string& path);
+            // Shader of SPIR-V `code`
+            static Shader create(RenderingContext& ctx, const std::vector<char>& code);
             void destroy(RenderingContext& ctx);
 
+            // Reads SPIR-V at `path`. Needs no RenderingContext, so it can run on any thread (see AssetLoader).
+            // Throws std::runtime_error on failure.
+            static std::vector<char> loadCode(const std::string& path);
+
             // Descriptor Set Index -> Layout Bindings
             std::unordered_map<size_t, std::vector<VkDescriptorSetLayoutBinding>> sets_bindings;
             VkShaderModule module;
+
+            // True while this is a placeholder of AssetLoader, whose content is not loaded yet
+            bool is_pending;
         };
     }
 }
@@ -2,13 +2,57 @@
 
 #include <vulkan/vulkan.h>
 #include <string>
+#include <vector>
 #include "RenderingContext.h"
 
 namespace kk {
     namespace renderer {
+        // Decoded texels of an image file. Decoding needs no RenderingContext, so it can run on any thread
+        // (see AssetLoader), leaving only upload by Texture::create() to the render thread.
+        struct TextureData {
+            // Mips start at a multiple of this in texels, satisfying bufferOffset of buffer to image copies
+            static constexpr VkDeviceSize kLevelAlignment = 16;
+
+            std::vector<uint8_t> texels;     // Mips in order, mip 0 first
+            std::vector<VkDeviceSize> level_offsets; // Byte offset of each mip in texels
+            size_t texel_byte;               // Per texel, or per 4x4 block of block-compressed formats
+            uint32_t width;
+            uint32_t height;
+            VkFormat format;
+
+            // Loads .ktx2 and .dds as is (see TextureLoader.h), otherwise decodes image at `path` into RGBA (mip 0 only).
+            // Throws std::runtime_error on failure.
+            static TextureData load(const std::string& path);
+
+            // Replaces mips after mip 0 with a full chain, each a 2x2 box filter of the previous one.
+            // CPU counterpart of blit, for formats that cannot be blitted.
+            // Returns false (and keeps data as is) if format is not of 8 bit channels.
+            bool generateMips();
+
+            inline uint32_t getMipLevels() const { return static_cast<uint32_t>(level_offsets.size()); }
+        };
+
+        enum TextureFlagBits : uint32_t {
+            // Creates mip 0 only. By default, sampled textures of optimal tiling get a full mip chain
+            // (given by TextureData, or generated on GPU, or on CPU if the format cannot be blitted).
+            kTextureNoMipmaps = 1 << 0,
+        };
+
         // TODO: Use kk::renderer::Image
         struct Texture {
-            static Texture create(RenderingContext& ctx, const std::string& path);
+            static Texture create(RenderingContext& ctx, const std::string& path, uint32_t flags = 0);
+            // Creates textures of `paths` in order. Images are decoded concurrently by `thread_count` threads
+            // (hardware concurrency if 0), and uploads of the whole batch are submitted at once by a transfer flush.
+            // Throws std::runtime_error if any image fails to load, destroying textures already created.
+            static std::vector<Texture> createBatch(
+                RenderingContext& ctx,
+                const std::vector<std::string>& paths,
+                uint32_t flags = 0,
+                size_t thread_count = 0
+            );
+            // Sampled texture of `data`. Mips of `data` are uploaded as is if it has more than one, or if it is block-compressed.
+            // Throws std::runtime_error if the device cannot sample block-compressed format of `data`.
+            static Texture create(RenderingContext& ctx, const TextureData& data, uint32_t flags = 0);
 
             static Texture create(
                 RenderingContext& ctx,
@@ -20,14 +64,18 @@ namespace kk {
                 VkImageTiling tiling,
                 VkImageUsageFlags usage,
                 VkMemoryPropertyFlags props,
-                VkImageAspectFlags aspect
+                VkImageAspectFlags aspect,
+                uint32_t flags = 0
             );
             void destroy(RenderingContext& ctx);
 
+            // Number of mips of a full chain down to 1x1
+            static uint32_t getMipLevels(uint32_t width, uint32_t height);
+
             VkImage image;
-            VkDeviceMemory memory;
+            Allocation allocation;
             VkImageView view;
-            VkSampler sampler;
+            VkSampler sampler; // Shared by textures of the same settings. Owned by RenderingContext::sampler_cache.
 
             uint32_t width;
             uint32_t height;
@@ -36,6 +84,10 @@ namespace kk {
             VkImageUsageFlags usage;
             VkMemoryPropertyFlags props;
             VkImageAspectFlags aspect;
+            uint32_t mip_levels;
+
+            // True while this is a placeholder of AssetLoader, whose content is not loaded yet
+            bool is_pending;
         };
     }
 }
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "Texture.h"
+#include <vulkan/vulkan.h>
+#include <string>
+#include <cstddef>
+
+namespace kk {
+    namespace renderer {
+        // Loads a KTX2 (.ktx2) or DDS (.dds) container holding a 2D block-compressed image (BC1, BC3, BC5 or BC7).
+        // Blocks and pre-built mips are taken as is, without decoding. Mips are repacked at TextureData::kLevelAlignment.
+        // Throws std::runtime_error if the file cannot be read, is malformed, or is not a plain 2D image of those formats
+        // (e.g. supercompressed KTX2, cube maps or arrays).
+        void loadKtx2(const std::string& path, TextureData& data);
+        void loadDds(const std::string& path, TextureData& data);
+
+        // Same as loadKtx2() / loadDds(), parsing the container in [bytes, bytes + size)
+        void parseKtx2(const char* bytes, size_t size, TextureData& data);
+        void parseDds(const char* bytes, size_t size, TextureData& data);
+
+        // Bytes of a 4x4 block of block-compressed `format`, or 0 if `format` is not one of supported BC formats
+        size_t getBlockByte(VkFormat format);
+        // Bytes of a `width` x `height` image of block-compressed `format`
+        VkDeviceSize getBlockCompressedSize(VkFormat format, uint32_t width, uint32_t height);
+    }
+}
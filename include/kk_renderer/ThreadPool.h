@@ -0,0 +1,48 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <queue>
+#include <vector>
+#include <type_traits>
+
+namespace kk {
+    namespace renderer {
+        // Fixed number of worker threads consuming a FIFO task queue.
+        class ThreadPool {
+        public:
+            explicit ThreadPool(size_t thread_count);
+            ~ThreadPool();
+
+            ThreadPool(const ThreadPool&) = delete;
+            ThreadPool& operator=(const ThreadPool&) = delete;
+
+            // Enqueues `task`. Returned future gives its result (or exception).
+            template <class F>
+            std::future<typename std::result_of<F()>::type> submit(F&& task) {
+                using Result = typename std::result_of<F()>::type;
+                auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+                std::future<Result> result = packaged->get_future();
+                enqueue([packaged]() { (*packaged)(); });
+
+                return result;
+            }
+
+            inline size_t getThreadCount() const { return workers_.size(); }
+
+        private:
+            void enqueue(std::function<void()> task);
+            void work();
+
+            std::vector<std::thread> workers_;
+            std::queue<std::function<void()>> tasks_;
+            std::mutex mutex_;
+            std::condition_variable cv_;
+            bool is_stopping_;
+        };
+    }
+}
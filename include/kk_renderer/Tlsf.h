@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <array>
+
+namespace kk {
+    namespace renderer {
+        // Two-Level Segregated Fit allocator over an abstract range [0, size).
+        // It only manages offsets, so the same code serves device memory blocks and buffer sub-ranges.
+        // Both allocate() and free() are O(1).
+        class Tlsf {
+        public:
+            static constexpr uint32_t kInvalidNode = UINT32_MAX;
+
+            Tlsf();
+
+            void init(uint64_t size);
+
+            // Returns node id of the allocation (kInvalidNode if no space). `offset` receives aligned offset.
+            // NOTE: alignment must be power of 2
+            uint32_t allocate(uint64_t size, uint64_t alignment, uint64_t& offset);
+            void free(uint32_t node);
+
+            inline uint64_t getSize() const { return size_; }
+            inline uint64_t getUsedSize() const { return used_; }
+            inline uint64_t getFreeSize() const { return size_ - used_; }
+            inline uint32_t getAllocationCount() const { return allocation_count_; }
+            inline bool isEmpty() const { return allocation_count_ == 0; }
+            uint64_t getLargestFreeRange() const;
+
+        private:
+            static constexpr uint32_t kSlLog = 4;
+            static constexpr uint32_t kSlCount = 1 << kSlLog;
+            static constexpr uint32_t kFlCount = 64;
+
+            struct Node {
+                uint64_t offset;
+                uint64_t size;
+                uint32_t prev_phys, next_phys;
+                uint32_t prev_free, next_free;
+                bool is_free;
+            };
+
+            static void mapping(uint64_t size, uint32_t& fl, uint32_t& sl);
+            uint32_t newNode();
+            void releaseNode(uint32_t node);
+            void insertFree(uint32_t node);
+            void removeFree(uint32_t node);
+            uint32_t findFree(uint64_t size) const;
+
+            std::vector<Node> nodes_;
+            std::vector<uint32_t> unused_nodes_;
+
+            uint64_t fl_bitmap_;
+            std::array<uint32_t, kFlCount> sl_bitmaps_;
+            std::array<uint32_t, kFlCount * kSlCount> heads_;
+
+            uint64_t size_;
+            uint64_t used_;
+            uint32_t allocation_count_;
+        };
+    }
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <deque>
+#include "MemoryAllocator.h"
+
+namespace kk {
+    namespace renderer {
+        struct RenderingContext;
+
+        // Batches GPU uploads into one command buffer, staged through a persistently mapped ring buffer.
+        // Recorded uploads are submitted together by flush() and tracked by a single fence per batch.
+        // NOTE: Uploads are visible to commands submitted after flush(). Renderer flushes at endFrame().
+        class TransferBatcher {
+        public:
+            static constexpr VkDeviceSize kDefaultStagingSize = 32 * 1024 * 1024;
+
+            static TransferBatcher create(RenderingContext& ctx, VkDeviceSize staging_size);
+            void destroy(RenderingContext& ctx);
+
+            // Copies `src` to staging memory and records copy into `dst`.
+            void uploadBuffer(RenderingContext& ctx, VkBuffer dst, VkDeviceSize dst_offset, const void* src, VkDeviceSize size);
+
+            // Copies `src` to staging memory and records copy into mip 0 of `dst`, then fills mips [1, mip_levels)
+            // by downsampling the previous mip with vkCmdBlitImage. Every mip is transitioned from UNDEFINED to SHADER_READ_ONLY_OPTIMAL.
+            // NOTE: If mip_levels > 1, `dst` needs TRANSFER_SRC usage and its format needs blit and linear filter support
+            void uploadImage(RenderingContext& ctx, VkImage dst, VkExtent2D extent, const void* src, VkDeviceSize size, uint32_t mip_levels = 1);
+
+            // Same as uploadImage(), but copies every mip from `src`. Mip i starts at `level_offsets[i]` of `src`.
+            void uploadImageLevels(
+                RenderingContext& ctx,
+                VkImage dst,
+                VkExtent2D extent,
+                const void* src,
+                VkDeviceSize size,
+                const std::vector<VkDeviceSize>& level_offsets
+            );
+
+            // Reserves staging memory of the current batch. Returns host pointer, and copy source via `src_buffer` and `src_offset`.
+            void* stage(RenderingContext& ctx, VkDeviceSize size, VkBuffer& src_buffer, VkDeviceSize& src_offset);
+
+            // Command buffer of the current batch, to record transfer commands directly.
+            VkCommandBuffer getCmdBuf(RenderingContext& ctx);
+
+            // Submits the current batch. Does nothing if no command is recorded.
+            void flush(RenderingContext& ctx);
+
+            // Blocks until every submitted batch has completed.
+            void wait(RenderingContext& ctx);
+
+            inline size_t getSubmitCount() const { return submit_count_; }
+
+        private:
+            struct StagingBuffer {
+                VkBuffer buffer;
+                Allocation allocation;
+            };
+
+            struct Batch {
+                VkCommandBuffer cmd_buf;
+                VkFence fence;
+                VkDeviceSize ring_begin;
+                bool uses_ring;
+                std::vector<StagingBuffer> overflows;
+            };
+
+            static StagingBuffer createStagingBuffer(RenderingContext& ctx, VkDeviceSize size);
+            void beginBatch(RenderingContext& ctx);
+            bool allocateRing(VkDeviceSize size, VkDeviceSize& offset);
+            bool retire(RenderingContext& ctx, bool block);
+            void updateTail();
+
+            StagingBuffer ring_;
+            VkDeviceSize capacity_;
+            VkDeviceSize head_, tail_;
+            bool is_recording_;
+            Batch current_;
+            std::deque<Batch> in_flight_;
+            std::vector<Batch> free_batches_;
+            size_t submit_count_;
+        };
+    }
+}
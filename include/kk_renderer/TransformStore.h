@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Transform.h"
+#include "Mat4.h"
+#include <vector>
+#include <cstdint>
+
+namespace kk {
+    namespace renderer {
+        // Structure-of-arrays storage of transforms.
+        // Model and MVP matrices of all transforms are computed in batch, 4 transforms per SIMD iteration.
+        // Model matrices of transforms not modified since last update() are reused.
+        class TransformStore {
+        public:
+            using Handle = uint32_t;
+
+            Handle add(const Transform& transform);
+            void remove(Handle handle);
+
+            void set(Handle handle, const Transform& transform);
+            Transform get(Handle handle) const;
+
+            // Recomputes model matrices of modified transforms, then MVP of every transform.
+            // MVPs are recomputed only for modified transforms if `view_proj` is unchanged.
+            void update(const Mat4& view_proj);
+
+            inline const Mat4& getModel(Handle handle) const { return models_[handle]; }
+            inline const Mat4& getMvp(Handle handle) const { return mvps_[handle]; }
+            inline size_t size() const { return count_; }
+
+            // Model matrix of `transform` in the same convention as the batched path (scale * rotation * translation)
+            static Mat4 computeModel(const Transform& transform);
+
+        private:
+            void resize(size_t count);
+            void updateModels(size_t first, size_t count);
+            void updateMvps(const Mat4& view_proj, size_t first, size_t count);
+
+            size_t count_ = 0;
+            // NOTE: Arrays are padded to a multiple of 4 with identity transforms
+            std::vector<float> px_, py_, pz_;
+            std::vector<float> qx_, qy_, qz_, qw_;
+            std::vector<float> sx_, sy_, sz_;
+            std::vector<uint8_t> dirty_;
+            std::vector<Handle> free_handles_;
+
+            std::vector<Mat4> models_, mvps_;
+            Mat4 view_proj_ = Mat4(0.0f);
+        };
+    }
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include "RenderingContext.h"
+#include "Buffer.h"
+
+namespace kk {
+    namespace renderer {
+        // Linear (bump) allocator over a chain of persistently mapped uniform buffers (blocks).
+        // Every slice is bound through VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC with its offset,
+        // or as instance-rate vertex buffer for instanced draws.
+        // When the current block is full, allocation moves on to the next block, creating it if needed.
+        // Blocks are kept over reset(), so that a steady workload stops creating them.
+        // NOTE: Owner must reset() it only after GPU has finished reading the previous contents.
+        struct UniformAllocator {
+            static UniformAllocator create(RenderingContext& ctx, VkDeviceSize block_size);
+            void destroy(RenderingContext& ctx);
+
+            // Returns host pointer to the slice, the index of its block via `block` and its dynamic offset in the block via `offset`.
+            // Slices larger than block size get a block of their own size.
+            void* allocate(RenderingContext& ctx, VkDeviceSize size, uint32_t& block, uint32_t& offset);
+
+            inline void reset() {
+                current = 0;
+                head = 0;
+            }
+
+            std::vector<Buffer> blocks;
+            VkDeviceSize block_size;
+            VkDeviceSize alignment;
+            size_t current; // Block being allocated from
+            VkDeviceSize head;
+        };
+    }
+}
@@ -3,8 +3,11 @@
 #include "Vec2.h"
 #include "Vec3.h"
 #include "Vec4.h"
+#include "Mat4.h"
 #include <vulkan/vulkan.h>
 #include <array>
+#include <vector>
+#include <cstdint>
 
 namespace kk {
     namespace renderer {
@@ -18,5 +21,42 @@ namespace kk {
         };
 
         bool operator==(const Vertex& lhs, const Vertex& rhs);
+
+        // Layout of vertex buffer of a geometry. Materials build a pipeline per format drawn with them.
+        enum class VertexFormat {
+            kFloat,               // Vertex (36 byte)
+            kPacked,              // PackedVertex + unorm8 color stream (16 byte)
+            kPackedConstantColor, // PackedVertex + one unorm8 color read by every vertex (12 byte)
+        };
+        constexpr size_t kVertexFormatCount = 3;
+
+        // Compact vertex for VertexFormat::kPacked*.
+        // Position is unorm16 relative to geometry bounds, which shaders see as [0, 1].
+        // Geometry::dequantize maps it back to local space and Renderer folds it into MVP, so shaders need no change.
+        struct PackedVertex {
+            uint16_t position[4]; // xyz, w unused
+            uint16_t uv[2];       // half float
+
+            // Color is a separate stream at this binding, so that constant color costs no per-vertex memory
+            static constexpr uint32_t kColorBinding = 2;
+
+            static PackedVertex pack(const Vertex& vertex, const Vec3& min, const Vec3& extent);
+            static uint32_t packColor(const Vec4& color);
+        };
+
+        // Vertex input bindings and attributes of `format` (locations 0-2)
+        void getVertexInputDescriptions(
+            VertexFormat format,
+            std::vector<VkVertexInputBindingDescription>& bindings,
+            std::vector<VkVertexInputAttributeDescription>& attributes
+        );
+
+        // Per-instance input of instanced draws, bound to binding 1 (locations 3-6)
+        struct InstanceData {
+            Mat4 mvp;
+
+            static VkVertexInputBindingDescription getBindingDescription();
+            static std::array<VkVertexInputAttributeDescription, 4> getAttributeDescriptions();
+        };
     }
 }
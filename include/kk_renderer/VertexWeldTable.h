@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Vertex.h"
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace kk {
+    namespace renderer {
+        // Flat open addressing table to deduplicate vertices while importing meshes.
+        // Vertices are identified by their raw bytes (so 0.0 and -0.0 are distinct), hashed once per lookup.
+        class VertexWeldTable {
+        public:
+            // Reserves slots for `expected_count` unique vertices, so that no rehash happens below that count
+            explicit VertexWeldTable(size_t expected_count = 0);
+
+            // Returns index of `vertex` in `vertices`, appending it if not seen yet.
+            // NOTE: `vertices` must be the same vector, modified only by weld(), across calls.
+            uint32_t weld(const Vertex& vertex, std::vector<Vertex>& vertices);
+
+            inline size_t size() const { return count_; }
+            inline size_t getCapacity() const { return slots_.size(); }
+
+            static uint64_t hash(const Vertex& vertex);
+
+        private:
+            struct Slot {
+                uint32_t tag;   // Low 32 bits of hash. Its low bits are the home slot.
+                uint32_t index; // kEmpty if unused
+            };
+
+            void grow();
+
+            std::vector<Slot> slots_;
+            size_t mask_;
+            size_t count_;
+        };
+    }
+}
@@ -1,4 +1,4 @@
-import sys, glob, subprocess
+import sys, glob, shutil, subprocess
 
 USAGE = "Usage: python {} <SHADERS_DIR> <COMPILER_PATH>".format(__file__)
 
@@ -13,6 +13,8 @@ def main(argv):
     srcs += glob.glob("{}/*.frag".format(SHADERS_DIR), recursive=True)
 
     COMPILER_PATH=argv[2]
+    # Validator ships with the compiler in Vulkan SDK
+    VALIDATOR_PATH=shutil.which("spirv-val")
     for src in srcs:
         # Build command
         cmd = [COMPILER_PATH, src, "-o", src + ".spv"]
@@ -23,6 +25,14 @@ def main(argv):
         if ret != 0:
             return 1
 
+        # Validate output
+        if VALIDATOR_PATH is not None:
+            cmd = [VALIDATOR_PATH, src + ".spv"]
+            print(" ".join(cmd))
+            ret = subprocess.run(cmd).returncode
+            if ret != 0:
+                return 1
+
     return 0
 
 if __name__ == "__main__":
@@ -0,0 +1,15 @@
+#version 450
+
+layout(location = 0) in vec3 inPos;
+layout(location = 1) in vec2 inUV;
+layout(location = 2) in vec4 inColor;
+layout(location = 3) in mat4 inMvp; // Per instance
+
+layout(location = 0) out vec2 outUV;
+layout(location = 1) out vec4 outColor;
+
+void main() {
+	gl_Position = inMvp * vec4(inPos, 1.0);
+	outUV = inUV;
+	outColor = inColor;
+}
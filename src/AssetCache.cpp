@@ -0,0 +1,149 @@
+#include "kk_renderer/AssetCache.h"
+#include "kk_renderer/RenderingContext.h"
+#include "kk_renderer/MappedFile.h"
+#include <cstdio>
+
+using namespace kk::renderer;
+
+constexpr VkDeviceSize AssetCache::kDefaultBudget;
+
+static uint64_t hashBytes(const char* data, size_t size);
+
+AssetCache::AssetCache(VkDeviceSize budget) : budget_(budget), stats_() {}
+
+std::shared_ptr<Texture> AssetCache::getTexture(RenderingContext& ctx, const std::string& path, uint32_t flags) {
+    return std::static_pointer_cast<Texture>(get(ctx, path, 'T', flags, [&](Entry& entry) {
+        auto texture = std::make_shared<Texture>(Texture::create(ctx, path, flags));
+        entry.asset = texture;
+        entry.size = texture->allocation.size;
+        entry.destroy = [](RenderingContext& ctx, const std::shared_ptr<void>& asset) {
+            std::static_pointer_cast<Texture>(asset)->destroy(ctx);
+        };
+    }));
+}
+
+std::shared_ptr<Shader> AssetCache::getShader(RenderingContext& ctx, const std::string& path) {
+    return std::static_pointer_cast<Shader>(get(ctx, path, 'S', 0, [&](Entry& entry) {
+        const std::vector<char> code = Shader::loadCode(path);
+        auto shader = std::make_shared<Shader>(Shader::create(ctx, code));
+        entry.asset = shader;
+        entry.size = code.size();
+        entry.destroy = [](RenderingContext& ctx, const std::shared_ptr<void>& asset) {
+            std::static_pointer_cast<Shader>(asset)->destroy(ctx);
+        };
+    }));
+}
+
+std::shared_ptr<Geometry> AssetCache::getGeometry(RenderingContext& ctx, const std::string& path, uint32_t flags) {
+    return std::static_pointer_cast<Geometry>(get(ctx, path, 'G', flags, [&](Entry& entry) {
+        auto geometry = std::make_shared<Geometry>(Geometry::create(ctx, path, flags));
+        entry.asset = geometry;
+        if (geometry->pool != nullptr) {
+            const GeometryPool::Range range = geometry->getPoolRange();
+            entry.size = range.vertex_size + range.index_size;
+        }
+        else {
+            entry.size = geometry->vertex_buffer.size + geometry->index_buffer.size;
+        }
+        entry.destroy = [](RenderingContext& ctx, const std::shared_ptr<void>& asset) {
+            std::static_pointer_cast<Geometry>(asset)->destroy(ctx);
+        };
+    }));
+}
+
+std::shared_ptr<void> AssetCache::get(
+    RenderingContext& ctx,
+    const std::string& path,
+    char type,
+    uint32_t flags,
+    const std::function<void(Entry&)>& load
+) {
+    const std::string key = getContentKey(path, type, flags);
+    auto found = entry_map_.find(key);
+    if (found != entry_map_.end()) {
+        ++stats_.hit_count;
+        entries_.splice(entries_.begin(), entries_, found->second);
+        return found->second->asset;
+    }
+
+    ++stats_.miss_count;
+    Entry entry{};
+    entry.key = key;
+    load(entry);
+    stats_.memory_used += entry.size;
+    // NOTE: Moved, so that the cache keeps the only reference
+    entries_.push_front(std::move(entry));
+    entry_map_[key] = entries_.begin();
+    ++stats_.entry_count;
+
+    // NOTE: The new entry is referenced by the returned pointer, so it is never evicted here
+    std::shared_ptr<void> asset = entries_.front().asset;
+    trim(ctx);
+    return asset;
+}
+
+std::string AssetCache::getContentKey(const std::string& path, char type, uint32_t flags) {
+    const std::string path_key = type + std::to_string(flags) + ':' + path;
+    uint64_t file_size = 0;
+    int64_t file_mtime = 0;
+    const bool has_stamp = getFileStamp(path, file_size, file_mtime);
+    auto found = paths_.find(path_key);
+    if (has_stamp && found != paths_.end() && found->second.file_size == file_size && found->second.file_mtime == file_mtime) {
+        return found->second.key;
+    }
+
+    // NOTE: Size is part of the key, so that a collision needs files of the same size
+    MappedFile file = MappedFile::create(path);
+    char hash[40];
+    std::snprintf(
+        hash, sizeof(hash), "%016llx-%llx",
+        static_cast<unsigned long long>(hashBytes(file.data, file.size)),
+        static_cast<unsigned long long>(file.size)
+    );
+    file.destroy();
+
+    PathInfo info{};
+    info.key = type + std::to_string(flags) + ':' + hash;
+    info.file_size = file_size;
+    info.file_mtime = file_mtime;
+    paths_[path_key] = info;
+    return info.key;
+}
+
+void AssetCache::trim(RenderingContext& ctx) {
+    auto it = entries_.end();
+    while (stats_.memory_used > budget_ && it != entries_.begin()) {
+        --it;
+        // Only the cache refers to it
+        if (it->asset.use_count() > 1) {
+            continue;
+        }
+        it->destroy(ctx, it->asset);
+        stats_.memory_used -= it->size;
+        --stats_.entry_count;
+        ++stats_.eviction_count;
+        entry_map_.erase(it->key);
+        it = entries_.erase(it);
+    }
+}
+
+void AssetCache::destroy(RenderingContext& ctx) {
+    for (auto& entry : entries_) {
+        entry.destroy(ctx, entry.asset);
+    }
+    entries_.clear();
+    entry_map_.clear();
+    paths_.clear();
+    stats_.entry_count = 0;
+    stats_.memory_used = 0;
+}
+
+// FNV-1a
+static uint64_t hashBytes(const char* data, size_t size) {
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<uint8_t>(data[i]);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
@@ -0,0 +1,88 @@
+#include "kk_renderer/AssetLoader.h"
+#include "kk_renderer/RenderingContext.h"
+#include <chrono>
+#include <exception>
+#include <iostream>
+
+using namespace kk::renderer;
+
+AssetLoader::AssetLoader(size_t thread_count) : workers_(std::make_shared<ThreadPool>(thread_count)) {}
+
+AssetHandle<Geometry> AssetLoader::loadGeometryAsync(const std::string& path, uint32_t flags) {
+    return enqueue<Geometry, GeometryData>(
+        [path, flags]() { return GeometryData::load(path, flags); },
+        [](RenderingContext& ctx, GeometryData& data) { return Geometry::create(ctx, std::move(data)); }
+    );
+}
+
+AssetHandle<Texture> AssetLoader::loadTextureAsync(const std::string& path) {
+    return enqueue<Texture, TextureData>(
+        [path]() { return TextureData::load(path); },
+        [](RenderingContext& ctx, TextureData& data) { return Texture::create(ctx, data); }
+    );
+}
+
+AssetHandle<Shader> AssetLoader::loadShaderAsync(const std::string& path) {
+    return enqueue<Shader, std::vector<char>>(
+        [path]() { return Shader::loadCode(path); },
+        [](RenderingContext& ctx, std::vector<char>& code) { return Shader::create(ctx, code); }
+    );
+}
+
+template <class T, class Data, class Load, class Create>
+AssetHandle<T> AssetLoader::enqueue(Load load, Create create) {
+    auto asset = std::make_shared<T>();
+    asset->is_pending = true;
+    auto promise = std::make_shared<std::promise<void>>();
+    auto data = std::make_shared<std::future<Data>>(workers_->submit(std::move(load)));
+
+    pending_.push_back([asset, promise, data, create](RenderingContext& ctx, bool is_blocking) {
+        if (!is_blocking && data->wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            return false;
+        }
+
+        try {
+            Data decoded = data->get();
+            // NOTE: Placeholder is overwritten in place, so that holders of `asset` see the loaded one
+            *asset = create(ctx, decoded);
+            promise->set_value();
+        }
+        catch (const std::exception& e) {
+            // Asset stays pending, so it is never drawn
+            std::cerr << "Warning: Failed to load asset: " << e.what() << std::endl;
+            promise->set_exception(std::current_exception());
+        }
+        return true;
+    });
+
+    AssetHandle<T> handle;
+    handle.asset = asset;
+    handle.loaded = promise->get_future().share();
+    return handle;
+}
+
+size_t AssetLoader::update(RenderingContext& ctx) {
+    size_t finished_count = 0;
+    size_t kept_count = 0;
+    for (size_t i = 0; i < pending_.size(); ++i) {
+        if (pending_[i](ctx, false)) {
+            ++finished_count;
+        }
+        else {
+            if (kept_count != i) {
+                pending_[kept_count] = std::move(pending_[i]);
+            }
+            ++kept_count;
+        }
+    }
+    pending_.resize(kept_count);
+
+    return finished_count;
+}
+
+void AssetLoader::wait(RenderingContext& ctx) {
+    for (auto& finish : pending_) {
+        finish(ctx, true);
+    }
+    pending_.clear();
+}
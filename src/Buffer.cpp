@@ -5,6 +5,8 @@
 
 using namespace kk::renderer;
 
+static VkCommandBuffer beginCopy(RenderingContext& ctx);
+
 Buffer Buffer::create(RenderingContext& ctx, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags mem_props) {
     Buffer buffer{};
 
@@ -17,25 +19,27 @@ Buffer Buffer::create(RenderingContext& ctx, VkDeviceSize size, VkBufferUsageFla
 
     VkMemoryRequirements mem_reqs{};
     vkGetBufferMemoryRequirements(ctx.device, buffer.buffer, &mem_reqs);
-    VkMemoryAllocateInfo alloc_info{};
-    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    alloc_info.allocationSize = mem_reqs.size;
-    alloc_info.memoryTypeIndex = ctx.findMemoryType(mem_reqs.memoryTypeBits, mem_props);
-    assert(vkAllocateMemory(ctx.device, &alloc_info, nullptr, &buffer.memory) == VK_SUCCESS);
+    buffer.allocation = ctx.allocator.allocate(mem_reqs, mem_props, true);
 
-    assert(vkBindBufferMemory(ctx.device, buffer.buffer, buffer.memory, 0) == VK_SUCCESS);
+    assert(vkBindBufferMemory(ctx.device, buffer.buffer, buffer.allocation.memory, buffer.allocation.offset) == VK_SUCCESS);
 
     buffer.size = size;
     buffer.usage = usage;
     buffer.memory_props = mem_props;
+    // NOTE: Host visible memory is persistently mapped by allocator
+    buffer.mapped = buffer.allocation.mapped;
 
     return buffer;
 }
 
 void Buffer::destroy(RenderingContext& ctx) {
-    vkDeviceWaitIdle(ctx.device); // CONCERN
-    vkFreeMemory(ctx.device, memory, nullptr);
-    vkDestroyBuffer(ctx.device, buffer, nullptr);
+    // NOTE: In-flight frames and pending uploads may still refer to this buffer
+    const VkBuffer buffer_handle = buffer;
+    const Allocation buffer_allocation = allocation;
+    ctx.deletion_queue.push([buffer_handle, buffer_allocation](RenderingContext& ctx) {
+        vkDestroyBuffer(ctx.device, buffer_handle, nullptr);
+        ctx.allocator.free(buffer_allocation);
+    });
 }
 
 void Buffer::setData(RenderingContext& ctx, const void* data, size_t src_size) {
@@ -46,49 +50,49 @@ void Buffer::setData(RenderingContext& ctx, const void* data, size_t src_size) {
     }
 
     if (memory_props & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
-        void* mapped;
-        vkMapMemory(ctx.device, memory, 0, set_size, 0, &mapped);
         std::memcpy(mapped, data, set_size);
-        vkUnmapMemory(ctx.device, memory);
     }
     else {
-        Buffer staging = Buffer::create(
-            ctx,
-            set_size,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-        );
-        staging.setData(ctx, data, set_size);
-        staging.copyTo(ctx, *this, set_size);
-        staging.destroy(ctx);
+        // NOTE: Copy is submitted with the next flush of transfer batch
+        ctx.transfer.uploadBuffer(ctx, buffer, 0, data, set_size);
     }
 }
 
 void Buffer::copyTo(RenderingContext& ctx, Buffer& dst, VkDeviceSize copy_size) const {
-    ctx.submitCmdsImmediate([this, dst, copy_size](VkCommandBuffer cmd_buf) {
-        VkBufferCopy copy_region{};
-        copy_region.size = copy_size;
-        vkCmdCopyBuffer(cmd_buf, buffer, dst.buffer, 1, &copy_region);
-    });
+    const VkCommandBuffer cmd_buf = beginCopy(ctx);
+    VkBufferCopy copy_region{};
+    copy_region.size = copy_size;
+    vkCmdCopyBuffer(cmd_buf, buffer, dst.buffer, 1, &copy_region);
 }
 
 void Buffer::copyTo(RenderingContext& ctx, Texture& dst, VkExtent2D copy_extent) const {
-    ctx.submitCmdsImmediate([this, dst, copy_extent](VkCommandBuffer cmd_buf) {
-        VkBufferImageCopy region{};
-        region.bufferOffset = 0;
-        region.bufferRowLength = 0;
-        region.bufferImageHeight = 0;
-        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        region.imageSubresource.mipLevel = 0;
-        region.imageSubresource.baseArrayLayer = 0;
-        region.imageSubresource.layerCount = 1;
-        region.imageOffset = { 0, 0, 0 };
-        region.imageExtent = {
-            copy_extent.width,
-            copy_extent.height,
-            1
-        };
-
-        vkCmdCopyBufferToImage(cmd_buf, buffer, dst.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-    });
+    const VkCommandBuffer cmd_buf = beginCopy(ctx);
+    VkBufferImageCopy region{};
+    region.bufferOffset = 0;
+    region.bufferRowLength = 0;
+    region.bufferImageHeight = 0;
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+    region.imageOffset = { 0, 0, 0 };
+    region.imageExtent = {
+        copy_extent.width,
+        copy_extent.height,
+        1
+    };
+
+    vkCmdCopyBufferToImage(cmd_buf, buffer, dst.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+}
+
+static VkCommandBuffer beginCopy(RenderingContext& ctx) {
+    // Copies in the batch come after uploads recorded before them (e.g. setData() of device local buffer)
+    const VkCommandBuffer cmd_buf = ctx.transfer.getCmdBuf(ctx);
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+    return cmd_buf;
 }
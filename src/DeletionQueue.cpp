@@ -0,0 +1,46 @@
+#include "kk_renderer/DeletionQueue.h"
+#include "kk_renderer/RenderingContext.h"
+
+using namespace kk::renderer;
+
+DeletionQueue DeletionQueue::create(size_t frame_count) {
+    DeletionQueue queue{};
+    queue.frame_serial_ = 1;
+    queue.fence_serials_.assign(frame_count, 0);
+
+    return queue;
+}
+
+void DeletionQueue::push(const Deleter& deleter) {
+    entries_.push_back({ frame_serial_, deleter });
+}
+
+void DeletionQueue::onSubmit(size_t frame) {
+    fence_serials_[frame] = frame_serial_++;
+}
+
+void DeletionQueue::collect(RenderingContext& ctx) {
+    if (entries_.empty()) {
+        return;
+    }
+
+    // NOTE: Queue completes submissions in order, so a signaled fence implies every earlier frame has completed
+    uint64_t completed = 0;
+    for (size_t i = 0; i < fence_serials_.size(); ++i) {
+        if (fence_serials_[i] > completed && vkGetFenceStatus(ctx.device, ctx.fences[i]) == VK_SUCCESS) {
+            completed = fence_serials_[i];
+        }
+    }
+
+    while (!entries_.empty() && entries_.front().serial <= completed) {
+        entries_.front().deleter(ctx);
+        entries_.pop_front();
+    }
+}
+
+void DeletionQueue::flush(RenderingContext& ctx) {
+    while (!entries_.empty()) {
+        entries_.front().deleter(ctx);
+        entries_.pop_front();
+    }
+}
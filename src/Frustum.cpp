@@ -0,0 +1,142 @@
+#include "kk_renderer/Frustum.h"
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define KK_RENDERER_USE_SSE
+#include <emmintrin.h>
+#endif
+
+using namespace kk;
+using namespace kk::renderer;
+
+Frustum Frustum::create(const Mat4& view_proj) {
+    // NOTE: glm matrix is column major, so row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+    const Vec4 row0(view_proj[0][0], view_proj[1][0], view_proj[2][0], view_proj[3][0]);
+    const Vec4 row1(view_proj[0][1], view_proj[1][1], view_proj[2][1], view_proj[3][1]);
+    const Vec4 row2(view_proj[0][2], view_proj[1][2], view_proj[2][2], view_proj[3][2]);
+    const Vec4 row3(view_proj[0][3], view_proj[1][3], view_proj[2][3], view_proj[3][3]);
+
+    Frustum frustum;
+    frustum.planes[0] = row3 + row0;
+    frustum.planes[1] = row3 - row0;
+    frustum.planes[2] = row3 + row1;
+    frustum.planes[3] = row3 - row1;
+    // NOTE: -w <= z holds for both [-1, 1] and [0, 1] depth ranges, so it is conservative for either projection
+    frustum.planes[4] = row3 + row2;
+    frustum.planes[5] = row3 - row2;
+
+    for (auto& plane : frustum.planes) {
+        const float length = std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+        if (length > 0.0f) {
+            plane /= length;
+        }
+    }
+
+    return frustum;
+}
+
+bool Frustum::intersects(const Vec3& center, float radius) const {
+    for (const auto& plane : planes) {
+        if (plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w < -radius) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+size_t Frustum::cullSpheres(const float* xs, const float* ys, const float* zs, const float* radii, size_t count, uint8_t* visible) const {
+    size_t visible_count = 0;
+    size_t i = 0;
+
+#ifdef KK_RENDERER_USE_SSE
+    for (; i + 4 <= count; i += 4) {
+        const __m128 x = _mm_loadu_ps(xs + i);
+        const __m128 y = _mm_loadu_ps(ys + i);
+        const __m128 z = _mm_loadu_ps(zs + i);
+        const __m128 neg_r = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(radii + i));
+
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (const auto& plane : planes) {
+            const __m128 dist = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(plane.x)), _mm_mul_ps(y, _mm_set1_ps(plane.y))),
+                _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w))
+            );
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(dist, neg_r));
+        }
+
+        const int mask = _mm_movemask_ps(inside);
+        for (size_t j = 0; j < 4; ++j) {
+            visible[i + j] = static_cast<uint8_t>((mask >> j) & 1);
+            visible_count += visible[i + j];
+        }
+    }
+#endif
+
+    for (; i < count; ++i) {
+        visible[i] = intersects(Vec3(xs[i], ys[i], zs[i]), radii[i]) ? 1 : 0;
+        visible_count += visible[i];
+    }
+
+    return visible_count;
+}
+
+// Cluster faces away if dot(center - eye, axis) >= cutoff * |center - eye| + radius
+static bool isBackfacing(const ClusterBounds& clusters, size_t i, const Vec3& eye, float facing) {
+    const Vec3 d(clusters.x[i] - eye.x, clusters.y[i] - eye.y, clusters.z[i] - eye.z);
+    const float length = std::sqrt(d.x * d.x + d.y * d.y + d.z * d.z);
+    const float dot = (d.x * clusters.axis_x[i] + d.y * clusters.axis_y[i] + d.z * clusters.axis_z[i]) * facing;
+    return dot >= clusters.cutoff[i] * length + clusters.radius[i];
+}
+
+size_t Frustum::cullClusters(const ClusterBounds& clusters, const Vec3& eye, float facing, uint8_t* visible) const {
+    const size_t count = clusters.size();
+    size_t visible_count = 0;
+    size_t i = 0;
+
+#ifdef KK_RENDERER_USE_SSE
+    const __m128 ex = _mm_set1_ps(eye.x), ey = _mm_set1_ps(eye.y), ez = _mm_set1_ps(eye.z);
+    const __m128 sign = _mm_set1_ps(facing);
+    for (; i + 4 <= count; i += 4) {
+        const __m128 x = _mm_loadu_ps(&clusters.x[i]);
+        const __m128 y = _mm_loadu_ps(&clusters.y[i]);
+        const __m128 z = _mm_loadu_ps(&clusters.z[i]);
+        const __m128 r = _mm_loadu_ps(&clusters.radius[i]);
+        const __m128 neg_r = _mm_sub_ps(_mm_setzero_ps(), r);
+
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (const auto& plane : planes) {
+            const __m128 dist = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(plane.x)), _mm_mul_ps(y, _mm_set1_ps(plane.y))),
+                _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w))
+            );
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(dist, neg_r));
+        }
+
+        const __m128 dx = _mm_sub_ps(x, ex), dy = _mm_sub_ps(y, ey), dz = _mm_sub_ps(z, ez);
+        const __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+        const __m128 dot = _mm_mul_ps(sign, _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(dx, _mm_loadu_ps(&clusters.axis_x[i])), _mm_mul_ps(dy, _mm_loadu_ps(&clusters.axis_y[i]))),
+            _mm_mul_ps(dz, _mm_loadu_ps(&clusters.axis_z[i]))
+        ));
+        const __m128 backfacing = _mm_cmpge_ps(dot, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&clusters.cutoff[i]), length), r));
+        inside = _mm_andnot_ps(backfacing, inside);
+
+        const int mask = _mm_movemask_ps(inside);
+        for (size_t j = 0; j < 4; ++j) {
+            visible[i + j] = static_cast<uint8_t>((mask >> j) & 1);
+            visible_count += visible[i + j];
+        }
+    }
+#endif
+
+    for (; i < count; ++i) {
+        visible[i] = (
+            intersects(Vec3(clusters.x[i], clusters.y[i], clusters.z[i]), clusters.radius[i]) &&
+            !isBackfacing(clusters, i, eye, facing)
+        ) ? 1 : 0;
+        visible_count += visible[i];
+    }
+
+    return visible_count;
+}
@@ -1,109 +1,514 @@
 #include "kk_renderer/Geometry.h"
-#include <fstream>
-#include <sstream>
+#include "kk_renderer/ObjLoader.h"
+#include "kk_renderer/MeshOptimizer.h"
+#include "kk_renderer/MappedFile.h"
+#include <stdexcept>
 #include <iostream>
-#include <unordered_map>
-#define TINYOBJLOADER_IMPLEMENTATION
-#include <tinyobjloader/tiny_obj_loader.h>
-#include <functional>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <cmath>
+#include <cassert>
+#include <glm/gtc/matrix_transform.hpp>
 
 using namespace kk;
 using namespace kk::renderer;
 
-namespace std {
-    template<> struct hash<Vertex> {
-        size_t operator()(Vertex const& vertex) const {
-            return ((hash<Vec3>()(vertex.position) ^ (hash<Vec4>()(vertex.color) << 1)) >> 1) ^ (hash<Vec2>()(vertex.uv) << 1);
-        }
-    };
+// .kkmesh layout: MeshCacheHeader, then vertex blob (Vertex layout), index blob (uint32_t), LOD table (MeshLod)
+// and meshlet table (Meshlet) at the given offsets
+static constexpr char kMeshCacheMagic[4] = { 'K', 'K', 'M', 'S' };
+static constexpr uint32_t kMeshCacheVersion = 4;
+static constexpr uint64_t kMeshCacheAlignment = 16;
+// Flags not changing the content (only how it is uploaded or kept), ignored by cache validation
+static constexpr uint32_t kMeshCacheIgnoredFlags = kGeometryPooled | kGeometryDropCpuData | kGeometryPackVertices;
+
+struct MeshCacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t vertex_size; // sizeof(Vertex) of the writer
+    uint32_t index_size;
+    uint32_t flags;       // GeometryFlagBits, since they change the content
+    uint64_t source_size; // Source file stamp, to detect stale cache
+    int64_t source_mtime;
+    uint64_t vertex_count, vertex_offset;
+    uint64_t index_count, index_offset;
+    uint64_t lod_count, lod_offset;
+    uint64_t meshlet_count, meshlet_offset;
+    Bounds bounds;
+};
+
+// Content of a geometry, either in memory or mapped from cache
+struct GeometrySource {
+    const Vertex* vertices;
+    size_t vertex_count;
+    const uint32_t* indices;
+    size_t index_count;
+    const MeshLod* lods; // LOD 0 alone if empty
+    size_t lod_count;
+    const Meshlet* meshlets;
+    size_t meshlet_count;
+    Bounds bounds;
+    // Vectors holding vertices and indices, taken over by move if not null
+    std::vector<Vertex>* owned_vertices;
+    std::vector<uint32_t>* owned_indices;
+};
+
+static uint64_t alignCacheOffset(uint64_t offset) {
+    return (offset + kMeshCacheAlignment - 1) / kMeshCacheAlignment * kMeshCacheAlignment;
 }
 
-static void loadModel(const std::string& path, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+static Geometry createGeometry(RenderingContext& ctx, const GeometrySource& source, uint32_t flags);
+static void packVertices(const Vertex* vertices, size_t vertex_count, const Bounds& bounds, Geometry& geometry, std::vector<uint8_t>& packed);
+static bool isCacheValid(const MappedFile& cache, const std::string& source_path, uint32_t flags);
 
-Geometry Geometry::create(RenderingContext& ctx, const std::string& path) {
+GeometryData GeometryData::load(const std::string& path, uint32_t flags) {
     std::vector<Vertex> vertices;
     std::vector<uint32_t> indices;
-    loadModel(path, vertices, indices);
+    loadObj(path, vertices, indices);
 
-    return Geometry::create(
-        ctx,
-        vertices,
-        indices
-    );
+    return GeometryData::create(std::move(vertices), std::move(indices), flags, LodSettings::getDefault());
+}
+
+GeometryData GeometryData::create(
+    std::vector<Vertex>&& vertices,
+    std::vector<uint32_t>&& indices,
+    uint32_t flags,
+    const LodSettings& lod_settings
+) {
+    GeometryData data{};
+    data.vertices = std::move(vertices);
+    data.indices = std::move(indices);
+    data.flags = flags;
+    if (flags & kGeometryOptimize) {
+        optimizeMesh(data.vertices, data.indices);
+    }
+    // NOTE: Meshlets reorder LOD 0, so they are built before LODs are appended
+    if (flags & kGeometryBuildMeshlets) {
+        buildMeshlets(data.vertices, data.indices, data.meshlets);
+    }
+    if (flags & kGeometryGenerateLods) {
+        generateLods(data.vertices, data.indices, lod_settings, data.lods);
+    }
+    data.bounds = Bounds::create(data.vertices);
+
+    return data;
+}
+
+Geometry Geometry::create(RenderingContext& ctx, const std::string& path, uint32_t flags) {
+    return Geometry::create(ctx, GeometryData::load(path, flags));
+}
+
+Geometry Geometry::create(RenderingContext& ctx, GeometryData&& data) {
+    GeometrySource source{};
+    source.vertices = data.vertices.data();
+    source.vertex_count = data.vertices.size();
+    source.indices = data.indices.data();
+    source.index_count = data.indices.size();
+    source.lods = data.lods.data();
+    source.lod_count = data.lods.size();
+    source.meshlets = data.meshlets.data();
+    source.meshlet_count = data.meshlets.size();
+    source.bounds = data.bounds;
+    source.owned_vertices = &data.vertices;
+    source.owned_indices = &data.indices;
+    return createGeometry(ctx, source, data.flags);
+}
+
+Geometry Geometry::create(RenderingContext& ctx, const std::string& path, const std::string& cache_path, uint32_t flags) {
+    MappedFile cache{};
+    bool is_mapped = false;
+    try {
+        cache = MappedFile::create(cache_path);
+        is_mapped = true;
+    }
+    catch (const std::runtime_error&) {
+        // Cache not written yet
+    }
+
+    if (is_mapped && isCacheValid(cache, path, flags)) {
+        // Upload straight from the mapping
+        const MeshCacheHeader* header = reinterpret_cast<const MeshCacheHeader*>(cache.data);
+        GeometrySource source{};
+        source.vertices = reinterpret_cast<const Vertex*>(cache.data + header->vertex_offset);
+        source.vertex_count = static_cast<size_t>(header->vertex_count);
+        source.indices = reinterpret_cast<const uint32_t*>(cache.data + header->index_offset);
+        source.index_count = static_cast<size_t>(header->index_count);
+        source.lods = reinterpret_cast<const MeshLod*>(cache.data + header->lod_offset);
+        source.lod_count = static_cast<size_t>(header->lod_count);
+        source.meshlets = reinterpret_cast<const Meshlet*>(cache.data + header->meshlet_offset);
+        source.meshlet_count = static_cast<size_t>(header->meshlet_count);
+        source.bounds = header->bounds;
+        Geometry geometry = createGeometry(ctx, source, flags);
+        cache.destroy();
+        return geometry;
+    }
+    if (is_mapped) {
+        cache.destroy();
+    }
+
+    // NOTE: CPU data is written to cache before it is dropped
+    Geometry geometry = Geometry::create(ctx, path, flags & ~kGeometryDropCpuData);
+    if (!geometry.writeCache(cache_path, path)) {
+        std::cerr << "Warning: Failed to write mesh cache " << cache_path << std::endl;
+    }
+    if (flags & kGeometryDropCpuData) {
+        std::vector<Vertex>().swap(geometry.vertices);
+        std::vector<uint32_t>().swap(geometry.indices);
+        geometry.flags = flags;
+    }
+    return geometry;
 }
 
 Geometry Geometry::create(
     RenderingContext& ctx,
     const std::vector<Vertex>& vertices,
-    const std::vector<uint32_t> indices
+    const std::vector<uint32_t>& indices,
+    uint32_t flags
 ) {
-    const size_t vertices_byte = sizeof(Vertex) * vertices.size();
-    const size_t indices_byte = sizeof(uint32_t) * indices.size();
+    if (flags & (kGeometryOptimize | kGeometryGenerateLods | kGeometryBuildMeshlets)) {
+        std::vector<Vertex> processed_vertices = vertices;
+        std::vector<uint32_t> processed_indices = indices;
+        return Geometry::create(
+            ctx,
+            GeometryData::create(std::move(processed_vertices), std::move(processed_indices), flags, LodSettings::getDefault())
+        );
+    }
 
-    Geometry geometry{};
-    // NOTE: performance concern
-    geometry.vertices = vertices;
-    geometry.indices = indices;
-    
-    geometry.vertex_buffer = Buffer::create(
+    GeometrySource source{};
+    source.vertices = vertices.data();
+    source.vertex_count = vertices.size();
+    source.indices = indices.data();
+    source.index_count = indices.size();
+    source.bounds = Bounds::create(vertices);
+    return createGeometry(ctx, source, flags);
+}
+
+Geometry Geometry::create(
+    RenderingContext& ctx,
+    std::vector<Vertex>&& vertices,
+    std::vector<uint32_t>&& indices,
+    uint32_t flags
+) {
+    return Geometry::create(ctx, GeometryData::create(std::move(vertices), std::move(indices), flags, LodSettings::getDefault()));
+}
+
+Geometry Geometry::create(
+    RenderingContext& ctx,
+    const std::vector<Vertex>& vertices,
+    const std::vector<uint32_t>& indices,
+    const LodSettings& lod_settings,
+    uint32_t flags
+) {
+    std::vector<Vertex> processed_vertices = vertices;
+    std::vector<uint32_t> processed_indices = indices;
+    return Geometry::create(
         ctx,
-        vertices_byte,
-        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+        GeometryData::create(std::move(processed_vertices), std::move(processed_indices), flags | kGeometryGenerateLods, lod_settings)
     );
-    geometry.index_buffer = Buffer::create(
+}
+
+Geometry Geometry::create(
+    RenderingContext& ctx,
+    std::vector<Vertex>&& vertices,
+    std::vector<uint32_t>&& indices,
+    const LodSettings& lod_settings,
+    uint32_t flags
+) {
+    return Geometry::create(
         ctx,
-        indices_byte,
-        VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+        GeometryData::create(std::move(vertices), std::move(indices), flags | kGeometryGenerateLods, lod_settings)
     );
+}
 
-    geometry.vertex_buffer.setData(ctx, vertices.data(), vertices_byte);
-    geometry.index_buffer.setData(ctx, indices.data(), indices_byte);
+bool Geometry::writeCache(const std::string& cache_path, const std::string& source_path) const {
+    if (vertices.size() != vertex_count || indices.size() != index_count) {
+        return false;
+    }
+    MeshCacheHeader header{};
+    if (!getFileStamp(source_path, header.source_size, header.source_mtime)) {
+        return false;
+    }
+    header.version = kMeshCacheVersion;
+    header.vertex_size = sizeof(Vertex);
+    header.index_size = sizeof(uint32_t);
+    header.flags = flags & ~kMeshCacheIgnoredFlags;
+    header.vertex_count = vertices.size();
+    header.vertex_offset = alignCacheOffset(sizeof(MeshCacheHeader));
+    header.index_count = indices.size();
+    header.index_offset = alignCacheOffset(header.vertex_offset + sizeof(Vertex) * vertices.size());
+    header.lod_count = lods.size();
+    header.lod_offset = alignCacheOffset(header.index_offset + sizeof(uint32_t) * indices.size());
+    header.meshlet_count = meshlets.size();
+    header.meshlet_offset = alignCacheOffset(header.lod_offset + sizeof(MeshLod) * lods.size());
+    header.bounds = bounds;
+
+    FILE* file = std::fopen(cache_path.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+
+    // Blobs in file order, each padded up to the next offset
+    const struct {
+        const void* data;
+        uint64_t size;
+        uint64_t next_offset;
+    } blobs[] = {
+        { &header, sizeof(header), header.vertex_offset },
+        { vertices.data(), sizeof(Vertex) * vertices.size(), header.index_offset },
+        { indices.data(), sizeof(uint32_t) * indices.size(), header.lod_offset },
+        { lods.data(), sizeof(MeshLod) * lods.size(), header.meshlet_offset },
+        { meshlets.data(), sizeof(Meshlet) * meshlets.size(), header.meshlet_offset + sizeof(Meshlet) * meshlets.size() },
+    };
+
+    // NOTE: Magic is written last, so that a partially written file is never taken as valid
+    const char padding[kMeshCacheAlignment] = {};
+    uint64_t offset = 0;
+    bool is_written = true;
+    for (const auto& blob : blobs) {
+        const uint64_t padding_size = blob.next_offset - offset - blob.size;
+        is_written = is_written &&
+            (blob.size == 0 || std::fwrite(blob.data, 1, blob.size, file) == blob.size) &&
+            (padding_size == 0 || std::fwrite(padding, 1, padding_size, file) == padding_size);
+        offset = blob.next_offset;
+    }
+    is_written = is_written &&
+        std::fflush(file) == 0 &&
+        std::fseek(file, 0, SEEK_SET) == 0 &&
+        std::fwrite(kMeshCacheMagic, 1, sizeof(kMeshCacheMagic), file) == sizeof(kMeshCacheMagic);
+    is_written = (std::fclose(file) == 0) && is_written;
+
+    if (!is_written) {
+        std::remove(cache_path.c_str());
+    }
+    return is_written;
+}
+
+static Geometry createGeometry(RenderingContext& ctx, const GeometrySource& source, uint32_t flags) {
+    static uint32_t next_id = 0;
+    const Vertex* vertices = source.vertices;
+    const size_t vertex_count = source.vertex_count;
+    const uint32_t* indices = source.indices;
+    const size_t index_count = source.index_count;
+    assert(source.owned_vertices == nullptr || source.owned_vertices->data() == vertices);
+    assert(source.owned_indices == nullptr || source.owned_indices->data() == indices);
+
+    Geometry geometry{};
+    // TODO: Reuse destructed id
+    geometry.id = next_id++;
+    geometry.bounds = source.bounds;
+    geometry.flags = flags;
+    geometry.pool_handle = GeometryPool::kInvalidHandle;
+    geometry.vertex_count = vertex_count;
+    geometry.index_count = index_count;
+    // CPU copies are kept unless dropped. Vectors given by move are taken over as is.
+    // NOTE: Data pointer of a vector survives move, so `vertices` and `indices` stay valid
+    if (!(flags & kGeometryDropCpuData)) {
+        if (source.owned_vertices != nullptr) {
+            geometry.vertices = std::move(*source.owned_vertices);
+        }
+        else {
+            geometry.vertices.assign(vertices, vertices + vertex_count);
+        }
+        if (source.owned_indices != nullptr) {
+            geometry.indices = std::move(*source.owned_indices);
+        }
+        else {
+            geometry.indices.assign(indices, indices + index_count);
+        }
+    }
+    if (source.lod_count > 0) {
+        geometry.lods.assign(source.lods, source.lods + source.lod_count);
+    }
+    else {
+        geometry.lods.push_back({ 0, static_cast<uint32_t>(index_count), 0.0f });
+    }
+    geometry.meshlets.assign(source.meshlets, source.meshlets + source.meshlet_count);
+    geometry.meshlet_bounds = getClusterBounds(geometry.meshlets);
+
+    // Vertex data in the layout of the buffer
+    std::vector<uint8_t> packed;
+    const void* vertex_data = vertices;
+    size_t vertices_byte = sizeof(Vertex) * vertex_count;
+    geometry.vertex_format = VertexFormat::kFloat;
+    geometry.color_offset = 0;
+    geometry.dequantize = Mat4(1.0f);
+    if (flags & kGeometryPackVertices) {
+        packVertices(vertices, vertex_count, source.bounds, geometry, packed);
+        vertex_data = packed.data();
+        vertices_byte = packed.size();
+    }
+
+    // NOTE: Index values never exceed vertex count
+    std::vector<uint16_t> narrow_indices;
+    const void* index_data = indices;
+    size_t indices_byte = sizeof(uint32_t) * index_count;
+    geometry.index_type = VK_INDEX_TYPE_UINT32;
+    if (vertex_count <= 0x10000) {
+        narrow_indices.assign(indices, indices + index_count);
+        index_data = narrow_indices.data();
+        indices_byte = sizeof(uint16_t) * index_count;
+        geometry.index_type = VK_INDEX_TYPE_UINT16;
+    }
+
+    if (flags & kGeometryPooled) {
+        assert(ctx.geometry_pool != nullptr);
+        const VkDeviceSize vertex_stride = (geometry.vertex_format == VertexFormat::kFloat) ? sizeof(Vertex) : sizeof(PackedVertex);
+        geometry.pool_handle = ctx.geometry_pool->allocate(
+            ctx,
+            vertex_data,
+            vertices_byte,
+            vertex_stride,
+            index_data,
+            indices_byte,
+            geometry.index_type
+        );
+        if (geometry.pool_handle != GeometryPool::kInvalidHandle) {
+            geometry.pool = ctx.geometry_pool;
+            geometry.vertex_buffer = geometry.pool->getVertexBuffer();
+            geometry.index_buffer = geometry.pool->getIndexBuffer();
+        }
+        else {
+            std::cerr << "Warning: Geometry pool is full, falling back to own buffers" << std::endl;
+        }
+    }
+
+    if (geometry.pool == nullptr) {
+        geometry.vertex_buffer = Buffer::create(
+            ctx,
+            vertices_byte,
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+        );
+        geometry.index_buffer = Buffer::create(
+            ctx,
+            indices_byte,
+            VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+        );
+
+        geometry.vertex_buffer.setData(ctx, vertex_data, vertices_byte);
+        geometry.index_buffer.setData(ctx, index_data, indices_byte);
+    }
 
     return geometry;
 }
 
-void Geometry::destroy(RenderingContext& ctx) {
-    vertex_buffer.destroy(ctx);
-    index_buffer.destroy(ctx);
+// Packs vertices into PackedVertex stream followed by color stream, and sets format of `geometry`
+static void packVertices(const Vertex* vertices, size_t vertex_count, const Bounds& bounds, Geometry& geometry, std::vector<uint8_t>& packed) {
+    const Vec3 extent = bounds.max - bounds.min;
+    geometry.dequantize = glm::translate(Mat4(1.0f), bounds.min) * glm::scale(Mat4(1.0f), extent);
+    geometry.color_offset = sizeof(PackedVertex) * vertex_count;
+
+    bool is_color_constant = true;
+    const uint32_t first_color = vertex_count > 0 ? PackedVertex::packColor(vertices[0].color) : 0;
+    for (size_t i = 1; i < vertex_count && is_color_constant; ++i) {
+        is_color_constant = PackedVertex::packColor(vertices[i].color) == first_color;
+    }
+    geometry.vertex_format = is_color_constant ? VertexFormat::kPackedConstantColor : VertexFormat::kPacked;
+
+    packed.resize(geometry.color_offset + sizeof(uint32_t) * (is_color_constant ? 1 : vertex_count));
+    PackedVertex* dst = reinterpret_cast<PackedVertex*>(packed.data());
+    uint32_t* colors = reinterpret_cast<uint32_t*>(packed.data() + geometry.color_offset);
+    for (size_t i = 0; i < vertex_count; ++i) {
+        dst[i] = PackedVertex::pack(vertices[i], bounds.min, extent);
+        if (!is_color_constant) {
+            colors[i] = PackedVertex::packColor(vertices[i].color);
+        }
+    }
+    colors[0] = first_color;
 }
 
-static void loadModel(const std::string& path, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
-    tinyobj::attrib_t attr;
-    std::vector<tinyobj::shape_t> shapes;
-    std::vector<tinyobj::material_t> materials;
-    std::string warn, err;
+// NOTE: Compared without computing offset + count * size, which a corrupt header can overflow
+static bool isBlobInFile(const MappedFile& cache, uint64_t offset, uint64_t count, size_t element_size) {
+    return offset % kMeshCacheAlignment == 0 && offset <= cache.size && count <= (cache.size - offset) / element_size;
+}
 
-    if (!tinyobj::LoadObj(&attr, &shapes, &materials, &warn, &err, path.c_str())) {
-        throw std::runtime_error(err);
+static bool isCacheValid(const MappedFile& cache, const std::string& source_path, uint32_t flags) {
+    if (cache.size < sizeof(MeshCacheHeader)) {
+        return false;
+    }
+    MeshCacheHeader header;
+    std::memcpy(&header, cache.data, sizeof(header));
+    if (std::memcmp(header.magic, kMeshCacheMagic, sizeof(kMeshCacheMagic)) != 0 ||
+        header.version != kMeshCacheVersion ||
+        header.vertex_size != sizeof(Vertex) ||
+        header.index_size != sizeof(uint32_t) ||
+        header.flags != (flags & ~kMeshCacheIgnoredFlags)) {
+        return false;
     }
 
-    std::unordered_map<Vertex, uint32_t> unique_vertices{};
+    // Blobs must lie in the file
+    if (!isBlobInFile(cache, header.vertex_offset, header.vertex_count, sizeof(Vertex)) ||
+        !isBlobInFile(cache, header.index_offset, header.index_count, sizeof(uint32_t)) ||
+        !isBlobInFile(cache, header.lod_offset, header.lod_count, sizeof(MeshLod)) ||
+        !isBlobInFile(cache, header.meshlet_offset, header.meshlet_count, sizeof(Meshlet))) {
+        return false;
+    }
+    // Indices out of vertices would make GPU read out of the vertex buffer
+    const char* indices = cache.data + header.index_offset;
+    for (uint64_t i = 0; i < header.index_count; ++i) {
+        uint32_t index;
+        std::memcpy(&index, indices + i * sizeof(uint32_t), sizeof(index));
+        if (index >= header.vertex_count) {
+            return false;
+        }
+    }
+    for (uint64_t i = 0; i < header.lod_count; ++i) {
+        MeshLod lod;
+        std::memcpy(&lod, cache.data + header.lod_offset + i * sizeof(MeshLod), sizeof(lod));
+        if (static_cast<uint64_t>(lod.first_index) + lod.index_count > header.index_count) {
+            return false;
+        }
+    }
+    for (uint64_t i = 0; i < header.meshlet_count; ++i) {
+        Meshlet meshlet;
+        std::memcpy(&meshlet, cache.data + header.meshlet_offset + i * sizeof(Meshlet), sizeof(meshlet));
+        if (static_cast<uint64_t>(meshlet.first_index) + meshlet.index_count > header.index_count) {
+            return false;
+        }
+    }
 
-    for (const auto& shape : shapes) {
-        for (const auto& index : shape.mesh.indices) {
-            Vertex vertex{};
+    // Source modified after the cache was written. Cache alone (source not shipped) is used as is.
+    uint64_t source_size = 0;
+    int64_t source_mtime = 0;
+    if (getFileStamp(source_path, source_size, source_mtime) &&
+        (source_size != header.source_size || source_mtime != header.source_mtime)) {
+        return false;
+    }
 
-            vertex.position = {
-                attr.vertices[3 * index.vertex_index + 0],
-                attr.vertices[3 * index.vertex_index + 1],
-                attr.vertices[3 * index.vertex_index + 2]
-            };
+    return true;
+}
 
-            vertex.uv = {
-                attr.texcoords[2 * index.texcoord_index + 0],
-                1.0f - attr.texcoords[2 * index.texcoord_index + 1]
-            };
+Bounds Bounds::create(const std::vector<Vertex>& vertices) {
+    Bounds bounds{};
+    if (vertices.empty()) {
+        return bounds;
+    }
 
-            vertex.color = { 1.0f, 1.0f, 1.0f, 1.0f };
+    bounds.min = bounds.max = vertices[0].position;
+    for (const auto& vertex : vertices) {
+        bounds.min = glm::min(bounds.min, vertex.position);
+        bounds.max = glm::max(bounds.max, vertex.position);
+    }
 
-            if (unique_vertices.count(vertex) == 0) {
-                unique_vertices[vertex] = static_cast<uint32_t>(vertices.size());
-                vertices.push_back(vertex);
-            }
+    // NOTE: Sphere around AABB center. Radius is the farthest vertex, tighter than half diagonal.
+    bounds.center = (bounds.min + bounds.max) * 0.5f;
+    float radius_sq = 0.0f;
+    for (const auto& vertex : vertices) {
+        const Vec3 d = vertex.position - bounds.center;
+        radius_sq = std::max(radius_sq, glm::dot(d, d));
+    }
+    bounds.radius = std::sqrt(radius_sq);
 
-            indices.push_back(unique_vertices[vertex]);
-        }
+    return bounds;
+}
+
+void Geometry::destroy(RenderingContext& ctx) {
+    if (pool != nullptr) {
+        pool->free(ctx, pool_handle);
+        pool = nullptr;
+        return;
     }
+    vertex_buffer.destroy(ctx);
+    index_buffer.destroy(ctx);
 }
@@ -0,0 +1,245 @@
+#include "kk_renderer/GeometryPool.h"
+#include "kk_renderer/RenderingContext.h"
+#include <algorithm>
+#include <cassert>
+
+using namespace kk::renderer;
+
+constexpr GeometryPool::Handle GeometryPool::kInvalidHandle;
+constexpr VkDeviceSize GeometryPool::kDefaultVertexSize;
+constexpr VkDeviceSize GeometryPool::kDefaultIndexSize;
+
+GeometryPool GeometryPool::create(RenderingContext& ctx, VkDeviceSize vertex_size, VkDeviceSize index_size) {
+    GeometryPool pool;
+    // NOTE: Transfer source for compaction
+    pool.vertex_buffer_ = Buffer::create(
+        ctx,
+        vertex_size,
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+    );
+    pool.index_buffer_ = Buffer::create(
+        ctx,
+        index_size,
+        VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+    );
+    pool.vertex_space_.init(vertex_size);
+    pool.index_space_.init(index_size);
+
+    return pool;
+}
+
+void GeometryPool::destroy(RenderingContext& ctx) {
+    vertex_buffer_.destroy(ctx);
+    index_buffer_.destroy(ctx);
+}
+
+GeometryPool::Handle GeometryPool::allocate(
+    RenderingContext& ctx,
+    const void* vertex_data,
+    VkDeviceSize vertex_size,
+    VkDeviceSize vertex_stride,
+    const void* index_data,
+    VkDeviceSize index_size,
+    VkIndexType index_type
+) {
+    assert(vertex_stride > 0 && vertex_stride % 4 == 0);
+    Entry entry{};
+    entry.range.vertex_size = vertex_size;
+    entry.range.index_size = index_size;
+    entry.range.index_type = index_type;
+    entry.vertex_stride = vertex_stride;
+    if (!allocateRanges(entry)) {
+        return kInvalidHandle;
+    }
+    entry.is_used = true;
+
+    // NOTE: Empty copies are invalid
+    if (vertex_size > 0) {
+        ctx.transfer.uploadBuffer(ctx, vertex_buffer_.buffer, entry.range.vertex_offset, vertex_data, vertex_size);
+    }
+    if (index_size > 0) {
+        ctx.transfer.uploadBuffer(
+            ctx,
+            index_buffer_.buffer,
+            entry.range.first_index * getIndexSize(index_type),
+            index_data,
+            index_size
+        );
+    }
+
+    Handle handle;
+    if (!free_handles_.empty()) {
+        handle = free_handles_.back();
+        free_handles_.pop_back();
+        entries_[handle] = entry;
+    }
+    else {
+        handle = static_cast<Handle>(entries_.size());
+        entries_.push_back(entry);
+    }
+
+    return handle;
+}
+
+void GeometryPool::free(RenderingContext& ctx, Handle handle) {
+    assert(handle < entries_.size() && entries_[handle].is_used);
+    // NOTE: In-flight frames may still draw from the ranges
+    GeometryPool* pool = this;
+    ctx.deletion_queue.push([pool, handle](RenderingContext&) {
+        pool->release(handle);
+    });
+}
+
+void GeometryPool::release(Handle handle) {
+    Entry& entry = entries_[handle];
+    vertex_space_.free(entry.vertex_node);
+    index_space_.free(entry.index_node);
+    entry.is_used = false;
+    free_handles_.push_back(handle);
+}
+
+bool GeometryPool::allocateRanges(Entry& entry) {
+    // Vertex data must start at a multiple of stride to be addressed by vertexOffset.
+    // Stride is not always power of 2 (e.g. Vertex), so the allocation has a stride of slack instead.
+    uint64_t vertex_offset = 0;
+    entry.vertex_node = vertex_space_.allocate(entry.range.vertex_size + entry.vertex_stride, 4, vertex_offset);
+    if (entry.vertex_node == Tlsf::kInvalidNode) {
+        return false;
+    }
+
+    const VkDeviceSize index_size = getIndexSize(entry.range.index_type);
+    uint64_t index_offset = 0;
+    entry.index_node = index_space_.allocate(entry.range.index_size, index_size, index_offset);
+    if (entry.index_node == Tlsf::kInvalidNode) {
+        vertex_space_.free(entry.vertex_node);
+        return false;
+    }
+
+    const VkDeviceSize base_vertex = (vertex_offset + entry.vertex_stride - 1) / entry.vertex_stride;
+    entry.range.base_vertex = static_cast<int32_t>(base_vertex);
+    entry.range.vertex_offset = base_vertex * entry.vertex_stride;
+    entry.range.first_index = static_cast<uint32_t>(index_offset / index_size);
+
+    return true;
+}
+
+void GeometryPool::compact(RenderingContext& ctx) {
+    // Uploads recorded into the pool must land before it is read back
+    ctx.transfer.flush(ctx);
+    ctx.transfer.wait(ctx);
+
+    // Re-allocate live ranges in address order from empty spaces. TLSF splits the front of the only free range,
+    // so ranges are packed in the same order.
+    std::vector<Handle> order;
+    for (Handle handle = 0; handle < entries_.size(); ++handle) {
+        if (entries_[handle].is_used) {
+            order.push_back(handle);
+        }
+    }
+    std::sort(order.begin(), order.end(), [this](Handle a, Handle b) {
+        return entries_[a].range.vertex_offset < entries_[b].range.vertex_offset;
+    });
+
+    const std::vector<Entry> old_entries = entries_;
+    vertex_space_ = Tlsf();
+    vertex_space_.init(vertex_buffer_.size);
+    index_space_ = Tlsf();
+    index_space_.init(index_buffer_.size);
+    std::vector<VkBufferCopy> vertex_copies, index_copies;
+    VkDeviceSize vertex_end = 0, index_end = 0;
+    for (Handle handle : order) {
+        Entry& entry = entries_[handle];
+        const Range& old_range = old_entries[handle].range;
+        // NOTE: Packed ranges always fit, since they fitted before
+        const bool is_allocated = allocateRanges(entry);
+        assert(is_allocated);
+        (void)is_allocated;
+
+        // Live data is staged in scratch buffers at the new offsets, then copied back at once
+        // NOTE: Source and destination regions of a copy within one buffer must not overlap
+        const VkDeviceSize index_size = getIndexSize(entry.range.index_type);
+        if (entry.range.vertex_size > 0) {
+            vertex_copies.push_back({ old_range.vertex_offset, entry.range.vertex_offset, entry.range.vertex_size });
+        }
+        if (entry.range.index_size > 0) {
+            index_copies.push_back({ old_range.first_index * index_size, entry.range.first_index * index_size, entry.range.index_size });
+        }
+        vertex_end = std::max(vertex_end, entry.range.vertex_offset + entry.range.vertex_size);
+        index_end = std::max(index_end, entry.range.first_index * index_size + entry.range.index_size);
+    }
+    if (vertex_copies.empty() && index_copies.empty()) {
+        return;
+    }
+
+    // NOTE: Either list may be empty (e.g. only geometries without indices), then that buffer is not copied
+    Buffer vertex_scratch{}, index_scratch{};
+    if (!vertex_copies.empty()) {
+        vertex_scratch = Buffer::create(
+            ctx,
+            vertex_end,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+        );
+    }
+    if (!index_copies.empty()) {
+        index_scratch = Buffer::create(
+            ctx,
+            index_end,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+        );
+    }
+    const VkBuffer vertex_buffer = vertex_buffer_.buffer, index_buffer = index_buffer_.buffer;
+    ctx.submitCmdsImmediate([&](VkCommandBuffer cmd_buf) {
+        if (!vertex_copies.empty()) {
+            vkCmdCopyBuffer(cmd_buf, vertex_buffer, vertex_scratch.buffer, static_cast<uint32_t>(vertex_copies.size()), vertex_copies.data());
+        }
+        if (!index_copies.empty()) {
+            vkCmdCopyBuffer(cmd_buf, index_buffer, index_scratch.buffer, static_cast<uint32_t>(index_copies.size()), index_copies.data());
+        }
+
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+        vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+        if (!vertex_copies.empty()) {
+            const VkBufferCopy vertex_back{ 0, 0, vertex_end };
+            vkCmdCopyBuffer(cmd_buf, vertex_scratch.buffer, vertex_buffer, 1, &vertex_back);
+        }
+        if (!index_copies.empty()) {
+            const VkBufferCopy index_back{ 0, 0, index_end };
+            vkCmdCopyBuffer(cmd_buf, index_scratch.buffer, index_buffer, 1, &index_back);
+        }
+
+        // Later draws read the pool
+        barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+        vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+    });
+    if (!vertex_copies.empty()) {
+        vertex_scratch.destroy(ctx);
+    }
+    if (!index_copies.empty()) {
+        index_scratch.destroy(ctx);
+    }
+}
+
+GeometryPool::Stats GeometryPool::getStats() const {
+    Stats stats{};
+    stats.allocation_count = vertex_space_.getAllocationCount();
+    stats.vertex_capacity = vertex_space_.getSize();
+    stats.vertex_used = vertex_space_.getUsedSize();
+    stats.vertex_largest_free = vertex_space_.getLargestFreeRange();
+    stats.index_capacity = index_space_.getSize();
+    stats.index_used = index_space_.getUsedSize();
+    stats.index_largest_free = index_space_.getLargestFreeRange();
+
+    return stats;
+}
+
+VkDeviceSize GeometryPool::getIndexSize(VkIndexType index_type) {
+    return (index_type == VK_INDEX_TYPE_UINT16) ? sizeof(uint16_t) : sizeof(uint32_t);
+}
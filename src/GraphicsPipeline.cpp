@@ -17,9 +17,13 @@ void GraphicsPipeline::setFragmentShader(const std::shared_ptr<Shader>& frag) {
 }
 
 void GraphicsPipeline::warmUp(RenderingContext& ctx, VkRenderPass render_pass) {
-    vkDeviceWaitIdle(ctx.device);
-    vkDestroyPipelineLayout(ctx.device, layout_, nullptr);
-    vkDestroyPipeline(ctx.device, pipeline_, nullptr);
+    // Old pipeline may be in use by in-flight frames
+    const VkPipelineLayout old_layout = layout_;
+    const VkPipeline old_pipeline = pipeline_;
+    ctx.deletion_queue.push([old_layout, old_pipeline](RenderingContext& ctx) {
+        vkDestroyPipelineLayout(ctx.device, old_layout, nullptr);
+        vkDestroyPipeline(ctx.device, old_pipeline, nullptr);
+    });
     layout_ = VK_NULL_HANDLE;
     pipeline_ = VK_NULL_HANDLE;
 
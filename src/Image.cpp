@@ -32,9 +32,14 @@ Image Image::create(
 }
 
 void Image::destroy(RenderingContext& ctx) {
-    vkDestroyImageView(ctx.device, view, nullptr);
-    vkFreeMemory(ctx.device, memory, nullptr);
-    vkDestroyImage(ctx.device, image, nullptr);
+    const VkImageView image_view = view;
+    const VkImage image_handle = image;
+    const Allocation image_allocation = allocation;
+    ctx.deletion_queue.push([image_view, image_handle, image_allocation](RenderingContext& ctx) {
+        vkDestroyImageView(ctx.device, image_view, nullptr);
+        vkDestroyImage(ctx.device, image_handle, nullptr);
+        ctx.allocator.free(image_allocation);
+    });
 }
 
 static void createImage(RenderingContext& ctx, Image& image) {
@@ -58,13 +63,9 @@ static void createImage(RenderingContext& ctx, Image& image) {
     // Allocate memory
     VkMemoryRequirements mem_reqs{};
     vkGetImageMemoryRequirements(ctx.device, image.image, &mem_reqs);
-    VkMemoryAllocateInfo alloc_info{};
-    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    alloc_info.allocationSize = mem_reqs.size;
-    alloc_info.memoryTypeIndex = ctx.findMemoryType(mem_reqs.memoryTypeBits, image.props);
-    assert(vkAllocateMemory(ctx.device, &alloc_info, nullptr, &image.memory) == VK_SUCCESS);
+    image.allocation = ctx.allocator.allocate(mem_reqs, image.props, image.tiling == VK_IMAGE_TILING_LINEAR);
 
-    vkBindImageMemory(ctx.device, image.image, image.memory, 0);
+    assert(vkBindImageMemory(ctx.device, image.image, image.allocation.memory, image.allocation.offset) == VK_SUCCESS);
 }
 
 static void createImageView(RenderingContext& ctx, Image& image) {
@@ -0,0 +1,109 @@
+#include "kk_renderer/MappedFile.h"
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace kk::renderer;
+
+bool kk::renderer::getFileStamp(const std::string& path, uint64_t& size, int64_t& mtime) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        return false;
+    }
+    size = static_cast<uint64_t>(st.st_size);
+    mtime = static_cast<int64_t>(st.st_mtime);
+    return true;
+}
+
+#ifdef _WIN32
+MappedFile MappedFile::create(const std::string& path) {
+    MappedFile file{};
+    file.handle_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file.handle_ == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("Failed to open " + path);
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file.handle_, &size)) {
+        CloseHandle(file.handle_);
+        throw std::runtime_error("Failed to get size of " + path);
+    }
+    file.size = static_cast<size_t>(size.QuadPart);
+    if (file.size == 0) {
+        // NOTE: Empty file cannot be mapped
+        return file;
+    }
+
+    file.mapping_ = CreateFileMappingA(file.handle_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (file.mapping_ == nullptr) {
+        CloseHandle(file.handle_);
+        throw std::runtime_error("Failed to map " + path);
+    }
+    file.data = static_cast<const char*>(MapViewOfFile(file.mapping_, FILE_MAP_READ, 0, 0, 0));
+    if (file.data == nullptr) {
+        CloseHandle(file.mapping_);
+        CloseHandle(file.handle_);
+        throw std::runtime_error("Failed to map " + path);
+    }
+
+    return file;
+}
+
+void MappedFile::destroy() {
+    if (data != nullptr) {
+        UnmapViewOfFile(data);
+        CloseHandle(mapping_);
+    }
+    CloseHandle(handle_);
+    data = nullptr;
+    size = 0;
+}
+#else
+MappedFile MappedFile::create(const std::string& path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open " + path);
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw std::runtime_error("Failed to get size of " + path);
+    }
+
+    MappedFile file{};
+    file.size = static_cast<size_t>(st.st_size);
+    if (file.size > 0) {
+        void* data = mmap(nullptr, file.size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("Failed to map " + path);
+        }
+        // Whole file is about to be read, by several threads at once
+        madvise(data, file.size, MADV_WILLNEED);
+        file.data = static_cast<const char*>(data);
+    }
+    // NOTE: Mapping stays valid after the descriptor is closed
+    close(fd);
+
+    return file;
+}
+
+void MappedFile::destroy() {
+    if (data != nullptr) {
+        munmap(const_cast<char*>(data), size);
+    }
+    data = nullptr;
+    size = 0;
+}
+#endif
@@ -9,18 +9,47 @@ using namespace kk::renderer;
 
 Material::Material() :
     is_compiled_(false),
+    vertex_format_(VertexFormat::kFloat),
+    desc_set_(VK_NULL_HANDLE),
     pipeline_layout_(VK_NULL_HANDLE),
-    pipeline_(VK_NULL_HANDLE) {
+    render_pass_(VK_NULL_HANDLE) {
+    static uint32_t next_id = 0;
+
+    pipelines_.fill(VK_NULL_HANDLE);
+    instanced_pipelines_.fill(VK_NULL_HANDLE);
+
     setDefault();
+
+    // TODO: Reuse destructed id
+    id_ = next_id++;
 }
 
 void Material::destroy(RenderingContext& ctx) {
-    vkDestroyPipeline(ctx.device, pipeline_, nullptr);
-    vkDestroyPipelineLayout(ctx.device, pipeline_layout_, nullptr);
-    
-    for (const auto& desc_layout : desc_layouts_) {
-        vkDestroyDescriptorSetLayout(ctx.device, desc_layout, nullptr);
+    // NOTE: Pipeline may be in use by in-flight frames
+    std::vector<VkPipeline> pipelines;
+    for (size_t i = 0; i < kVertexFormatCount; ++i) {
+        for (VkPipeline pipeline : { pipelines_[i], instanced_pipelines_[i] }) {
+            if (pipeline != VK_NULL_HANDLE) {
+                pipelines.push_back(pipeline);
+            }
+        }
     }
+    const VkPipelineLayout pipeline_layout = pipeline_layout_;
+    const std::vector<VkDescriptorSetLayout> desc_layouts = desc_layouts_;
+    const VkDescriptorSet desc_set = desc_set_;
+    ctx.deletion_queue.push([pipelines, pipeline_layout, desc_layouts, desc_set](RenderingContext& ctx) {
+        if (desc_set != VK_NULL_HANDLE) {
+            vkFreeDescriptorSets(ctx.device, ctx.desc_pool, 1, &desc_set);
+        }
+        for (VkPipeline pipeline : pipelines) {
+            vkDestroyPipeline(ctx.device, pipeline, nullptr);
+        }
+        vkDestroyPipelineLayout(ctx.device, pipeline_layout, nullptr);
+
+        for (const auto& desc_layout : desc_layouts) {
+            vkDestroyDescriptorSetLayout(ctx.device, desc_layout, nullptr);
+        }
+    });
 }
 
 void Material::compile(RenderingContext& ctx, VkRenderPass render_pass) {
@@ -28,9 +57,52 @@ void Material::compile(RenderingContext& ctx, VkRenderPass render_pass) {
     
     buildDescLayout(ctx);
     buildPipelineLayout(ctx, desc_layouts_);
-    buildPipeline(ctx, pipeline_layout_, render_pass);
+    render_pass_ = render_pass;
+    buildDescSet(ctx);
 
     is_compiled_ = true;
+    preparePipelines(ctx, vertex_format_);
+}
+
+void Material::preparePipelines(RenderingContext& ctx, VertexFormat format) {
+    assert(is_compiled_);
+    const size_t idx = static_cast<size_t>(format);
+    if (pipelines_[idx] != VK_NULL_HANDLE) {
+        return;
+    }
+
+    pipelines_[idx] = buildPipeline(ctx, format, *vert_, false);
+    if (vert_instanced_ != nullptr) {
+        instanced_pipelines_[idx] = buildPipeline(ctx, format, *vert_instanced_, true);
+    }
+}
+
+void Material::buildDescSet(RenderingContext& ctx) {
+    if (desc_layouts_.empty() || texture_ == nullptr) {
+        return;
+    }
+
+    // NOTE: Texture is never written by GPU, so one set serves every frame in flight
+    VkDescriptorSetAllocateInfo alloc_info{};
+    alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    alloc_info.descriptorPool = ctx.desc_pool;
+    alloc_info.descriptorSetCount = 1;
+    alloc_info.pSetLayouts = &desc_layouts_[0];
+    assert(vkAllocateDescriptorSets(ctx.device, &alloc_info, &desc_set_) == VK_SUCCESS);
+
+    VkDescriptorImageInfo tex_info{};
+    tex_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    tex_info.imageView = texture_->view;
+    tex_info.sampler = texture_->sampler;
+
+    VkWriteDescriptorSet write_texture{};
+    write_texture.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write_texture.dstSet = desc_set_;
+    write_texture.dstBinding = 0;
+    write_texture.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write_texture.descriptorCount = 1;
+    write_texture.pImageInfo = &tex_info;
+    vkUpdateDescriptorSets(ctx.device, 1, &write_texture, 0, nullptr);
 }
 
 void Material::buildDescLayout(RenderingContext& ctx) {
@@ -64,12 +136,12 @@ void Material::buildPipelineLayout(RenderingContext& ctx, const std::vector<VkDe
     assert(vkCreatePipelineLayout(ctx.device, &info, nullptr, &pipeline_layout_) == VK_SUCCESS);
 }
 
-void Material::buildPipeline(RenderingContext& ctx, VkPipelineLayout layout, VkRenderPass render_pass) {
+VkPipeline Material::buildPipeline(RenderingContext& ctx, VertexFormat format, const Shader& vert, bool is_instanced) {
     std::array<VkPipelineShaderStageCreateInfo, 2> shader_stages{};
     // Set vertex shader info
     shader_stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
     shader_stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
-    shader_stages[0].module = vert_->module;
+    shader_stages[0].module = vert.module;
     shader_stages[0].pName = "main";
     // Set fragment shader info
     shader_stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -77,12 +149,20 @@ void Material::buildPipeline(RenderingContext& ctx, VkPipelineLayout layout, VkR
     shader_stages[1].module = frag_->module;
     shader_stages[1].pName = "main";
 
-    const auto binding_desc = Vertex::getBindingDescription();
-    const auto attr_desc = Vertex::getAttributeDescriptions();
+    std::vector<VkVertexInputBindingDescription> binding_desc;
+    std::vector<VkVertexInputAttributeDescription> attr_desc;
+    getVertexInputDescriptions(format, binding_desc, attr_desc);
+    if (is_instanced) {
+        binding_desc.push_back(InstanceData::getBindingDescription());
+        for (const auto& attr : InstanceData::getAttributeDescriptions()) {
+            attr_desc.push_back(attr);
+        }
+    }
+
     VkPipelineVertexInputStateCreateInfo vert_input{};
     vert_input.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-    vert_input.vertexBindingDescriptionCount = 1;
-    vert_input.pVertexBindingDescriptions = &binding_desc;
+    vert_input.vertexBindingDescriptionCount = static_cast<uint32_t>(binding_desc.size());
+    vert_input.pVertexBindingDescriptions = binding_desc.data();
     vert_input.vertexAttributeDescriptionCount = static_cast<uint32_t>(attr_desc.size());
     vert_input.pVertexAttributeDescriptions = attr_desc.data();
 
@@ -106,11 +186,14 @@ void Material::buildPipeline(RenderingContext& ctx, VkPipelineLayout layout, VkR
     info.pDepthStencilState = &depth_stencil_;
     info.pColorBlendState = &color_blending_;
     info.pDynamicState = &dynamic_state;
-    info.layout = layout;
-    info.renderPass = render_pass;
+    info.layout = pipeline_layout_;
+    info.renderPass = render_pass_;
     info.subpass = 0; // TODO
 
-    assert(vkCreateGraphicsPipelines(ctx.device, VK_NULL_HANDLE, 1, &info, nullptr, &pipeline_) == VK_SUCCESS);
+    VkPipeline pipeline;
+    assert(vkCreateGraphicsPipelines(ctx.device, VK_NULL_HANDLE, 1, &info, nullptr, &pipeline) == VK_SUCCESS);
+
+    return pipeline;
 }
 
 void Material::setDefault() {
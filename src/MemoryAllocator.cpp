@@ -0,0 +1,202 @@
+#include "kk_renderer/MemoryAllocator.h"
+#include <iostream>
+#include <cassert>
+
+using namespace kk::renderer;
+
+constexpr uint32_t MemoryAllocator::kDedicatedBlock;
+constexpr VkDeviceSize MemoryAllocator::kDefaultBlockSize;
+
+MemoryAllocator MemoryAllocator::create(VkPhysicalDevice gpu, VkDevice device) {
+    MemoryAllocator allocator{};
+    allocator.device_ = device;
+    vkGetPhysicalDeviceMemoryProperties(gpu, &allocator.mem_props_);
+
+    VkPhysicalDeviceProperties props{};
+    vkGetPhysicalDeviceProperties(gpu, &props);
+    allocator.granularity_ = props.limits.bufferImageGranularity;
+
+    for (uint32_t i = 0; i < allocator.pools_.size(); ++i) {
+        Pool& pool = allocator.pools_[i];
+        pool.memory_type = i / 2;
+        pool.block_size = kDefaultBlockSize;
+        if (pool.memory_type < allocator.mem_props_.memoryTypeCount) {
+            // Keep several blocks fit in small heaps (e.g. 256 MiB BAR heap)
+            const uint32_t heap = allocator.mem_props_.memoryTypes[pool.memory_type].heapIndex;
+            const VkDeviceSize heap_size = allocator.mem_props_.memoryHeaps[heap].size;
+            while (pool.block_size > heap_size / 8 && pool.block_size > 1024 * 1024) {
+                pool.block_size /= 2;
+            }
+        }
+    }
+
+    return allocator;
+}
+
+void MemoryAllocator::destroy() {
+    const Stats stats = getStats();
+    if (stats.allocation_count != 0) {
+        std::cerr << "MemoryAllocator::destroy(): WARNING: " << stats.allocation_count << " allocations are still alive" << std::endl;
+    }
+
+    for (auto& pool : pools_) {
+        for (auto& block : pool.blocks) {
+            if (block.memory != VK_NULL_HANDLE) {
+                vkFreeMemory(device_, block.memory, nullptr);
+            }
+        }
+        pool.blocks.clear();
+    }
+}
+
+Allocation MemoryAllocator::allocate(const VkMemoryRequirements& reqs, VkMemoryPropertyFlags props, bool is_linear) {
+    const uint32_t memory_type = findMemoryType(reqs.memoryTypeBits, props);
+    // NOTE: If granularity is 1, linear and optimal resources never conflict
+    const uint32_t pool_idx = memory_type * 2 + ((is_linear || granularity_ <= 1) ? 0 : 1);
+    Pool& pool = pools_[pool_idx];
+
+    Allocation allocation{};
+    allocation.pool = pool_idx;
+    allocation.size = reqs.size;
+
+    // Large resources get their own memory
+    if (reqs.size > pool.block_size / 2) {
+        allocation.memory = allocateMemory(reqs.size, memory_type, &allocation.mapped);
+        allocation.offset = 0;
+        allocation.block = kDedicatedBlock;
+        allocation.node = Tlsf::kInvalidNode;
+        ++dedicated_count_;
+        dedicated_size_ += reqs.size;
+        return allocation;
+    }
+
+    // Find a block with enough space
+    uint32_t block_idx = kDedicatedBlock;
+    uint64_t offset = 0;
+    for (uint32_t i = 0; i < pool.blocks.size(); ++i) {
+        if (pool.blocks[i].memory == VK_NULL_HANDLE) {
+            continue;
+        }
+        allocation.node = pool.blocks[i].tlsf.allocate(reqs.size, reqs.alignment, offset);
+        if (allocation.node != Tlsf::kInvalidNode) {
+            block_idx = i;
+            break;
+        }
+    }
+
+    // Create new block, reusing a released slot if any
+    if (block_idx == kDedicatedBlock) {
+        for (uint32_t i = 0; i < pool.blocks.size(); ++i) {
+            if (pool.blocks[i].memory == VK_NULL_HANDLE) {
+                block_idx = i;
+                break;
+            }
+        }
+        if (block_idx == kDedicatedBlock) {
+            block_idx = static_cast<uint32_t>(pool.blocks.size());
+            pool.blocks.push_back(Block{});
+        }
+
+        Block& block = pool.blocks[block_idx];
+        block.memory = allocateMemory(pool.block_size, memory_type, &block.mapped);
+        block.tlsf.init(pool.block_size);
+        allocation.node = block.tlsf.allocate(reqs.size, reqs.alignment, offset);
+        assert(allocation.node != Tlsf::kInvalidNode);
+    }
+
+    const Block& block = pool.blocks[block_idx];
+    allocation.memory = block.memory;
+    allocation.offset = offset;
+    allocation.block = block_idx;
+    allocation.mapped = (block.mapped != nullptr) ? static_cast<char*>(block.mapped) + offset : nullptr;
+
+    return allocation;
+}
+
+void MemoryAllocator::free(const Allocation& allocation) {
+    if (allocation.memory == VK_NULL_HANDLE) {
+        return;
+    }
+
+    if (allocation.block == kDedicatedBlock) {
+        vkFreeMemory(device_, allocation.memory, nullptr);
+        --dedicated_count_;
+        dedicated_size_ -= allocation.size;
+        return;
+    }
+
+    Pool& pool = pools_[allocation.pool];
+    Block& block = pool.blocks[allocation.block];
+    block.tlsf.free(allocation.node);
+
+    if (block.tlsf.isEmpty()) {
+        // Keep one empty block per pool to avoid allocation thrashing
+        uint32_t live_blocks = 0;
+        for (const auto& b : pool.blocks) {
+            live_blocks += (b.memory != VK_NULL_HANDLE) ? 1 : 0;
+        }
+        if (live_blocks > 1) {
+            vkFreeMemory(device_, block.memory, nullptr);
+            block.memory = VK_NULL_HANDLE;
+            block.mapped = nullptr;
+        }
+    }
+}
+
+MemoryAllocator::Stats MemoryAllocator::getStats() const {
+    Stats stats{};
+    stats.dedicated_count = dedicated_count_;
+    stats.allocation_count = dedicated_count_;
+    stats.reserved_size = dedicated_size_;
+    stats.used_size = dedicated_size_;
+
+    VkDeviceSize free_size = 0;
+    for (const auto& pool : pools_) {
+        for (const auto& block : pool.blocks) {
+            if (block.memory == VK_NULL_HANDLE) {
+                continue;
+            }
+
+            const VkDeviceSize largest = block.tlsf.getLargestFreeRange();
+            ++stats.block_count;
+            stats.allocation_count += block.tlsf.getAllocationCount();
+            stats.reserved_size += block.tlsf.getSize();
+            stats.used_size += block.tlsf.getUsedSize();
+            stats.largest_free_range = (largest > stats.largest_free_range) ? largest : stats.largest_free_range;
+            free_size += block.tlsf.getFreeSize();
+        }
+    }
+    stats.fragmentation = (free_size == 0) ? 0.0f : 1.0f - static_cast<float>(stats.largest_free_range) / free_size;
+
+    return stats;
+}
+
+uint32_t MemoryAllocator::findMemoryType(uint32_t type_filter, VkMemoryPropertyFlags props) const {
+    for (uint32_t i = 0; i < mem_props_.memoryTypeCount; i++) {
+        if ((type_filter & (1 << i)) && (mem_props_.memoryTypes[i].propertyFlags & props) == props) {
+            return i;
+        }
+    }
+
+    std::cerr << "Error: Memory property " << props << " not found" << std::endl;
+    assert(false);
+    return UINT32_MAX;
+}
+
+VkDeviceMemory MemoryAllocator::allocateMemory(VkDeviceSize size, uint32_t memory_type, void** mapped) {
+    VkMemoryAllocateInfo alloc_info{};
+    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    alloc_info.allocationSize = size;
+    alloc_info.memoryTypeIndex = memory_type;
+
+    VkDeviceMemory memory;
+    assert(vkAllocateMemory(device_, &alloc_info, nullptr, &memory) == VK_SUCCESS);
+
+    // Host visible memory is mapped once for its lifetime
+    *mapped = nullptr;
+    if (mem_props_.memoryTypes[memory_type].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        assert(vkMapMemory(device_, memory, 0, VK_WHOLE_SIZE, 0, mapped) == VK_SUCCESS);
+    }
+
+    return memory;
+}
@@ -0,0 +1,807 @@
+#include "kk_renderer/MeshOptimizer.h"
+#include <algorithm>
+#include <numeric>
+#include <cassert>
+#include <cmath>
+#include <tuple>
+
+using namespace kk;
+using namespace kk::renderer;
+
+// Triangles adjacent to each vertex in compressed form
+struct TriangleAdjacency {
+    std::vector<uint32_t> offsets; // vertex_count + 1
+    std::vector<uint32_t> triangles;
+};
+
+static TriangleAdjacency buildAdjacency(const std::vector<uint32_t>& indices, size_t vertex_count) {
+    TriangleAdjacency adjacency;
+    adjacency.offsets.assign(vertex_count + 1, 0);
+    for (uint32_t index : indices) {
+        ++adjacency.offsets[index + 1];
+    }
+    for (size_t v = 0; v < vertex_count; ++v) {
+        adjacency.offsets[v + 1] += adjacency.offsets[v];
+    }
+
+    adjacency.triangles.resize(indices.size());
+    std::vector<uint32_t> cursor(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+    for (size_t i = 0; i < indices.size(); ++i) {
+        adjacency.triangles[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    return adjacency;
+}
+
+// FIFO cache simulation. Returns true on miss.
+class FifoCache {
+public:
+    FifoCache(size_t vertex_count, size_t cache_size)
+        : cache_size_(cache_size), timestamps_(vertex_count, 0), time_(cache_size + 1) {}
+
+    bool access(uint32_t vertex) {
+        if (time_ - timestamps_[vertex] > cache_size_) {
+            timestamps_[vertex] = time_++;
+            return true;
+        }
+        return false;
+    }
+
+private:
+    size_t cache_size_;
+    std::vector<size_t> timestamps_;
+    size_t time_;
+};
+
+VertexCacheStats kk::renderer::analyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertex_count, size_t cache_size) {
+    VertexCacheStats stats{};
+    if (indices.empty()) {
+        return stats;
+    }
+
+    FifoCache cache(vertex_count, cache_size);
+    std::vector<uint8_t> is_referenced(vertex_count, 0);
+    size_t misses = 0, referenced = 0;
+    for (uint32_t index : indices) {
+        misses += cache.access(index) ? 1 : 0;
+        referenced += is_referenced[index] ? 0 : 1;
+        is_referenced[index] = 1;
+    }
+
+    stats.acmr = static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+    stats.atvr = static_cast<float>(misses) / static_cast<float>(referenced);
+    return stats;
+}
+
+void kk::renderer::optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertex_count, size_t cache_size) {
+    assert(indices.size() % 3 == 0);
+    const size_t triangle_count = indices.size() / 3;
+    if (triangle_count == 0) {
+        return;
+    }
+
+    const TriangleAdjacency adjacency = buildAdjacency(indices, vertex_count);
+    std::vector<uint32_t> live(vertex_count);
+    for (size_t v = 0; v < vertex_count; ++v) {
+        live[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+    }
+    std::vector<size_t> cache_time(vertex_count, 0);
+    std::vector<uint8_t> is_emitted(triangle_count, 0);
+    std::vector<uint32_t> dead_end;   // Recently referenced vertices, to restart from
+    std::vector<uint32_t> candidates; // Vertices of the triangles just emitted
+    size_t time = cache_size + 1;
+    size_t cursor = 0; // Next vertex to restart from if dead end stack is exhausted
+
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+
+    int64_t fanning = indices[0];
+    while (fanning >= 0) {
+        // Emit every triangle around the fanning vertex
+        candidates.clear();
+        for (uint32_t i = adjacency.offsets[fanning]; i < adjacency.offsets[fanning + 1]; ++i) {
+            const uint32_t triangle = adjacency.triangles[i];
+            if (is_emitted[triangle]) {
+                continue;
+            }
+            for (size_t k = 0; k < 3; ++k) {
+                const uint32_t v = indices[triangle * 3 + k];
+                result.push_back(v);
+                dead_end.push_back(v);
+                candidates.push_back(v);
+                --live[v];
+                if (time - cache_time[v] > cache_size) {
+                    cache_time[v] = time++;
+                }
+            }
+            is_emitted[triangle] = 1;
+        }
+
+        // Next fanning vertex: the oldest candidate still in cache after its remaining triangles are emitted
+        int64_t best = -1;
+        int64_t best_priority = -1;
+        for (uint32_t v : candidates) {
+            if (live[v] == 0) {
+                continue;
+            }
+            int64_t priority = 0;
+            if (time - cache_time[v] + 2 * live[v] <= cache_size) {
+                priority = static_cast<int64_t>(time - cache_time[v]);
+            }
+            if (priority > best_priority) {
+                best_priority = priority;
+                best = v;
+            }
+        }
+
+        if (best < 0) {
+            // Dead end: restart from a recently used vertex, then from any vertex with triangles left
+            while (!dead_end.empty() && best < 0) {
+                const uint32_t v = dead_end.back();
+                dead_end.pop_back();
+                if (live[v] > 0) {
+                    best = v;
+                }
+            }
+            while (best < 0 && cursor < vertex_count) {
+                if (live[cursor] > 0) {
+                    best = static_cast<int64_t>(cursor);
+                }
+                ++cursor;
+            }
+        }
+        fanning = best;
+    }
+
+    assert(result.size() == indices.size());
+    indices.swap(result);
+}
+
+void kk::renderer::optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, size_t cache_size) {
+    const size_t triangle_count = indices.size() / 3;
+    if (triangle_count == 0) {
+        return;
+    }
+
+    // Cut clusters where every vertex of a triangle misses, that is, where the cache optimiser restarted
+    std::vector<size_t> cluster_begins;
+    FifoCache cache(vertices.size(), cache_size);
+    for (size_t t = 0; t < triangle_count; ++t) {
+        size_t misses = 0;
+        for (size_t k = 0; k < 3; ++k) {
+            misses += cache.access(indices[t * 3 + k]) ? 1 : 0;
+        }
+        if (t == 0 || misses == 3) {
+            cluster_begins.push_back(t);
+        }
+    }
+    cluster_begins.push_back(triangle_count);
+    const size_t cluster_count = cluster_begins.size() - 1;
+
+    // Mesh centroid, weighted by triangle area
+    Vec3 mesh_center(0.0f);
+    float mesh_area = 0.0f;
+    std::vector<Vec3> centers(cluster_count, Vec3(0.0f)), normals(cluster_count, Vec3(0.0f));
+    std::vector<float> areas(cluster_count, 0.0f);
+    for (size_t c = 0; c < cluster_count; ++c) {
+        for (size_t t = cluster_begins[c]; t < cluster_begins[c + 1]; ++t) {
+            const Vec3& p0 = vertices[indices[t * 3 + 0]].position;
+            const Vec3& p1 = vertices[indices[t * 3 + 1]].position;
+            const Vec3& p2 = vertices[indices[t * 3 + 2]].position;
+            const Vec3 normal = glm::cross(p1 - p0, p2 - p0); // Length is twice the area
+            const float area = glm::length(normal);
+            centers[c] += (p0 + p1 + p2) * (area / 3.0f);
+            normals[c] += normal;
+            areas[c] += area;
+        }
+        mesh_center += centers[c];
+        mesh_area += areas[c];
+    }
+    if (mesh_area > 0.0f) {
+        mesh_center /= mesh_area;
+    }
+
+    // Clusters far out along their facing direction are likely to occlude others, so draw them first
+    std::vector<float> keys(cluster_count, 0.0f);
+    for (size_t c = 0; c < cluster_count; ++c) {
+        const float normal_length = glm::length(normals[c]);
+        if (areas[c] > 0.0f && normal_length > 0.0f) {
+            keys[c] = glm::dot(centers[c] / areas[c] - mesh_center, normals[c] / normal_length);
+        }
+    }
+    std::vector<uint32_t> order(cluster_count);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&keys](uint32_t a, uint32_t b) {
+        return keys[a] > keys[b];
+    });
+
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+    for (uint32_t c : order) {
+        result.insert(result.end(), indices.begin() + cluster_begins[c] * 3, indices.begin() + cluster_begins[c + 1] * 3);
+    }
+    indices.swap(result);
+}
+
+void kk::renderer::optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+    constexpr uint32_t kUnmapped = UINT32_MAX;
+    std::vector<uint32_t> remap(vertices.size(), kUnmapped);
+    std::vector<Vertex> result;
+    result.reserve(vertices.size());
+
+    for (auto& index : indices) {
+        if (remap[index] == kUnmapped) {
+            remap[index] = static_cast<uint32_t>(result.size());
+            result.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+    vertices.swap(result);
+}
+
+void kk::renderer::optimizeMesh(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+    optimizeVertexCache(indices, vertices.size());
+    optimizeOverdraw(indices, vertices);
+    optimizeVertexFetch(vertices, indices);
+}
+
+// Quadric of weighted squared distances to planes: upper triangle of symmetric 4x4 matrix
+struct SimplifyQuadric {
+    double a00, a01, a02, a03, a11, a12, a13, a22, a23, a33;
+    double area; // Triangle area accumulated, to normalise the error into a distance
+};
+
+// Collapse of every wedge (vertex) at position `from` into a wedge at position `to`
+struct SimplifyCollapse {
+    uint32_t from, to;
+    float error;
+};
+
+enum SimplifyVertexKind : uint8_t {
+    kSimplifyManifold, // Collapses to any neighbour
+    kSimplifyBorder,   // Collapses only along the border
+    kSimplifySeam,     // Two wedges split by UV seam. Collapses only along the seam.
+    kSimplifyLocked,   // Corners of borders and seams, and non-manifold vertices
+};
+
+static constexpr uint32_t kSimplifyInvalid = UINT32_MAX;
+
+static void addPlane(SimplifyQuadric& q, const Vec3& normal, const Vec3& point, double weight) {
+    const double a = normal.x, b = normal.y, c = normal.z;
+    const double d = -(a * point.x + b * point.y + c * point.z);
+    q.a00 += weight * a * a; q.a01 += weight * a * b; q.a02 += weight * a * c; q.a03 += weight * a * d;
+    q.a11 += weight * b * b; q.a12 += weight * b * c; q.a13 += weight * b * d;
+    q.a22 += weight * c * c; q.a23 += weight * c * d;
+    q.a33 += weight * d * d;
+}
+
+static void addQuadric(SimplifyQuadric& dst, const SimplifyQuadric& src) {
+    dst.a00 += src.a00; dst.a01 += src.a01; dst.a02 += src.a02; dst.a03 += src.a03;
+    dst.a11 += src.a11; dst.a12 += src.a12; dst.a13 += src.a13;
+    dst.a22 += src.a22; dst.a23 += src.a23;
+    dst.a33 += src.a33;
+    dst.area += src.area;
+}
+
+static double evaluateQuadric(const SimplifyQuadric& q, const Vec3& p) {
+    const double x = p.x, y = p.y, z = p.z;
+    const double r =
+        q.a00 * x * x + q.a11 * y * y + q.a22 * z * z +
+        2.0 * (q.a01 * x * y + q.a02 * x * z + q.a12 * y * z) +
+        2.0 * (q.a03 * x + q.a13 * y + q.a23 * z) +
+        q.a33;
+    return std::max(r, 0.0);
+}
+
+static uint64_t edgeKey(uint32_t a, uint32_t b) {
+    return (static_cast<uint64_t>(a) << 32) | b;
+}
+
+static bool hasEdge(const std::vector<uint64_t>& sorted_edges, uint32_t a, uint32_t b) {
+    return std::binary_search(sorted_edges.begin(), sorted_edges.end(), edgeKey(a, b));
+}
+
+size_t kk::renderer::simplifyMesh(
+    const std::vector<Vertex>& vertices,
+    const uint32_t* indices,
+    size_t index_count,
+    size_t target_index_count,
+    float target_error,
+    std::vector<uint32_t>& dst,
+    float* result_error
+) {
+    assert(index_count % 3 == 0);
+    dst.assign(indices, indices + index_count);
+    if (result_error != nullptr) {
+        *result_error = 0.0f;
+    }
+    if (dst.size() <= target_index_count) {
+        return dst.size();
+    }
+    const size_t vertex_count = vertices.size();
+
+    // Group referenced vertices sharing a position. A group is named after its first vertex, and its vertices (wedges) form a ring.
+    std::vector<uint32_t> referenced;
+    {
+        std::vector<uint8_t> is_referenced(vertex_count, 0);
+        for (uint32_t index : dst) {
+            if (!is_referenced[index]) {
+                is_referenced[index] = 1;
+                referenced.push_back(index);
+            }
+        }
+    }
+    std::sort(referenced.begin(), referenced.end(), [&vertices](uint32_t a, uint32_t b) {
+        const Vec3& pa = vertices[a].position;
+        const Vec3& pb = vertices[b].position;
+        return std::tie(pa.x, pa.y, pa.z, a) < std::tie(pb.x, pb.y, pb.z, b);
+    });
+    std::vector<uint32_t> group(vertex_count, kSimplifyInvalid), next_wedge(vertex_count, kSimplifyInvalid);
+    for (size_t i = 0; i < referenced.size();) {
+        size_t end = i + 1;
+        while (end < referenced.size() && vertices[referenced[end]].position == vertices[referenced[i]].position) {
+            ++end;
+        }
+        for (size_t k = i; k < end; ++k) {
+            group[referenced[k]] = referenced[i];
+            next_wedge[referenced[k]] = referenced[k + 1 < end ? k + 1 : i];
+        }
+        i = end;
+    }
+
+    // Directed edges of wedges and of groups. An edge without its opposite is open.
+    const size_t triangle_count = dst.size() / 3;
+    std::vector<uint64_t> edges, group_edges;
+    edges.reserve(dst.size());
+    group_edges.reserve(dst.size());
+    for (size_t i = 0; i < dst.size(); ++i) {
+        const uint32_t a = dst[i], b = dst[i - i % 3 + (i + 1) % 3];
+        edges.push_back(edgeKey(a, b));
+        group_edges.push_back(edgeKey(group[a], group[b]));
+    }
+    std::sort(edges.begin(), edges.end());
+    std::sort(group_edges.begin(), group_edges.end());
+
+    // Quadrics of triangle planes, plus planes perpendicular to border edges to keep the outline
+    // NOTE: Border edges are open in position space, seam edges only between wedges
+    std::vector<SimplifyQuadric> quadrics(vertex_count, SimplifyQuadric{});
+    std::vector<uint32_t> border_counts(vertex_count, 0), seam_counts(vertex_count, 0);
+    std::vector<uint64_t> border_edges, seam_edges; // Undirected, between groups
+    for (size_t t = 0; t < triangle_count; ++t) {
+        const uint32_t g[3] = { group[dst[t * 3 + 0]], group[dst[t * 3 + 1]], group[dst[t * 3 + 2]] };
+        const Vec3& p0 = vertices[g[0]].position;
+        Vec3 normal = glm::cross(vertices[g[1]].position - p0, vertices[g[2]].position - p0);
+        const float length = glm::length(normal);
+        if (length > 0.0f) {
+            normal /= length;
+            for (size_t k = 0; k < 3; ++k) {
+                addPlane(quadrics[g[k]], normal, p0, length * 0.5f);
+                quadrics[g[k]].area += length * 0.5f;
+            }
+        }
+
+        for (size_t k = 0; k < 3; ++k) {
+            const uint32_t a = dst[t * 3 + k], b = dst[t * 3 + (k + 1) % 3];
+            if (hasEdge(edges, b, a)) {
+                continue;
+            }
+            const uint32_t ga = group[a], gb = group[b];
+            const uint64_t key = edgeKey(std::min(ga, gb), std::max(ga, gb));
+            if (hasEdge(group_edges, gb, ga)) {
+                ++seam_counts[ga];
+                ++seam_counts[gb];
+                seam_edges.push_back(key);
+            }
+            else {
+                ++border_counts[ga];
+                ++border_counts[gb];
+                border_edges.push_back(key);
+                const Vec3 edge = vertices[gb].position - vertices[ga].position;
+                const Vec3 side = glm::cross(edge, normal);
+                const float side_length = glm::length(side);
+                if (length > 0.0f && side_length > 0.0f) {
+                    addPlane(quadrics[ga], side / side_length, vertices[ga].position, glm::dot(edge, edge));
+                    addPlane(quadrics[gb], side / side_length, vertices[ga].position, glm::dot(edge, edge));
+                }
+            }
+        }
+    }
+    std::sort(border_edges.begin(), border_edges.end());
+    std::sort(seam_edges.begin(), seam_edges.end());
+
+    std::vector<uint8_t> kinds(vertex_count, kSimplifyLocked);
+    for (uint32_t v : referenced) {
+        if (group[v] != v) {
+            continue;
+        }
+        size_t wedge_count = 1;
+        for (uint32_t w = next_wedge[v]; w != v; w = next_wedge[w]) {
+            ++wedge_count;
+        }
+        // Interior of a border line has 2 border edges, and of a seam line 2 seam edges seen from both sides
+        if (wedge_count == 1 && border_counts[v] == 0 && seam_counts[v] == 0) {
+            kinds[v] = kSimplifyManifold;
+        }
+        else if (wedge_count == 1 && border_counts[v] == 2 && seam_counts[v] == 0) {
+            kinds[v] = kSimplifyBorder;
+        }
+        else if (wedge_count == 2 && border_counts[v] == 0 && seam_counts[v] == 4) {
+            kinds[v] = kSimplifySeam;
+        }
+    }
+
+    const auto canCollapse = [&](uint32_t from, uint32_t to) {
+        switch (kinds[from]) {
+        case kSimplifyManifold:
+            return true;
+        case kSimplifyBorder:
+            return std::binary_search(border_edges.begin(), border_edges.end(), edgeKey(std::min(from, to), std::max(from, to)));
+        case kSimplifySeam:
+            return std::binary_search(seam_edges.begin(), seam_edges.end(), edgeKey(std::min(from, to), std::max(from, to)));
+        default:
+            return false;
+        }
+    };
+
+    std::vector<uint32_t> collapse_remap(vertex_count);
+    std::iota(collapse_remap.begin(), collapse_remap.end(), 0);
+    std::vector<uint8_t> is_touched(vertex_count);
+    std::vector<uint32_t> group_indices;
+    std::vector<SimplifyCollapse> candidates;
+    std::vector<std::pair<uint32_t, uint32_t>> wedge_targets;
+    float max_error = 0.0f;
+
+    // Each pass collapses the cheapest edges whose neighbourhoods do not overlap
+    while (dst.size() > target_index_count) {
+        group_indices.resize(dst.size());
+        for (size_t i = 0; i < dst.size(); ++i) {
+            group_indices[i] = group[dst[i]];
+        }
+        const TriangleAdjacency adjacency = buildAdjacency(group_indices, vertex_count);
+
+        candidates.clear();
+        for (size_t i = 0; i < group_indices.size(); ++i) {
+            const uint32_t a = group_indices[i], b = group_indices[i - i % 3 + (i + 1) % 3];
+            const uint32_t ends[2][2] = { { a, b }, { b, a } };
+            for (const auto& end : ends) {
+                const uint32_t from = end[0], to = end[1];
+                if (!canCollapse(from, to)) {
+                    continue;
+                }
+                const SimplifyQuadric& qf = quadrics[from];
+                const SimplifyQuadric& qt = quadrics[to];
+                const Vec3& p = vertices[to].position;
+                const double area = std::max(qf.area + qt.area, 1e-20);
+                const float error = static_cast<float>(std::sqrt((evaluateQuadric(qf, p) + evaluateQuadric(qt, p)) / area));
+                if (error <= target_error) {
+                    candidates.push_back({ from, to, error });
+                }
+            }
+        }
+        if (candidates.empty()) {
+            break;
+        }
+        std::sort(candidates.begin(), candidates.end(), [](const SimplifyCollapse& a, const SimplifyCollapse& b) {
+            return a.error < b.error;
+        });
+
+        std::fill(is_touched.begin(), is_touched.end(), 0);
+        const size_t goal = std::max<size_t>((dst.size() - target_index_count) / 3, 1);
+        // NOTE: Collapses far costlier than the one expected to reach the goal are left to later passes,
+        //       where cheaper ones blocked in this pass may be available. Each edge is a candidate about twice.
+        const float pass_error = candidates[std::min(goal, candidates.size() - 1)].error * 1.5f;
+        size_t removed = 0;
+        for (const auto& collapse : candidates) {
+            const uint32_t from = collapse.from, to = collapse.to;
+            if (collapse.error > pass_error) {
+                break;
+            }
+            if (is_touched[from] || is_touched[to]) {
+                continue;
+            }
+            const uint32_t* begin = &adjacency.triangles[adjacency.offsets[from]];
+            const uint32_t* end = &adjacency.triangles[0] + adjacency.offsets[from + 1];
+
+            // Every wedge of `from` moves to the wedge of `to` it shares a triangle with
+            bool is_valid = true;
+            wedge_targets.clear();
+            uint32_t wedge = from;
+            do {
+                bool is_used = false;
+                uint32_t target = kSimplifyInvalid;
+                for (const uint32_t* t = begin; t != end; ++t) {
+                    for (size_t k = 0; k < 3; ++k) {
+                        if (dst[*t * 3 + k] != wedge) {
+                            continue;
+                        }
+                        is_used = true;
+                        for (size_t j = 0; j < 3; ++j) {
+                            if (group_indices[*t * 3 + j] == to) {
+                                target = dst[*t * 3 + j];
+                            }
+                        }
+                    }
+                }
+                if (is_used && target == kSimplifyInvalid) {
+                    is_valid = false;
+                    break;
+                }
+                if (is_used) {
+                    wedge_targets.push_back({ wedge, target });
+                }
+                wedge = next_wedge[wedge];
+            } while (wedge != from);
+
+            // Triangles kept must not flip
+            size_t collapsed_triangles = 0;
+            for (const uint32_t* t = begin; t != end && is_valid; ++t) {
+                Vec3 before[3], after[3];
+                bool has_to = false;
+                for (size_t k = 0; k < 3; ++k) {
+                    const uint32_t g = group_indices[*t * 3 + k];
+                    has_to = has_to || (g == to);
+                    before[k] = vertices[g].position;
+                    after[k] = (g == from) ? vertices[to].position : before[k];
+                }
+                if (has_to) {
+                    ++collapsed_triangles;
+                    continue;
+                }
+                const Vec3 n0 = glm::cross(before[1] - before[0], before[2] - before[0]);
+                const Vec3 n1 = glm::cross(after[1] - after[0], after[2] - after[0]);
+                is_valid = glm::dot(n0, n1) > 0.0f;
+            }
+            if (!is_valid) {
+                continue;
+            }
+
+            for (const auto& target : wedge_targets) {
+                collapse_remap[target.first] = target.second;
+            }
+            addQuadric(quadrics[to], quadrics[from]);
+            for (const uint32_t* t = begin; t != end; ++t) {
+                for (size_t k = 0; k < 3; ++k) {
+                    is_touched[group_indices[*t * 3 + k]] = 1;
+                }
+            }
+            is_touched[to] = 1;
+            max_error = std::max(max_error, collapse.error);
+
+            removed += collapsed_triangles;
+            if (removed >= goal) {
+                break;
+            }
+        }
+        if (removed == 0) {
+            break;
+        }
+
+        // Drop triangles degenerated by the collapses
+        size_t write = 0;
+        for (size_t t = 0; t < dst.size() / 3; ++t) {
+            const uint32_t a = collapse_remap[dst[t * 3 + 0]];
+            const uint32_t b = collapse_remap[dst[t * 3 + 1]];
+            const uint32_t c = collapse_remap[dst[t * 3 + 2]];
+            if (group[a] != group[b] && group[b] != group[c] && group[c] != group[a]) {
+                dst[write++] = a;
+                dst[write++] = b;
+                dst[write++] = c;
+            }
+        }
+        dst.resize(write);
+    }
+
+    if (result_error != nullptr) {
+        *result_error = max_error;
+    }
+    return dst.size();
+}
+
+LodSettings LodSettings::getDefault() {
+    LodSettings settings;
+    settings.ratios = { 0.5f, 0.25f, 0.125f };
+    settings.max_error = 0.05f;
+    return settings;
+}
+
+void kk::renderer::generateLods(const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, const LodSettings& settings, std::vector<MeshLod>& lods) {
+    lods.clear();
+    lods.push_back({ 0, static_cast<uint32_t>(indices.size()), 0.0f });
+    if (indices.empty()) {
+        return;
+    }
+
+    Vec3 min = vertices[indices[0]].position, max = min;
+    for (uint32_t index : indices) {
+        min = glm::min(min, vertices[index].position);
+        max = glm::max(max, vertices[index].position);
+    }
+    const float max_error = settings.max_error * 0.5f * glm::length(max - min);
+
+    const size_t lod0_count = indices.size();
+    std::vector<uint32_t> source(indices), lod;
+    float source_error = 0.0f;
+    for (float ratio : settings.ratios) {
+        const size_t target_index_count = static_cast<size_t>(lod0_count / 3 * ratio) * 3;
+        if (target_index_count >= source.size()) {
+            continue;
+        }
+        float error = 0.0f;
+        simplifyMesh(vertices, source.data(), source.size(), target_index_count, max_error - source_error, lod, &error);
+        // Chain ends where error bound stops simplification
+        if (lod.empty() || lod.size() * 10 > source.size() * 9) {
+            break;
+        }
+        optimizeVertexCache(lod, vertices.size());
+
+        // NOTE: Error of a chained LOD is bounded by the sum of errors of the steps
+        source_error += error;
+        lods.push_back({ static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(lod.size()), source_error });
+        indices.insert(indices.end(), lod.begin(), lod.end());
+        source.swap(lod);
+    }
+}
+
+static void computeMeshletBounds(const std::vector<Vertex>& vertices, const uint32_t* indices, Meshlet& meshlet) {
+    const size_t triangle_count = meshlet.index_count / 3;
+
+    // NOTE: Sphere around AABB center, as Bounds
+    Vec3 min = vertices[indices[0]].position, max = min;
+    for (size_t i = 0; i < meshlet.index_count; ++i) {
+        min = glm::min(min, vertices[indices[i]].position);
+        max = glm::max(max, vertices[indices[i]].position);
+    }
+    meshlet.center = (min + max) * 0.5f;
+    float radius_sq = 0.0f;
+    for (size_t i = 0; i < meshlet.index_count; ++i) {
+        const Vec3 d = vertices[indices[i]].position - meshlet.center;
+        radius_sq = std::max(radius_sq, glm::dot(d, d));
+    }
+    meshlet.radius = std::sqrt(radius_sq);
+
+    // Cone around the average normal, widened to the normal farthest from it
+    std::vector<Vec3> normals(triangle_count, Vec3(0.0f));
+    Vec3 axis(0.0f);
+    for (size_t t = 0; t < triangle_count; ++t) {
+        const Vec3& p0 = vertices[indices[t * 3 + 0]].position;
+        const Vec3 normal = glm::cross(vertices[indices[t * 3 + 1]].position - p0, vertices[indices[t * 3 + 2]].position - p0);
+        const float length = glm::length(normal);
+        if (length > 0.0f) {
+            normals[t] = normal / length;
+            axis += normals[t];
+        }
+    }
+    const float axis_length = glm::length(axis);
+    meshlet.cone_axis = axis_length > 0.0f ? axis / axis_length : Vec3(0.0f, 0.0f, 1.0f);
+    meshlet.cone_cutoff = 1.0f;
+    if (axis_length == 0.0f) {
+        return;
+    }
+    float min_dot = 1.0f;
+    for (const auto& normal : normals) {
+        if (normal != Vec3(0.0f)) {
+            min_dot = std::min(min_dot, glm::dot(normal, meshlet.cone_axis));
+        }
+    }
+    // Cluster faces away when the view direction is within 90 degrees minus the cone angle of the axis: cos(90 - a) = sin(a)
+    if (min_dot > 0.0f) {
+        meshlet.cone_cutoff = std::sqrt(1.0f - min_dot * min_dot);
+    }
+}
+
+void kk::renderer::buildMeshlets(
+    const std::vector<Vertex>& vertices,
+    std::vector<uint32_t>& indices,
+    std::vector<Meshlet>& meshlets,
+    size_t max_vertices,
+    size_t max_triangles
+) {
+    assert(max_vertices >= 3 && max_triangles >= 1);
+    meshlets.clear();
+    const size_t triangle_count = indices.size() / 3;
+    if (triangle_count == 0) {
+        return;
+    }
+
+    const TriangleAdjacency adjacency = buildAdjacency(indices, vertices.size());
+    std::vector<uint8_t> is_emitted(triangle_count, 0);
+    std::vector<uint8_t> in_meshlet(vertices.size(), 0);
+    std::vector<uint32_t> meshlet_vertices, meshlet_triangles, candidates;
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+    size_t seed = 0;
+
+    const auto addTriangle = [&](uint32_t triangle) {
+        is_emitted[triangle] = 1;
+        meshlet_triangles.push_back(triangle);
+        for (size_t k = 0; k < 3; ++k) {
+            const uint32_t v = indices[triangle * 3 + k];
+            if (in_meshlet[v]) {
+                continue;
+            }
+            in_meshlet[v] = 1;
+            meshlet_vertices.push_back(v);
+            for (uint32_t i = adjacency.offsets[v]; i < adjacency.offsets[v + 1]; ++i) {
+                if (!is_emitted[adjacency.triangles[i]]) {
+                    candidates.push_back(adjacency.triangles[i]);
+                }
+            }
+        }
+    };
+
+    while (true) {
+        while (seed < triangle_count && is_emitted[seed]) {
+            ++seed;
+        }
+        if (seed == triangle_count) {
+            break;
+        }
+
+        meshlet_vertices.clear();
+        meshlet_triangles.clear();
+        candidates.clear();
+        addTriangle(static_cast<uint32_t>(seed));
+
+        // Grow by the adjacent triangle adding fewest vertices, the earliest one on tie
+        while (meshlet_triangles.size() < max_triangles) {
+            int64_t best = -1;
+            size_t best_new = 3;
+            size_t write = 0;
+            for (uint32_t triangle : candidates) {
+                if (is_emitted[triangle]) {
+                    continue;
+                }
+                candidates[write++] = triangle;
+                size_t new_vertices = 0;
+                for (size_t k = 0; k < 3; ++k) {
+                    new_vertices += in_meshlet[indices[triangle * 3 + k]] ? 0 : 1;
+                }
+                if (meshlet_vertices.size() + new_vertices > max_vertices) {
+                    continue;
+                }
+                if (best < 0 || new_vertices < best_new || (new_vertices == best_new && triangle < best)) {
+                    best = triangle;
+                    best_new = new_vertices;
+                }
+            }
+            candidates.resize(write);
+            if (best < 0) {
+                break;
+            }
+            addTriangle(static_cast<uint32_t>(best));
+        }
+
+        std::sort(meshlet_triangles.begin(), meshlet_triangles.end());
+        Meshlet meshlet{};
+        meshlet.first_index = static_cast<uint32_t>(result.size());
+        meshlet.index_count = static_cast<uint32_t>(meshlet_triangles.size() * 3);
+        for (uint32_t triangle : meshlet_triangles) {
+            result.insert(result.end(), indices.begin() + triangle * 3, indices.begin() + triangle * 3 + 3);
+        }
+        meshlets.push_back(meshlet);
+        for (uint32_t v : meshlet_vertices) {
+            in_meshlet[v] = 0;
+        }
+    }
+
+    assert(result.size() == indices.size());
+    indices.swap(result);
+    for (auto& meshlet : meshlets) {
+        computeMeshletBounds(vertices, &indices[meshlet.first_index], meshlet);
+    }
+}
+
+ClusterBounds kk::renderer::getClusterBounds(const std::vector<Meshlet>& meshlets) {
+    ClusterBounds bounds;
+    for (const auto& meshlet : meshlets) {
+        bounds.x.push_back(meshlet.center.x);
+        bounds.y.push_back(meshlet.center.y);
+        bounds.z.push_back(meshlet.center.z);
+        bounds.radius.push_back(meshlet.radius);
+        bounds.axis_x.push_back(meshlet.cone_axis.x);
+        bounds.axis_y.push_back(meshlet.cone_axis.y);
+        bounds.axis_z.push_back(meshlet.cone_axis.z);
+        bounds.cutoff.push_back(meshlet.cone_cutoff);
+    }
+    return bounds;
+}
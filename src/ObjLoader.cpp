@@ -0,0 +1,363 @@
+#include "kk_renderer/ObjLoader.h"
+#include "kk_renderer/MappedFile.h"
+#include "kk_renderer/ThreadPool.h"
+#include "kk_renderer/VertexWeldTable.h"
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <climits>
+
+using namespace kk;
+using namespace kk::renderer;
+
+// Chunks smaller than this are not worth a task
+static constexpr size_t kMinChunkSize = 1024 * 1024;
+static constexpr size_t kChunksPerThread = 4;
+static constexpr int32_t kNoIndex = INT32_MIN;
+
+// Face corner. Indices are 0-based and global, except ones listed in ObjChunk::relatives.
+struct ObjCorner {
+    int32_t v, vt;
+};
+
+// Parse result of a line aligned part of the file
+struct ObjChunk {
+    std::vector<float> positions; // xyz
+    std::vector<float> uvs;       // uv
+    std::vector<ObjCorner> corners; // 3 per triangle
+    // Corners with relative index, as (corner index * 2 + is_vt). Their index is local to the chunk until merged.
+    std::vector<size_t> relatives;
+    // First corners of quads, fan triangulated until merged
+    std::vector<size_t> quads;
+};
+
+static const double kPow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+    1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static inline bool isBlank(char c) {
+    return c == ' ' || c == '\t';
+}
+
+static inline bool isDigit(char c) {
+    return static_cast<unsigned char>(c - '0') < 10;
+}
+
+static void parseChunk(const char* cur, const char* end, ObjChunk& chunk);
+static void parseFace(const char* cur, const char* end, ObjChunk& chunk, std::vector<ObjCorner>& polygon);
+static bool parseInt(const char*& cur, const char* end, int32_t& value);
+static void mergeChunks(std::vector<ObjChunk>& chunks, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+void kk::renderer::loadObj(const std::string& path, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, size_t thread_count) {
+    MappedFile file = MappedFile::create(path);
+    if (thread_count == 0) {
+        thread_count = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    }
+
+    // Split at line ends, so that each chunk holds whole statements
+    const size_t chunk_count = std::max<size_t>(std::min(thread_count * kChunksPerThread, file.size / kMinChunkSize), 1);
+    std::vector<const char*> bounds(chunk_count + 1);
+    bounds[0] = file.data;
+    bounds[chunk_count] = file.data + file.size;
+    for (size_t i = 1; i < chunk_count; ++i) {
+        const char* begin = std::max(file.data + file.size / chunk_count * i, bounds[i - 1]);
+        const char* line_end = static_cast<const char*>(std::memchr(begin, '\n', bounds[chunk_count] - begin));
+        bounds[i] = (line_end != nullptr) ? line_end + 1 : bounds[chunk_count];
+    }
+
+    std::vector<ObjChunk> chunks(chunk_count);
+    try {
+        if (chunk_count == 1) {
+            parseChunk(bounds[0], bounds[1], chunks[0]);
+        }
+        else {
+            ThreadPool pool(std::min(thread_count, chunk_count));
+            std::vector<std::future<void>> results;
+            for (size_t i = 0; i < chunk_count; ++i) {
+                results.push_back(pool.submit([&bounds, &chunks, i]() {
+                    parseChunk(bounds[i], bounds[i + 1], chunks[i]);
+                }));
+            }
+            // NOTE: Wait for every task before rethrowing, since they refer to the mapping
+            for (auto& result : results) {
+                result.wait();
+            }
+            for (auto& result : results) {
+                result.get();
+            }
+        }
+    }
+    catch (...) {
+        file.destroy();
+        throw;
+    }
+    file.destroy();
+
+    mergeChunks(chunks, vertices, indices);
+}
+
+float kk::renderer::parseFloat(const char*& cur, const char* end) {
+    const char* p = cur;
+    while (p < end && isBlank(*p)) {
+        ++p;
+    }
+    const char* begin = p;
+
+    const bool is_negative = (p < end && *p == '-');
+    if (p < end && (*p == '-' || *p == '+')) {
+        ++p;
+    }
+
+    // Up to 19 significant digits fit in 64 bit mantissa. Further digits only scale the value.
+    uint64_t mantissa = 0;
+    int digit_count = 0, exponent = 0;
+    const char* digits_begin = p;
+    for (; p < end && isDigit(*p); ++p) {
+        if (digit_count < 19) {
+            mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+            digit_count += (mantissa != 0) ? 1 : 0;
+        }
+        else {
+            ++exponent;
+        }
+    }
+    if (p < end && *p == '.') {
+        ++p;
+        for (; p < end && isDigit(*p); ++p) {
+            if (digit_count < 19) {
+                mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+                digit_count += (mantissa != 0) ? 1 : 0;
+                --exponent;
+            }
+        }
+    }
+    if (p == digits_begin || (p == digits_begin + 1 && *digits_begin == '.')) {
+        return 0.0f;
+    }
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        const char* q = p + 1;
+        const bool is_exp_negative = (q < end && *q == '-');
+        if (q < end && (*q == '-' || *q == '+')) {
+            ++q;
+        }
+        if (q < end && isDigit(*q)) {
+            int exp_value = 0;
+            for (; q < end && isDigit(*q); ++q) {
+                exp_value = std::min(exp_value * 10 + (*q - '0'), 10000);
+            }
+            exponent += is_exp_negative ? -exp_value : exp_value;
+            p = q;
+        }
+    }
+    cur = p;
+
+    double value;
+    if (-22 <= exponent && exponent <= 22) {
+        // Exact powers of ten, one rounding each
+        value = (exponent < 0) ? static_cast<double>(mantissa) / kPow10[-exponent] : static_cast<double>(mantissa) * kPow10[exponent];
+        return static_cast<float>(is_negative ? -value : value);
+    }
+
+    // Rare: defer to the C library
+    const std::string text(begin, p);
+    return std::strtof(text.c_str(), nullptr);
+}
+
+static void parseChunk(const char* cur, const char* end, ObjChunk& chunk) {
+    std::vector<ObjCorner> polygon;
+    while (cur < end) {
+        while (cur < end && isBlank(*cur)) {
+            ++cur;
+        }
+        const char* line_end = static_cast<const char*>(std::memchr(cur, '\n', end - cur));
+        if (line_end == nullptr) {
+            line_end = end;
+        }
+
+        if (line_end - cur >= 2) {
+            if (cur[0] == 'v' && isBlank(cur[1])) {
+                const char* p = cur + 2;
+                chunk.positions.push_back(parseFloat(p, line_end));
+                chunk.positions.push_back(parseFloat(p, line_end));
+                chunk.positions.push_back(parseFloat(p, line_end));
+            }
+            else if (cur[0] == 'v' && cur[1] == 't' && line_end - cur >= 3 && isBlank(cur[2])) {
+                const char* p = cur + 3;
+                chunk.uvs.push_back(parseFloat(p, line_end));
+                chunk.uvs.push_back(parseFloat(p, line_end));
+            }
+            else if (cur[0] == 'f' && isBlank(cur[1])) {
+                parseFace(cur + 2, line_end, chunk, polygon);
+            }
+        }
+
+        cur = line_end + 1;
+    }
+}
+
+static void parseFace(const char* cur, const char* end, ObjChunk& chunk, std::vector<ObjCorner>& polygon) {
+    const int32_t position_count = static_cast<int32_t>(chunk.positions.size() / 3);
+    const int32_t uv_count = static_cast<int32_t>(chunk.uvs.size() / 2);
+
+    // Corner is "v", "v/vt", "v//vn" or "v/vt/vn"
+    polygon.clear();
+    while (true) {
+        while (cur < end && (isBlank(*cur) || *cur == '\r')) {
+            ++cur;
+        }
+        if (cur == end) {
+            break;
+        }
+
+        ObjCorner corner{ kNoIndex, kNoIndex };
+        if (!parseInt(cur, end, corner.v) || corner.v == 0) {
+            throw std::runtime_error("Malformed face in OBJ");
+        }
+        if (cur < end && *cur == '/') {
+            ++cur;
+            if (cur < end && *cur != '/' && (!parseInt(cur, end, corner.vt) || corner.vt == 0)) {
+                throw std::runtime_error("Malformed face in OBJ");
+            }
+            if (cur < end && *cur == '/') {
+                int32_t vn = 0;
+                ++cur;
+                parseInt(cur, end, vn);
+            }
+        }
+        polygon.push_back(corner);
+    }
+    if (polygon.size() < 3) {
+        throw std::runtime_error("Face with less than 3 vertices in OBJ");
+    }
+
+    // NOTE: Quad is split along its shorter diagonal at merge, once every position is known
+    if (polygon.size() == 4) {
+        chunk.quads.push_back(chunk.corners.size());
+    }
+
+    // Fan triangulation, resolving to 0-based indices. Relative ones are local to the chunk until merged.
+    for (size_t i = 1; i + 1 < polygon.size(); ++i) {
+        const ObjCorner triangle[3] = { polygon[0], polygon[i], polygon[i + 1] };
+        for (const ObjCorner& raw : triangle) {
+            const size_t corner_idx = chunk.corners.size();
+            ObjCorner corner = raw;
+            if (raw.v > 0) {
+                corner.v = raw.v - 1;
+            }
+            else {
+                corner.v = position_count + raw.v;
+                chunk.relatives.push_back(corner_idx * 2);
+            }
+            if (raw.vt > 0) {
+                corner.vt = raw.vt - 1;
+            }
+            else if (raw.vt != kNoIndex) {
+                corner.vt = uv_count + raw.vt;
+                chunk.relatives.push_back(corner_idx * 2 + 1);
+            }
+            chunk.corners.push_back(corner);
+        }
+    }
+}
+
+static bool parseInt(const char*& cur, const char* end, int32_t& value) {
+    const char* p = cur;
+    const bool is_negative = (p < end && *p == '-');
+    if (p < end && (*p == '-' || *p == '+')) {
+        ++p;
+    }
+    if (p == end || !isDigit(*p)) {
+        return false;
+    }
+
+    int64_t result = 0;
+    for (; p < end && isDigit(*p); ++p) {
+        result = std::min<int64_t>(result * 10 + (*p - '0'), INT32_MAX);
+    }
+    value = static_cast<int32_t>(is_negative ? -result : result);
+    cur = p;
+
+    return true;
+}
+
+static void mergeChunks(std::vector<ObjChunk>& chunks, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+    size_t position_count = 0, uv_count = 0, corner_count = 0;
+    for (auto& chunk : chunks) {
+        // Relative indices become global by adding the element counts of preceding chunks
+        for (size_t relative : chunk.relatives) {
+            ObjCorner& corner = chunk.corners[relative / 2];
+            if (relative % 2 == 0) {
+                corner.v += static_cast<int32_t>(position_count);
+            }
+            else {
+                corner.vt += static_cast<int32_t>(uv_count);
+            }
+        }
+        position_count += chunk.positions.size() / 3;
+        uv_count += chunk.uvs.size() / 2;
+        corner_count += chunk.corners.size();
+    }
+
+    for (const auto& chunk : chunks) {
+        for (const auto& corner : chunk.corners) {
+            if (corner.v < 0 || static_cast<size_t>(corner.v) >= position_count ||
+                (corner.vt != kNoIndex && (corner.vt < 0 || static_cast<size_t>(corner.vt) >= uv_count))) {
+                throw std::runtime_error("Index out of range in OBJ");
+            }
+        }
+    }
+
+    std::vector<float> positions, uvs;
+    positions.reserve(position_count * 3);
+    uvs.reserve(uv_count * 2);
+    for (auto& chunk : chunks) {
+        positions.insert(positions.end(), chunk.positions.begin(), chunk.positions.end());
+        uvs.insert(uvs.end(), chunk.uvs.begin(), chunk.uvs.end());
+        std::vector<float>().swap(chunk.positions);
+        std::vector<float>().swap(chunk.uvs);
+    }
+
+    // Same split as tinyobj: [0, 1, 2], [0, 2, 3] if diagonal 0-2 is shorter, otherwise [0, 1, 3], [1, 2, 3]
+    const auto distanceSq = [&positions](const ObjCorner& a, const ObjCorner& b) {
+        const float dx = positions[3 * b.v + 0] - positions[3 * a.v + 0];
+        const float dy = positions[3 * b.v + 1] - positions[3 * a.v + 1];
+        const float dz = positions[3 * b.v + 2] - positions[3 * a.v + 2];
+        return dx * dx + dy * dy + dz * dz;
+    };
+    for (auto& chunk : chunks) {
+        for (size_t first : chunk.quads) {
+            ObjCorner* triangles = &chunk.corners[first];
+            const ObjCorner quad[4] = { triangles[0], triangles[1], triangles[2], triangles[5] };
+            if (!(distanceSq(quad[0], quad[2]) < distanceSq(quad[1], quad[3]))) {
+                const ObjCorner split[6] = { quad[0], quad[1], quad[3], quad[1], quad[2], quad[3] };
+                std::copy(split, split + 6, triangles);
+            }
+        }
+    }
+
+    VertexWeldTable weld_table(position_count);
+    vertices.reserve(vertices.size() + position_count);
+    indices.reserve(indices.size() + corner_count);
+    for (const auto& chunk : chunks) {
+        for (const auto& corner : chunk.corners) {
+            Vertex vertex{};
+            vertex.position = {
+                positions[3 * corner.v + 0],
+                positions[3 * corner.v + 1],
+                positions[3 * corner.v + 2]
+            };
+            if (corner.vt != kNoIndex) {
+                vertex.uv = {
+                    uvs[2 * corner.vt + 0],
+                    1.0f - uvs[2 * corner.vt + 1]
+                };
+            }
+            vertex.color = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+            indices.push_back(weld_table.weld(vertex, vertices));
+        }
+    }
+}
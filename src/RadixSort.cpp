@@ -0,0 +1,48 @@
+#include "kk_renderer/RadixSort.h"
+#include <array>
+#include <utility>
+
+using namespace kk::renderer;
+
+static constexpr size_t kRadixBits = 8;
+static constexpr size_t kRadixSize = 1 << kRadixBits;
+static constexpr size_t kPassCount = 64 / kRadixBits;
+
+void kk::renderer::radixSort(std::vector<SortItem>& items, std::vector<SortItem>& tmp) {
+    const size_t count = items.size();
+    if (count <= 1) {
+        return;
+    }
+    tmp.resize(count);
+
+    // Build histograms of every digit in one pass
+    std::array<std::array<uint32_t, kRadixSize>, kPassCount> histograms{};
+    for (const auto& item : items) {
+        for (size_t pass = 0; pass < kPassCount; ++pass) {
+            ++histograms[pass][(item.key >> (pass * kRadixBits)) & (kRadixSize - 1)];
+        }
+    }
+
+    for (size_t pass = 0; pass < kPassCount; ++pass) {
+        auto& histogram = histograms[pass];
+        const size_t shift = pass * kRadixBits;
+
+        // Skip the digit shared by all keys (e.g. unused upper bits)
+        if (histogram[(items[0].key >> shift) & (kRadixSize - 1)] == count) {
+            continue;
+        }
+
+        // Exclusive prefix sum gives the first destination of each bucket
+        uint32_t sum = 0;
+        for (auto& bucket : histogram) {
+            const uint32_t n = bucket;
+            bucket = sum;
+            sum += n;
+        }
+
+        for (const auto& item : items) {
+            tmp[histogram[(item.key >> shift) & (kRadixSize - 1)]++] = item;
+        }
+        std::swap(items, tmp);
+    }
+}
@@ -10,12 +10,6 @@ Renderable::Renderable(
 ) : geometry(geometry), material(material) {
     static size_t next_id = 0;
 
-    for (auto& desc_set : desc_sets) {
-        for (auto& d : desc_set) {
-            d = VK_NULL_HANDLE;
-        }
-    }
-
     // TODO: Reuse destructed id
     id = next_id++;
 }
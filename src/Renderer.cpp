@@ -3,16 +3,91 @@
 #include <iostream>
 #include <vector>
 #include <cstring>
+#include <algorithm>
+#include <limits>
+#include <cmath>
 
+using namespace kk;
 using namespace kk::renderer;
 
-static VkRenderPass createRenderPass(RenderingContext& ctx, VkFormat swapchain_format);
-static std::vector<VkFramebuffer> createFramebuffers(RenderingContext& ctx, const Swapchain& swapchain, const Image& depth, VkRenderPass render_pass);
+// Uniform memory block per frame in flight. 8 MiB holds 32k MVPs even with 256 byte alignment. Busier frames chain more blocks.
+static constexpr VkDeviceSize kUniformBufferSize = 8 * 1024 * 1024;
+
+// Smallest run of draws sharing material and geometry to be merged into one instanced draw
+static constexpr size_t kMinInstanceCount = 2;
+
+// Smallest chunk of draws worth recording on a worker thread
+static constexpr size_t kMinDrawsPerWorker = 64;
+
+// Offscreen colour target. Readable by transfer after the render pass.
+static constexpr VkFormat kOffscreenFormat = VK_FORMAT_R8G8B8A8_UNORM;
+static constexpr VkDeviceSize kOffscreenPixelSize = 4;
+
+static VkRenderPass createRenderPass(RenderingContext& ctx, VkFormat color_format, VkImageLayout color_final_layout);
+static std::vector<VkFramebuffer> createFramebuffers(
+    RenderingContext& ctx,
+    const std::vector<VkImageView>& color_views,
+    const Image& depth,
+    VkRenderPass render_pass,
+    VkExtent2D extent
+);
 static Image createDepthImage(RenderingContext& ctx, VkExtent2D extent);
+static Buffer createReadbackBuffer(RenderingContext& ctx, VkDeviceSize size, VkMappedMemoryRange& range);
+static VkDescriptorSetLayout createUniformLayout(RenderingContext& ctx);
+static VkDescriptorSet createUniformSet(RenderingContext& ctx, VkDescriptorSetLayout layout, const Buffer& buffer);
+static void setViewportAndScissor(VkCommandBuffer cmd_buf, VkExtent2D extent);
+static void addStats(Renderer::FrameStats& dst, const Renderer::FrameStats& src);
+static bool isReady(const Renderable& renderable);
 
 Renderer Renderer::create(RenderingContext& ctx, Swapchain& swapchain) {
+    Renderer renderer = createBase(ctx, swapchain.surface_format.format, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, swapchain.extent);
+    renderer.framebuffers_ = createFramebuffers(ctx, swapchain.views, renderer.depth_, renderer.render_pass_, swapchain.extent);
+
+    return renderer;
+}
+
+Renderer Renderer::createOffscreen(RenderingContext& ctx, uint32_t width, uint32_t height) {
+    const VkExtent2D extent = { width, height };
+    Renderer renderer = createBase(ctx, kOffscreenFormat, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, extent);
+    renderer.is_offscreen_ = true;
+
+    // Colour target and readback buffer per frame in flight
+    std::vector<VkImageView> color_views;
+    for (size_t i = 0; i < kMaxConcurrentFrames; ++i) {
+        renderer.color_targets_[i] = Image::create(
+            ctx,
+            width,
+            height,
+            kOffscreenFormat,
+            VK_IMAGE_TILING_OPTIMAL,
+            VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            VK_IMAGE_ASPECT_COLOR_BIT
+        );
+        color_views.push_back(renderer.color_targets_[i].view);
+
+        renderer.readbacks_[i].buffer = createReadbackBuffer(ctx, width * height * kOffscreenPixelSize, renderer.readbacks_[i].range);
+        renderer.readbacks_[i].is_pending = false;
+    }
+    // NOTE: Framebuffer i is used by frame in flight i
+    renderer.framebuffers_ = createFramebuffers(ctx, color_views, renderer.depth_, renderer.render_pass_, extent);
+
+    return renderer;
+}
+
+Renderer Renderer::createBase(RenderingContext& ctx, VkFormat color_format, VkImageLayout color_final_layout, VkExtent2D extent) {
     Renderer renderer{};
     renderer.current_frame_ = renderer.img_idx_ = 0;
+    renderer.mode_ = SubmitMode::kImmediate;
+    renderer.view_proj_camera_ = nullptr;
+    renderer.culled_count_ = 0;
+    renderer.lod_threshold_ = 1.0f;
+    renderer.lod_pixel_scale_ = 0.0f;
+    renderer.device_ = ctx.device;
+    renderer.extent_ = extent;
+    renderer.overlay_bufs_.fill(VK_NULL_HANDLE);
+    renderer.is_offscreen_ = false;
+    renderer.submitted_count_ = 0;
     
     // Allocate command buffer
     VkCommandBufferAllocateInfo alloc_info{};
@@ -23,21 +98,57 @@ Renderer Renderer::create(RenderingContext& ctx, Swapchain& swapchain) {
     assert(vkAllocateCommandBuffers(ctx.device, &alloc_info, renderer.cmd_bufs_.data()) == VK_SUCCESS);
 
     // Create graphics pipelines and related objects
-    renderer.render_pass_ = createRenderPass(ctx, swapchain.surface_format.format);
-    renderer.depth_ = createDepthImage(ctx, swapchain.extent);
-    renderer.framebuffers_ = createFramebuffers(ctx, swapchain, renderer.depth_, renderer.render_pass_);
+    renderer.render_pass_ = createRenderPass(ctx, color_format, color_final_layout);
+    renderer.depth_ = createDepthImage(ctx, extent);
+
+    // Create per-frame uniform allocators
+    for (auto& uniform : renderer.uniforms_) {
+        uniform = UniformAllocator::create(ctx, kUniformBufferSize);
+    }
+    renderer.uniform_layout_ = createUniformLayout(ctx);
+    for (size_t i = 0; i < kMaxConcurrentFrames; ++i) {
+        renderer.uniform_sets_[i].push_back(createUniformSet(ctx, renderer.uniform_layout_, renderer.uniforms_[i].blocks[0]));
+    }
 
     return renderer;
 }
 
 void Renderer::destroy(RenderingContext& ctx) {
-    for (auto& uniform : uniforms_) {
-        for (size_t i = 0; i < kMaxConcurrentFrames; ++i) {
-            uniform.second[i].destroy(ctx);
+    // Join workers, then release their command pools after in-flight frames
+    workers_.reset();
+    for (const auto& worker_frame : worker_frames_) {
+        for (const auto& frame : worker_frame) {
+            const VkCommandPool pool = frame.pool;
+            ctx.deletion_queue.push([pool](RenderingContext& ctx) {
+                vkDestroyCommandPool(ctx.device, pool, nullptr);
+            });
         }
     }
+    worker_frames_.clear();
+    if (overlay_bufs_[0] != VK_NULL_HANDLE) {
+        vkFreeCommandBuffers(ctx.device, ctx.cmd_pool, static_cast<uint32_t>(overlay_bufs_.size()), overlay_bufs_.data());
+    }
+
+    const VkDescriptorSetLayout uniform_layout = uniform_layout_;
+    std::vector<VkDescriptorSet> uniform_sets;
+    for (const auto& sets : uniform_sets_) {
+        uniform_sets.insert(uniform_sets.end(), sets.begin(), sets.end());
+    }
+    ctx.deletion_queue.push([uniform_layout, uniform_sets](RenderingContext& ctx) {
+        vkFreeDescriptorSets(ctx.device, ctx.desc_pool, static_cast<uint32_t>(uniform_sets.size()), uniform_sets.data());
+        vkDestroyDescriptorSetLayout(ctx.device, uniform_layout, nullptr);
+    });
+    for (auto& uniform : uniforms_) {
+        uniform.destroy(ctx);
+    }
 
     depth_.destroy(ctx);
+    if (is_offscreen_) {
+        for (size_t i = 0; i < kMaxConcurrentFrames; ++i) {
+            color_targets_[i].destroy(ctx);
+            readbacks_[i].buffer.destroy(ctx);
+        }
+    }
 
     for (auto& framebuffer : framebuffers_) {
         vkDestroyFramebuffer(ctx.device, framebuffer, nullptr);
@@ -54,20 +165,57 @@ void Renderer::destroy(RenderingContext& ctx) {
 }
 
 bool Renderer::beginFrame(RenderingContext& ctx, Swapchain& swapchain) {
-    VkResult ret = vkWaitForFences(ctx.device, 1, &ctx.fences[current_frame_], VK_TRUE, UINT64_MAX);
-    if (ret != VK_SUCCESS) {
+    if (!waitFrame(ctx)) {
         return false;
     }
 
-    ret = vkAcquireNextImageKHR(ctx.device, swapchain.swapchain, UINT64_MAX, ctx.present_complete[current_frame_], VK_NULL_HANDLE, &img_idx_);
+    const VkResult ret = vkAcquireNextImageKHR(ctx.device, swapchain.swapchain, UINT64_MAX, ctx.present_complete[current_frame_], VK_NULL_HANDLE, &img_idx_);
     if (ret != VK_SUCCESS) {
         if (ret == VK_ERROR_OUT_OF_DATE_KHR) {
             // TODO: recreate swapchain
         }
         return false;
     }
+    extent_ = swapchain.extent;
 
-    ret = vkResetFences(ctx.device, 1, &ctx.fences[current_frame_]);
+    return beginCommands(ctx);
+}
+
+bool Renderer::beginFrame(RenderingContext& ctx) {
+    assert(is_offscreen_);
+    if (!waitFrame(ctx)) {
+        return false;
+    }
+
+    // Frame not read back until now is overwritten by this frame
+    readbacks_[current_frame_].is_pending = false;
+    img_idx_ = static_cast<uint32_t>(current_frame_);
+
+    return beginCommands(ctx);
+}
+
+bool Renderer::waitFrame(RenderingContext& ctx) {
+    const VkResult ret = vkWaitForFences(ctx.device, 1, &ctx.fences[current_frame_], VK_TRUE, UINT64_MAX);
+    if (ret != VK_SUCCESS) {
+        return false;
+    }
+
+    // GPU has finished reading uniforms of this frame
+    uniforms_[current_frame_].reset();
+    // Release resources destroyed during completed frames
+    ctx.deletion_queue.collect(ctx);
+    // Secondary command buffers of this frame are no longer in use
+    for (auto& worker_frame : worker_frames_) {
+        WorkerFrame& frame = worker_frame[current_frame_];
+        assert(vkResetCommandPool(ctx.device, frame.pool, 0) == VK_SUCCESS);
+        frame.used = 0;
+    }
+
+    return true;
+}
+
+bool Renderer::beginCommands(RenderingContext& ctx) {
+    VkResult ret = vkResetFences(ctx.device, 1, &ctx.fences[current_frame_]);
     if (ret != VK_SUCCESS) {
         // NOTE: ret == VK_ERROR_OUT_OF_DEVICE_MEMORY
         return false;
@@ -84,13 +232,17 @@ bool Renderer::beginFrame(RenderingContext& ctx, Swapchain& swapchain) {
     VkCommandBufferBeginInfo begin_info{};
     begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
     assert(vkBeginCommandBuffer(current_buf, &begin_info) == VK_SUCCESS);
+    recorder_ = Recorder{ current_buf, BoundState{}, &stats_ };
+    stats_ = FrameStats{};
+    view_proj_camera_ = nullptr;
+    ranges_.clear();
 
     // Begin render pass
     VkRenderPassBeginInfo render_pass_info{};
     render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
     render_pass_info.renderPass = render_pass_;
     render_pass_info.framebuffer = framebuffers_[img_idx_];
-    render_pass_info.renderArea.extent = swapchain.extent;
+    render_pass_info.renderArea.extent = extent_;
 
     std::array<VkClearValue, 2> clear_values{};
     clear_values[0].color = { {0.0f, 0.0f, 0.0f, 1.0f} };
@@ -98,41 +250,36 @@ bool Renderer::beginFrame(RenderingContext& ctx, Swapchain& swapchain) {
     render_pass_info.clearValueCount = static_cast<uint32_t>(clear_values.size());
     render_pass_info.pClearValues = clear_values.data();
 
-    vkCmdBeginRenderPass(current_buf, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
+    if (mode_ == SubmitMode::kParallel) {
+        // NOTE: Render pass with secondary contents accepts only vkCmdExecuteCommands.
+        //       Commands recorded by the caller (e.g. editor) go to overlay secondary command buffer.
+        vkCmdBeginRenderPass(current_buf, &render_pass_info, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
 
-    // Set viewport
-    VkViewport viewport{};
-    viewport.width = static_cast<float>(swapchain.extent.width);
-    viewport.height = static_cast<float>(swapchain.extent.height);
-    viewport.maxDepth = 1.0f;
-    vkCmdSetViewport(current_buf, 0, 1, &viewport);
+        VkCommandBufferInheritanceInfo inheritance{};
+        inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritance.renderPass = render_pass_;
+        inheritance.subpass = 0;
+        inheritance.framebuffer = framebuffers_[img_idx_];
 
-    // Set scissor
-    VkRect2D scissor{};
-    scissor.extent = swapchain.extent;
-    vkCmdSetScissor(current_buf, 0, 1, &scissor);
+        VkCommandBufferBeginInfo overlay_info{};
+        overlay_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        overlay_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        overlay_info.pInheritanceInfo = &inheritance;
+        assert(vkBeginCommandBuffer(overlay_bufs_[current_frame_], &overlay_info) == VK_SUCCESS);
+        setViewportAndScissor(overlay_bufs_[current_frame_], extent_);
+    }
+    else {
+        vkCmdBeginRenderPass(current_buf, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
+        setViewportAndScissor(current_buf, extent_);
+    }
 
     return true;
 }
 
 void Renderer::endFrame(RenderingContext& ctx, Swapchain& swapchain) {
-    vkCmdEndRenderPass(cmd_bufs_[current_frame_]);
+    endRenderPass(ctx);
     assert(vkEndCommandBuffer(cmd_bufs_[current_frame_]) == VK_SUCCESS);
-
-    VkSubmitInfo submit_info{};
-    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submit_info.waitSemaphoreCount = 1;
-    submit_info.pWaitSemaphores = &ctx.present_complete[current_frame_];
-    VkPipelineStageFlags wait_stages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-    submit_info.pWaitDstStageMask = wait_stages;
-    submit_info.commandBufferCount = 1;
-    submit_info.pCommandBuffers = &cmd_bufs_[current_frame_];
-    submit_info.signalSemaphoreCount = 1;
-    submit_info.pSignalSemaphores = &ctx.render_complete[current_frame_];
-
-    VkResult ret = vkQueueSubmit(ctx.graphics_queue, 1, &submit_info, ctx.fences[current_frame_]);
-    if (ret != VK_SUCCESS) {
-        std::cerr << "Failed to graphics submit. Idx: " << current_frame_ << std::endl;
+    if (!submitFrame(ctx, ctx.present_complete[current_frame_], ctx.render_complete[current_frame_])) {
         return;
     }
 
@@ -144,7 +291,7 @@ void Renderer::endFrame(RenderingContext& ctx, Swapchain& swapchain) {
     present_info.pSwapchains = &swapchain.swapchain;
     present_info.pImageIndices = &img_idx_; // CONCERN
 
-    ret = vkQueuePresentKHR(ctx.present_queue, &present_info);
+    const VkResult ret = vkQueuePresentKHR(ctx.present_queue, &present_info);
     if (ret == VK_ERROR_OUT_OF_DATE_KHR || ret == VK_SUBOPTIMAL_KHR) {
         // TODO: Recreate swapchain
     }
@@ -155,134 +302,637 @@ void Renderer::endFrame(RenderingContext& ctx, Swapchain& swapchain) {
     current_frame_ = (current_frame_ + 1) % kMaxConcurrentFrames;
 }
 
-void Renderer::prepareRendering(RenderingContext& ctx, Renderable& renderable) {
-    // Setup uniform buffer
-    if (uniforms_.find(renderable.id) == uniforms_.end()) {
-        for (size_t i = 0; i < kMaxConcurrentFrames; ++i) {
-            Buffer& uniform = uniforms_[renderable.id][i];
-            uniform = Buffer::create(
-                ctx,
-                sizeof(Mat4),
-                VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-            );
-            vkMapMemory(ctx.device, uniform.memory, 0, uniform.size, 0, &uniform.mapped);
+void Renderer::endFrame(RenderingContext& ctx) {
+    assert(is_offscreen_);
+    endRenderPass(ctx);
+
+    // Render pass leaves colour target in TRANSFER_SRC_OPTIMAL
+    const VkCommandBuffer cmd_buf = cmd_bufs_[current_frame_];
+    Readback& readback = readbacks_[current_frame_];
+    VkBufferImageCopy region{};
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.layerCount = 1;
+    region.imageExtent = { extent_.width, extent_.height, 1 };
+    vkCmdCopyImageToBuffer(cmd_buf, color_targets_[current_frame_].image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readback.buffer.buffer, 1, &region);
+
+    // Make the copy visible to host reads after the fence is signaled
+    VkBufferMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = readback.buffer.buffer;
+    barrier.size = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+    assert(vkEndCommandBuffer(cmd_buf) == VK_SUCCESS);
+    if (!submitFrame(ctx, VK_NULL_HANDLE, VK_NULL_HANDLE)) {
+        return;
+    }
+    readback.frame = submitted_count_ - 1;
+    readback.is_pending = true;
+
+    current_frame_ = (current_frame_ + 1) % kMaxConcurrentFrames;
+}
+
+bool Renderer::readback(RenderingContext& ctx, std::vector<uint8_t>& pixels, bool wait, uint64_t* frame) {
+    assert(is_offscreen_);
+
+    // Frames are read in submission order
+    size_t oldest = kMaxConcurrentFrames;
+    for (size_t i = 0; i < kMaxConcurrentFrames; ++i) {
+        if (readbacks_[i].is_pending && (oldest == kMaxConcurrentFrames || readbacks_[i].frame < readbacks_[oldest].frame)) {
+            oldest = i;
         }
     }
+    if (oldest == kMaxConcurrentFrames) {
+        return false;
+    }
 
-    // Set pipeline state
-    if (!renderable.material->isCompiled()) {
-        renderable.material->compile(ctx, render_pass_);
+    if (wait) {
+        assert(vkWaitForFences(ctx.device, 1, &ctx.fences[oldest], VK_TRUE, UINT64_MAX) == VK_SUCCESS);
+    }
+    else if (vkGetFenceStatus(ctx.device, ctx.fences[oldest]) != VK_SUCCESS) {
+        return false;
     }
 
-    // Setup descriptor sets
-    // NOTE: Assert material is compiled (valid descriptor set layouts required)
-    const auto& layouts = renderable.material->getDescriptorSetLayouts();
-    if (renderable.desc_sets[0].size() == 0 && layouts.size() != 0) {
-        for (size_t i = 0; i < kMaxConcurrentFrames; ++i) {
-            VkDescriptorSetAllocateInfo alloc_info{};
-            alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-            alloc_info.descriptorPool = ctx.desc_pool;
-            alloc_info.descriptorSetCount = static_cast<uint32_t>(layouts.size());
-            alloc_info.pSetLayouts = layouts.data();
-
-            auto& target_sets = renderable.desc_sets[i];
-            target_sets.resize(layouts.size());
-            assert(vkAllocateDescriptorSets(ctx.device, &alloc_info, target_sets.data()) == VK_SUCCESS);
-
-            VkWriteDescriptorSet write_texture{};
-            write_texture.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            write_texture.dstSet = target_sets[0];
-            write_texture.dstBinding = 0;
-            write_texture.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-            write_texture.descriptorCount = 1;
-
-            VkDescriptorImageInfo tex_info{};
-            tex_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-            auto texture = renderable.material->getTexture();
-            tex_info.imageView = texture->view;
-            tex_info.sampler = texture->sampler;
-            write_texture.pImageInfo = &tex_info;
-
-            VkWriteDescriptorSet write_uniform{};
-            write_uniform.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            write_uniform.dstSet = target_sets[1];
-            write_uniform.dstBinding = 0;
-            write_uniform.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-            write_uniform.descriptorCount = 1;
-
-            VkDescriptorBufferInfo buf_info{};
-            buf_info.buffer = uniforms_[renderable.id][i].buffer;
-            buf_info.offset = 0;
-            buf_info.range = uniforms_[renderable.id][i].size;
-            write_uniform.pBufferInfo = &buf_info;
-
-            VkWriteDescriptorSet writes[] = { write_texture, write_uniform };
-            vkUpdateDescriptorSets(ctx.device, 2, writes, 0, nullptr);
-        }
+    Readback& readback = readbacks_[oldest];
+    if (readback.range.size > 0) {
+        assert(vkInvalidateMappedMemoryRanges(ctx.device, 1, &readback.range) == VK_SUCCESS);
+    }
+    pixels.resize(static_cast<size_t>(extent_.width) * extent_.height * kOffscreenPixelSize);
+    std::memcpy(pixels.data(), readback.buffer.mapped, pixels.size());
+    readback.is_pending = false;
+    if (frame != nullptr) {
+        *frame = readback.frame;
     }
+
+    return true;
+}
+
+void Renderer::endRenderPass(RenderingContext& ctx) {
+    flush(ctx);
+    if (mode_ == SubmitMode::kParallel) {
+        assert(vkEndCommandBuffer(overlay_bufs_[current_frame_]) == VK_SUCCESS);
+        vkCmdExecuteCommands(cmd_bufs_[current_frame_], 1, &overlay_bufs_[current_frame_]);
+    }
+    vkCmdEndRenderPass(cmd_bufs_[current_frame_]);
+}
+
+bool Renderer::submitFrame(RenderingContext& ctx, VkSemaphore wait, VkSemaphore signal) {
+    // Submit uploads recorded since last frame ahead of this frame
+    ctx.transfer.flush(ctx);
+
+    VkSubmitInfo submit_info{};
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    VkPipelineStageFlags wait_stages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+    if (wait != VK_NULL_HANDLE) {
+        submit_info.waitSemaphoreCount = 1;
+        submit_info.pWaitSemaphores = &wait;
+        submit_info.pWaitDstStageMask = wait_stages;
+    }
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &cmd_bufs_[current_frame_];
+    if (signal != VK_NULL_HANDLE) {
+        submit_info.signalSemaphoreCount = 1;
+        submit_info.pSignalSemaphores = &signal;
+    }
+
+    VkResult ret = vkQueueSubmit(ctx.graphics_queue, 1, &submit_info, ctx.fences[current_frame_]);
+    if (ret != VK_SUCCESS) {
+        std::cerr << "Failed to graphics submit. Idx: " << current_frame_ << std::endl;
+        return false;
+    }
+    ctx.deletion_queue.onSubmit(current_frame_);
+    ++submitted_count_;
+
+    return true;
 }
 
 void Renderer::render(RenderingContext& ctx, Renderable& renderable, const Transform& transform, const Camera& camera) {
-    prepareRendering(ctx, renderable);
+    if (!isReady(renderable)) {
+        ++stats_.pending_count;
+        return;
+    }
 
-    VkCommandBuffer cmd_buf = cmd_bufs_[current_frame_];
-    Material& material = *renderable.material;
-    vkCmdBindPipeline(cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, material.getPipeline());
-
-    // Build MVP matrix
-    const Mat4 model =
-        glm::scale(glm::mat4(1.0f), transform.scale) *
-        glm::mat4_cast(transform.rotation) *
-        glm::translate(glm::mat4(1.0f), transform.position)
-        ;
-    const Mat4 view = glm::lookAt(
-        camera.transform.position,
-        camera.transform.position + camera.transform.rotation * Vec3(0.0f, 0.0f, 1.0f),
-        Vec3(0.0f, -1.0f, 0.0f)
-    );
-    const Mat4 proj = camera.getProjection();
-    const Mat4 mvp = proj * view * model;
-
-    // Copy MVP to uniform buffer
-    std::memcpy(uniforms_[renderable.id][current_frame_].mapped, &mvp, sizeof(Mat4));
-
-    // Set descriptor
-    vkCmdBindDescriptorSets(
-        cmd_bufs_[current_frame_],
-        VK_PIPELINE_BIND_POINT_GRAPHICS,
-        material.getPipelineLayout(),
-        0,
-        static_cast<uint32_t>(renderable.desc_sets[current_frame_].size()),
-        renderable.desc_sets[current_frame_].data(),
-        0,
-        nullptr
+    // View-projection and frustum are computed once per camera per frame
+    if (view_proj_camera_ != &camera) {
+        cullPending(); // Packets submitted with previous camera
+        const Mat4 proj = camera.getProjection();
+        view_proj_ = proj * camera.getView();
+        frustum_ = Frustum::create(view_proj_);
+        lod_pixel_scale_ = std::abs(proj[1][1]) * extent_.height * 0.5f;
+        view_proj_camera_ = &camera;
+    }
+
+    // Bounding sphere in world space
+    // NOTE: Scale is applied last (scale * rotation * translation), so max scale bounds the stretch
+    const Mat4 model = TransformStore::computeModel(transform);
+    const Bounds& bounds = renderable.geometry->bounds;
+    const Vec3 center = Vec3(model * Vec4(bounds.center, 1.0f));
+    const Vec3 scale = glm::abs(transform.scale);
+    const float max_scale = std::max(scale.x, std::max(scale.y, scale.z));
+    const float radius = bounds.radius * max_scale;
+
+    if (mode_ == SubmitMode::kImmediate && !frustum_.intersects(center, radius)) {
+        ++stats_.culled_count;
+        return;
+    }
+
+    const uint32_t lod = selectLod(*renderable.geometry, center, radius, max_scale);
+    uint32_t range_count = 0;
+    if (lod == 0 && !renderable.geometry->meshlets.empty()) {
+        range_count = cullClusters(*renderable.geometry, *renderable.material, model, transform, camera);
+        if (range_count == 0) {
+            ++stats_.culled_count;
+            return;
+        }
+    }
+
+    if (mode_ == SubmitMode::kImmediate) {
+        ++stats_.visible_count;
+    }
+    else {
+        pushCullSphere(center, radius);
+    }
+    submit(ctx, renderable, view_proj_ * model, lod, range_count);
+}
+
+void Renderer::render(RenderingContext& ctx, Renderable& renderable, const Mat4& mvp) {
+    if (!isReady(renderable)) {
+        ++stats_.pending_count;
+        return;
+    }
+
+    if (mode_ == SubmitMode::kImmediate) {
+        ++stats_.visible_count;
+    }
+    else {
+        // No world space bounds, so never culled
+        pushCullSphere(Vec3(0.0f), std::numeric_limits<float>::max());
+    }
+    submit(ctx, renderable, mvp, 0);
+}
+
+uint32_t Renderer::selectLod(const Geometry& geometry, const Vec3& center, float radius, float scale) const {
+    if (geometry.lods.size() <= 1) {
+        return 0;
+    }
+
+    // NOTE: Nearest point of the bounding sphere is the worst case. Inside the sphere always gets LOD 0.
+    const float depth =
+        view_proj_[0][3] * center.x + view_proj_[1][3] * center.y + view_proj_[2][3] * center.z + view_proj_[3][3] - radius;
+    if (depth <= 0.0f) {
+        return 0;
+    }
+    const float pixels_per_error = scale * lod_pixel_scale_ / depth;
+    for (size_t lod = geometry.lods.size() - 1; lod > 0; --lod) {
+        if (geometry.lods[lod].error * pixels_per_error <= lod_threshold_) {
+            return static_cast<uint32_t>(lod);
+        }
+    }
+    return 0;
+}
+
+uint32_t Renderer::cullClusters(const Geometry& geometry, const Material& material, const Mat4& model, const Transform& transform, const Camera& camera) {
+    // Test in object space, so that meshlet bounds are used as is
+    const Frustum frustum = Frustum::create(view_proj_ * model);
+    const Vec3 eye = Vec3(glm::inverse(model) * Vec4(camera.transform.position, 1.0f));
+
+    // Normal cones are only tested if back faces are culled
+    // NOTE: Cone angles are kept under uniform scale only. Mirroring model flips winding.
+    float facing = 0.0f;
+    const Vec3 scale = glm::abs(transform.scale);
+    const bool is_uniform = std::abs(scale.x - scale.y) <= 1e-4f * scale.x && std::abs(scale.x - scale.z) <= 1e-4f * scale.x;
+    if ((material.getCullMode() & VK_CULL_MODE_BACK_BIT) && !(material.getCullMode() & VK_CULL_MODE_FRONT_BIT) && is_uniform) {
+        facing = (material.getFrontFace() == VK_FRONT_FACE_CLOCKWISE) ? 1.0f : -1.0f;
+        if (transform.scale.x * transform.scale.y * transform.scale.z < 0.0f) {
+            facing = -facing;
+        }
+    }
+
+    const ClusterBounds& clusters = geometry.meshlet_bounds;
+    cluster_visible_.resize(clusters.size());
+    const size_t visible_count = frustum.cullClusters(clusters, eye, facing, cluster_visible_.data());
+    stats_.cluster_count += clusters.size();
+    stats_.cluster_culled_count += clusters.size() - visible_count;
+
+    // Meshlets are contiguous in index buffer, so runs of visible ones are drawn as one range
+    const size_t first_range = ranges_.size();
+    for (size_t i = 0; i < clusters.size(); ++i) {
+        if (!cluster_visible_[i]) {
+            continue;
+        }
+        const Meshlet& meshlet = geometry.meshlets[i];
+        if (ranges_.size() > first_range && ranges_.back().first_index + ranges_.back().index_count == meshlet.first_index) {
+            ranges_.back().index_count += meshlet.index_count;
+        }
+        else {
+            ranges_.push_back({ meshlet.first_index, meshlet.index_count });
+        }
+    }
+
+    return static_cast<uint32_t>(ranges_.size() - first_range);
+}
+
+void Renderer::pushCullSphere(const Vec3& center, float radius) {
+    cull_x_.push_back(center.x);
+    cull_y_.push_back(center.y);
+    cull_z_.push_back(center.z);
+    cull_r_.push_back(radius);
+}
+
+void Renderer::cullPending() {
+    const size_t count = cull_r_.size() - culled_count_;
+    if (count == 0) {
+        return;
+    }
+
+    visible_.resize(cull_r_.size());
+    const size_t visible_count = frustum_.cullSpheres(
+        &cull_x_[culled_count_],
+        &cull_y_[culled_count_],
+        &cull_z_[culled_count_],
+        &cull_r_[culled_count_],
+        count,
+        &visible_[culled_count_]
     );
+    stats_.visible_count += visible_count;
+    stats_.culled_count += count - visible_count;
+    culled_count_ = cull_r_.size();
+}
+
+void Renderer::submit(RenderingContext& ctx, Renderable& renderable, const Mat4& mvp, uint32_t lod, uint32_t range_count) {
+    Material& material = *renderable.material;
+    if (!material.isCompiled()) {
+        material.compile(ctx, render_pass_);
+    }
 
-    // Set geometry
     Geometry& geometry = *renderable.geometry;
-    const VkDeviceSize offsets[] = { 0 };
-    vkCmdBindVertexBuffers(cmd_buf, 0, 1, &geometry.vertex_buffer.buffer, offsets);
-    vkCmdBindIndexBuffer(cmd_buf, geometry.index_buffer.buffer, 0, VK_INDEX_TYPE_UINT32);
+    // Pipeline is selected by the vertex layout of the geometry. Built here, before recording may run on workers.
+    material.preparePipelines(ctx, geometry.vertex_format);
+    // Packed positions are in [0, 1] of bounds. Dequantization is folded into MVP.
+    const DrawPacket packet{
+        &material,
+        &geometry,
+        geometry.vertex_format == VertexFormat::kFloat ? mvp : mvp * geometry.dequantize,
+        lod,
+        static_cast<uint32_t>(ranges_.size() - range_count),
+        range_count
+    };
+    if (mode_ == SubmitMode::kImmediate) {
+        const DrawCommand draw = prepareDraw(ctx, packet);
+        recordDraws(recorder_, &draw, 1);
+        ranges_.clear();
+        return;
+    }
+
+    // Sort key: material (pipeline and descriptor set) | geometry | LOD | depth
+    // NOTE: Clip w of the object origin is its view depth. Bits of positive float increase monotonically.
+    const float depth = std::max(mvp[3][3], 0.0f);
+    uint32_t depth_bits = 0;
+    std::memcpy(&depth_bits, &depth, sizeof(float));
+    const uint64_t key =
+        (static_cast<uint64_t>(material.getId() & 0xFFFFF) << 44) |
+        (static_cast<uint64_t>(packet.geometry->id & 0xFFFFF) << 24) |
+        (static_cast<uint64_t>(std::min(lod, 7u)) << 21) |
+        (depth_bits >> 11); // Front to back within the same state
 
-    // Draw
-    vkCmdDrawIndexed(cmd_buf, static_cast<uint32_t>(geometry.indices.size()), 1, 0, 0, 0);
+    sort_items_.push_back({ key, static_cast<uint32_t>(packets_.size()) });
+    packets_.push_back(packet);
+}
+
+void Renderer::flush(RenderingContext& ctx) {
+    if (packets_.empty()) {
+        return;
+    }
+
+    // Drop culled packets. Sort items are still in submission order here.
+    cullPending();
+    size_t visible_count = 0;
+    for (const auto& item : sort_items_) {
+        if (visible_[item.value]) {
+            sort_items_[visible_count++] = item;
+        }
+    }
+    sort_items_.resize(visible_count);
+
+    radixSort(sort_items_, sort_tmp_);
+
+    // Draws sharing material and geometry are adjacent after sort. Merge them into one instanced draw.
+    draws_.clear();
+    for (size_t i = 0; i < sort_items_.size();) {
+        const DrawPacket& packet = packets_[sort_items_[i].value];
+        size_t count = 1;
+        if (packet.material->getInstancedPipeline(packet.geometry->vertex_format) != VK_NULL_HANDLE && packet.range_count == 0) {
+            while (i + count < sort_items_.size()) {
+                const DrawPacket& next = packets_[sort_items_[i + count].value];
+                if (next.material != packet.material || next.geometry != packet.geometry || next.lod != packet.lod || next.range_count != 0) {
+                    break;
+                }
+                ++count;
+            }
+        }
+
+        if (count >= kMinInstanceCount) {
+            draws_.push_back(prepareInstancedDraw(ctx, i, static_cast<uint32_t>(count)));
+        }
+        else {
+            for (size_t j = 0; j < count; ++j) {
+                draws_.push_back(prepareDraw(ctx, packets_[sort_items_[i + j].value]));
+            }
+        }
+        i += count;
+    }
+
+    if (mode_ == SubmitMode::kParallel) {
+        recordParallel();
+    }
+    else {
+        recordDraws(recorder_, draws_.data(), draws_.size());
+    }
+
+    packets_.clear();
+    sort_items_.clear();
+    cull_x_.clear();
+    cull_y_.clear();
+    cull_z_.clear();
+    cull_r_.clear();
+    culled_count_ = 0;
+    ranges_.clear();
+
+    // Commands recorded after flush may change any state
+    recorder_.bound = BoundState{};
+}
+
+Renderer::DrawCommand Renderer::prepareDraw(RenderingContext& ctx, const DrawPacket& packet) {
+    DrawCommand draw{ packet.material, packet.geometry, 0, 0, 0, packet.lod, packet.first_range, packet.range_count };
+    void* uniform = allocateData(ctx, sizeof(Mat4), draw.data_block, draw.data_offset);
+    std::memcpy(uniform, &packet.mvp, sizeof(Mat4));
+
+    return draw;
+}
+
+Renderer::DrawCommand Renderer::prepareInstancedDraw(RenderingContext& ctx, size_t first, uint32_t count) {
+    const DrawPacket& packet = packets_[sort_items_[first].value];
+    DrawCommand draw{ packet.material, packet.geometry, 0, 0, count, packet.lod, 0, 0 };
+
+    // Pack per-instance MVPs contiguously into this frame's buffer
+    InstanceData* instances = static_cast<InstanceData*>(allocateData(ctx, sizeof(InstanceData) * count, draw.data_block, draw.data_offset));
+    for (uint32_t i = 0; i < count; ++i) {
+        instances[i].mvp = packets_[sort_items_[first + i].value].mvp;
+    }
+
+    return draw;
+}
+
+void* Renderer::allocateData(RenderingContext& ctx, VkDeviceSize size, uint32_t& block, uint32_t& offset) {
+    UniformAllocator& uniform = uniforms_[current_frame_];
+    void* data = uniform.allocate(ctx, size, block, offset);
+    // NOTE: Sets are created before recording, since workers of kParallel only read them
+    std::vector<VkDescriptorSet>& sets = uniform_sets_[current_frame_];
+    while (sets.size() < uniform.blocks.size()) {
+        sets.push_back(createUniformSet(ctx, uniform_layout_, uniform.blocks[sets.size()]));
+    }
+
+    return data;
+}
+
+void Renderer::recordDraws(Recorder& recorder, const DrawCommand* draws, size_t count) const {
+    VkCommandBuffer cmd_buf = recorder.cmd_buf;
+    FrameStats& stats = *recorder.stats;
+
+    for (size_t i = 0; i < count; ++i) {
+        const DrawCommand& draw = draws[i];
+        const Material& material = *draw.material;
+        const Geometry& geometry = *draw.geometry;
+        const MeshLod& lod = geometry.lods[draw.lod];
+        // Pooled geometry shares buffers with others, and is addressed by offsets
+        const GeometryPool::Range pool_range = geometry.getPoolRange();
+
+        if (draw.instance_count == 0) {
+            bindPipeline(recorder, material.getPipeline(geometry.vertex_format));
+
+            // Set descriptor
+            // NOTE: Uniform set is bound every draw since its dynamic offset differs.
+            //       Set layouts of every material are identical, so bound material set stays valid across pipelines.
+            if (recorder.bound.material_set != material.getDescriptorSet()) {
+                const VkDescriptorSet sets[] = { material.getDescriptorSet(), uniform_sets_[current_frame_][draw.data_block] };
+                vkCmdBindDescriptorSets(cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, material.getPipelineLayout(), 0, 2, sets, 1, &draw.data_offset);
+                recorder.bound.material_set = material.getDescriptorSet();
+                ++stats.desc_set_binds;
+            }
+            else {
+                vkCmdBindDescriptorSets(cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, material.getPipelineLayout(), 1, 1, &uniform_sets_[current_frame_][draw.data_block], 1, &draw.data_offset);
+                ++stats.desc_set_binds_saved;
+            }
+
+            bindGeometry(recorder, geometry);
+            if (draw.range_count == 0) {
+                vkCmdDrawIndexed(cmd_buf, lod.index_count, 1, pool_range.first_index + lod.first_index, pool_range.base_vertex, 0);
+                stats.triangle_count += lod.index_count / 3;
+            }
+            else {
+                // Visible meshlets only. Each range is a draw.
+                for (uint32_t j = 0; j < draw.range_count; ++j) {
+                    const DrawRange& range = ranges_[draw.first_range + j];
+                    vkCmdDrawIndexed(cmd_buf, range.index_count, 1, pool_range.first_index + range.first_index, pool_range.base_vertex, 0);
+                    stats.triangle_count += range.index_count / 3;
+                }
+                stats.draw_count += draw.range_count - 1;
+            }
+        }
+        else {
+            bindPipeline(recorder, material.getInstancedPipeline(geometry.vertex_format));
+
+            // Set descriptor (instanced vertex shader does not read uniform set)
+            if (recorder.bound.material_set != material.getDescriptorSet()) {
+                const VkDescriptorSet material_set = material.getDescriptorSet();
+                vkCmdBindDescriptorSets(cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, material.getPipelineLayout(), 0, 1, &material_set, 0, nullptr);
+                recorder.bound.material_set = material_set;
+                ++stats.desc_set_binds;
+            }
+            else {
+                ++stats.desc_set_binds_saved;
+            }
+
+            bindGeometry(recorder, geometry);
+            const VkDeviceSize offset = draw.data_offset;
+            vkCmdBindVertexBuffers(cmd_buf, InstanceData::getBindingDescription().binding, 1, &uniforms_[current_frame_].blocks[draw.data_block].buffer, &offset);
+
+            vkCmdDrawIndexed(cmd_buf, lod.index_count, draw.instance_count, pool_range.first_index + lod.first_index, pool_range.base_vertex, 0);
+            stats.triangle_count += static_cast<size_t>(lod.index_count / 3) * draw.instance_count;
+            ++stats.instanced_draw_count;
+            stats.instance_count += draw.instance_count;
+        }
+        ++stats.draw_count;
+    }
+}
+
+void Renderer::recordParallel() {
+    if (draws_.empty()) {
+        return;
+    }
+
+    // Split draw list into contiguous chunks, one per worker. Each chunk is recorded into a secondary command buffer.
+    const size_t max_chunks = (draws_.size() + kMinDrawsPerWorker - 1) / kMinDrawsPerWorker;
+    const size_t chunk_count = std::min(worker_frames_.size(), max_chunks);
+    const size_t chunk_size = (draws_.size() + chunk_count - 1) / chunk_count;
+
+    std::vector<VkCommandBuffer> secondaries(chunk_count);
+    std::vector<FrameStats> chunk_stats(chunk_count);
+    std::vector<std::future<void>> futures;
+    for (size_t chunk = 0; chunk < chunk_count; ++chunk) {
+        futures.push_back(workers_->submit([this, chunk, chunk_size, &secondaries, &chunk_stats]() {
+            // NOTE: Command pool of the chunk is used only by this task, so no lock is required
+            const VkCommandBuffer cmd_buf = beginSecondary(worker_frames_[chunk][current_frame_]);
+            Recorder recorder{ cmd_buf, BoundState{}, &chunk_stats[chunk] };
+
+            const size_t first = chunk * chunk_size;
+            const size_t count = std::min(chunk_size, draws_.size() - first);
+            recordDraws(recorder, &draws_[first], count);
+
+            assert(vkEndCommandBuffer(cmd_buf) == VK_SUCCESS);
+            secondaries[chunk] = cmd_buf;
+        }));
+    }
+    for (auto& future : futures) {
+        future.get();
+    }
+
+    vkCmdExecuteCommands(cmd_bufs_[current_frame_], static_cast<uint32_t>(secondaries.size()), secondaries.data());
+    for (const auto& chunk_stat : chunk_stats) {
+        addStats(stats_, chunk_stat);
+    }
+}
+
+VkCommandBuffer Renderer::beginSecondary(WorkerFrame& worker_frame) const {
+    if (worker_frame.used == worker_frame.cmd_bufs.size()) {
+        VkCommandBufferAllocateInfo alloc_info{};
+        alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        alloc_info.commandPool = worker_frame.pool;
+        alloc_info.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        alloc_info.commandBufferCount = 1;
+
+        VkCommandBuffer cmd_buf;
+        assert(vkAllocateCommandBuffers(device_, &alloc_info, &cmd_buf) == VK_SUCCESS);
+        worker_frame.cmd_bufs.push_back(cmd_buf);
+    }
+    VkCommandBuffer cmd_buf = worker_frame.cmd_bufs[worker_frame.used++];
+
+    VkCommandBufferInheritanceInfo inheritance{};
+    inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritance.renderPass = render_pass_;
+    inheritance.subpass = 0;
+    inheritance.framebuffer = framebuffers_[img_idx_];
+
+    VkCommandBufferBeginInfo begin_info{};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    begin_info.pInheritanceInfo = &inheritance;
+    assert(vkBeginCommandBuffer(cmd_buf, &begin_info) == VK_SUCCESS);
+
+    // NOTE: Dynamic states are not inherited from primary
+    setViewportAndScissor(cmd_buf, extent_);
+
+    return cmd_buf;
+}
+
+void Renderer::bindPipeline(Recorder& recorder, VkPipeline pipeline) {
+    if (recorder.bound.pipeline != pipeline) {
+        vkCmdBindPipeline(recorder.cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+        recorder.bound.pipeline = pipeline;
+        ++recorder.stats->pipeline_binds;
+    }
+    else {
+        ++recorder.stats->pipeline_binds_saved;
+    }
+}
+
+void Renderer::bindGeometry(Recorder& recorder, const Geometry& geometry) {
+    if (recorder.bound.vertex_buffer != geometry.vertex_buffer.buffer) {
+        const VkDeviceSize offsets[] = { 0 };
+        vkCmdBindVertexBuffers(recorder.cmd_buf, 0, 1, &geometry.vertex_buffer.buffer, offsets);
+        recorder.bound.vertex_buffer = geometry.vertex_buffer.buffer;
+        recorder.bound.color_offset = VK_WHOLE_SIZE;
+        ++recorder.stats->vertex_buffer_binds;
+    }
+    else {
+        ++recorder.stats->vertex_buffer_binds_saved;
+    }
+    if (geometry.vertex_format != VertexFormat::kFloat) {
+        // NOTE: Per-vertex colors are also indexed from vertexOffset of pooled geometry, so binding is moved back by it
+        const GeometryPool::Range pool_range = geometry.getPoolRange();
+        VkDeviceSize color_offset = pool_range.vertex_offset + geometry.color_offset;
+        if (geometry.vertex_format == VertexFormat::kPacked) {
+            color_offset -= static_cast<VkDeviceSize>(pool_range.base_vertex) * sizeof(uint32_t);
+        }
+        if (recorder.bound.color_offset != color_offset) {
+            vkCmdBindVertexBuffers(recorder.cmd_buf, PackedVertex::kColorBinding, 1, &geometry.vertex_buffer.buffer, &color_offset);
+            recorder.bound.color_offset = color_offset;
+        }
+    }
+    if (recorder.bound.index_buffer != geometry.index_buffer.buffer || recorder.bound.index_type != geometry.index_type) {
+        vkCmdBindIndexBuffer(recorder.cmd_buf, geometry.index_buffer.buffer, 0, geometry.index_type);
+        recorder.bound.index_buffer = geometry.index_buffer.buffer;
+        recorder.bound.index_type = geometry.index_type;
+        ++recorder.stats->index_buffer_binds;
+    }
+    else {
+        ++recorder.stats->index_buffer_binds_saved;
+    }
+}
+
+void Renderer::setSubmitMode(SubmitMode mode) {
+    assert(mode != SubmitMode::kParallel || workers_ != nullptr);
+    mode_ = mode;
+}
+
+void Renderer::enableParallelRecording(RenderingContext& ctx, size_t thread_count) {
+    assert(workers_ == nullptr && thread_count > 0);
+    workers_ = std::make_shared<ThreadPool>(thread_count);
+
+    worker_frames_.resize(thread_count);
+    for (auto& worker_frame : worker_frames_) {
+        for (auto& frame : worker_frame) {
+            VkCommandPoolCreateInfo info{};
+            info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+            info.queueFamilyIndex = ctx.graphics_family;
+            assert(vkCreateCommandPool(ctx.device, &info, nullptr, &frame.pool) == VK_SUCCESS);
+            frame.used = 0;
+        }
+    }
+
+    VkCommandBufferAllocateInfo alloc_info{};
+    alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    alloc_info.commandPool = ctx.cmd_pool;
+    alloc_info.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+    alloc_info.commandBufferCount = static_cast<uint32_t>(overlay_bufs_.size());
+    assert(vkAllocateCommandBuffers(ctx.device, &alloc_info, overlay_bufs_.data()) == VK_SUCCESS);
+
+    mode_ = SubmitMode::kParallel;
 }
 
 void Renderer::compileMaterial(RenderingContext& ctx, const std::shared_ptr<Material>& material) {
+    // Placeholders of AssetLoader have no shader module or image view yet. submit() compiles it once loaded.
+    if (!material->isReady()) {
+        return;
+    }
     material->compile(ctx, render_pass_);
 }
 
-static VkRenderPass createRenderPass(RenderingContext& ctx, VkFormat swapchain_format /* TODO: remove swapchain_format */) {
+static VkRenderPass createRenderPass(RenderingContext& ctx, VkFormat color_format, VkImageLayout color_final_layout) {
     VkAttachmentDescription color{};
-    color.format = swapchain_format;
+    color.format = color_format;
     color.samples = VK_SAMPLE_COUNT_1_BIT;
     color.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
     color.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
     color.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     color.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     color.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    color.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    color.finalLayout = color_final_layout;
 
     VkAttachmentDescription depth{};
     depth.format = VK_FORMAT_D32_SFLOAT; // TODO: Query format support
@@ -308,13 +958,22 @@ static VkRenderPass createRenderPass(RenderingContext& ctx, VkFormat swapchain_f
     subpass.pColorAttachments = &color_ref;
     subpass.pDepthStencilAttachment = &depth_ref;
 
-    VkSubpassDependency deps{};
-    deps.srcSubpass = VK_SUBPASS_EXTERNAL;
-    deps.dstSubpass = 0;
-    deps.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    deps.srcAccessMask = 0;
-    deps.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    deps.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    std::array<VkSubpassDependency, 2> deps{};
+    deps[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+    deps[0].dstSubpass = 0;
+    deps[0].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    deps[0].srcAccessMask = 0;
+    deps[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    deps[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+    // Offscreen target is copied back after the render pass
+    const bool is_copied = (color_final_layout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+    deps[1].srcSubpass = 0;
+    deps[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+    deps[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    deps[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    deps[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    deps[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
 
     std::array<VkAttachmentDescription, 2> attachments = { color, depth };
     VkRenderPassCreateInfo renderPassInfo{};
@@ -323,8 +982,8 @@ static VkRenderPass createRenderPass(RenderingContext& ctx, VkFormat swapchain_f
     renderPassInfo.pAttachments = attachments.data();
     renderPassInfo.subpassCount = 1;
     renderPassInfo.pSubpasses = &subpass;
-    renderPassInfo.dependencyCount = 1;
-    renderPassInfo.pDependencies = &deps;
+    renderPassInfo.dependencyCount = is_copied ? 2 : 1;
+    renderPassInfo.pDependencies = deps.data();
 
     VkRenderPass render_pass;
     assert(vkCreateRenderPass(ctx.device, &renderPassInfo, nullptr, &render_pass) == VK_SUCCESS);
@@ -332,11 +991,17 @@ static VkRenderPass createRenderPass(RenderingContext& ctx, VkFormat swapchain_f
     return render_pass;
 }
 
-static std::vector<VkFramebuffer> createFramebuffers(RenderingContext& ctx, const Swapchain& swapchain, const Image& depth, VkRenderPass render_pass) {
-    std::vector<VkFramebuffer> framebuffers(swapchain.images.size());
-    for (size_t i = 0; i < swapchain.images.size(); i++) {
+static std::vector<VkFramebuffer> createFramebuffers(
+    RenderingContext& ctx,
+    const std::vector<VkImageView>& color_views,
+    const Image& depth,
+    VkRenderPass render_pass,
+    VkExtent2D extent
+) {
+    std::vector<VkFramebuffer> framebuffers(color_views.size());
+    for (size_t i = 0; i < color_views.size(); i++) {
         std::array<VkImageView, 2> attachments = {
-            swapchain.views[i],
+            color_views[i],
             depth.view
         };
 
@@ -345,8 +1010,8 @@ static std::vector<VkFramebuffer> createFramebuffers(RenderingContext& ctx, cons
         framebufferInfo.renderPass = render_pass;
         framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
         framebufferInfo.pAttachments = attachments.data();
-        framebufferInfo.width = swapchain.extent.width;
-        framebufferInfo.height = swapchain.extent.height;
+        framebufferInfo.width = extent.width;
+        framebufferInfo.height = extent.height;
         framebufferInfo.layers = 1;
 
         assert(vkCreateFramebuffer(ctx.device, &framebufferInfo, nullptr, &framebuffers[i]) == VK_SUCCESS);
@@ -372,3 +1037,122 @@ static Image createDepthImage(RenderingContext& ctx, VkExtent2D extent) {
 
     return depth;
 }
+
+static Buffer createReadbackBuffer(RenderingContext& ctx, VkDeviceSize size, VkMappedMemoryRange& range) {
+    VkPhysicalDeviceMemoryProperties mem_props{};
+    vkGetPhysicalDeviceMemoryProperties(ctx.gpu, &mem_props);
+    VkPhysicalDeviceProperties props{};
+    vkGetPhysicalDeviceProperties(ctx.gpu, &props);
+
+    // Prefer cached memory, since uncached reads by CPU are slow on discrete GPUs
+    const VkMemoryPropertyFlags cached = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+    VkMemoryPropertyFlags mem_flags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    bool is_coherent = true;
+    for (uint32_t i = 0; i < mem_props.memoryTypeCount; ++i) {
+        const VkMemoryPropertyFlags flags = mem_props.memoryTypes[i].propertyFlags;
+        if ((flags & cached) == cached) {
+            // NOTE: Allocator picks the first type with requested properties, which is this one
+            mem_flags = cached;
+            is_coherent = (flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+            break;
+        }
+    }
+
+    // Invalidated range must be aligned to nonCoherentAtomSize, so the buffer is padded to it
+    const VkDeviceSize atom = props.limits.nonCoherentAtomSize;
+    const Buffer buffer = Buffer::create(ctx, (size + atom - 1) / atom * atom, VK_BUFFER_USAGE_TRANSFER_DST_BIT, mem_flags);
+
+    range = VkMappedMemoryRange{};
+    range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+    if (!is_coherent) {
+        range.memory = buffer.allocation.memory;
+        range.offset = buffer.allocation.offset / atom * atom;
+        range.size = (buffer.allocation.offset + buffer.size + atom - 1) / atom * atom - range.offset;
+    }
+
+    return buffer;
+}
+
+static VkDescriptorSetLayout createUniformLayout(RenderingContext& ctx) {
+    // NOTE: Must be identical to descriptor set 1 of Shader, to be compatible with every material
+    VkDescriptorSetLayoutBinding binding{};
+    binding.binding = 0;
+    binding.descriptorCount = 1;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+    VkDescriptorSetLayoutCreateInfo info{};
+    info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    info.bindingCount = 1;
+    info.pBindings = &binding;
+
+    VkDescriptorSetLayout layout;
+    assert(vkCreateDescriptorSetLayout(ctx.device, &info, nullptr, &layout) == VK_SUCCESS);
+
+    return layout;
+}
+
+static VkDescriptorSet createUniformSet(RenderingContext& ctx, VkDescriptorSetLayout layout, const Buffer& buffer) {
+    VkDescriptorSetAllocateInfo alloc_info{};
+    alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    alloc_info.descriptorPool = ctx.desc_pool;
+    alloc_info.descriptorSetCount = 1;
+    alloc_info.pSetLayouts = &layout;
+
+    VkDescriptorSet set;
+    assert(vkAllocateDescriptorSets(ctx.device, &alloc_info, &set) == VK_SUCCESS);
+
+    // NOTE: Actual location of MVP is given by dynamic offset at binding
+    VkDescriptorBufferInfo buf_info{};
+    buf_info.buffer = buffer.buffer;
+    buf_info.offset = 0;
+    buf_info.range = sizeof(Mat4);
+
+    VkWriteDescriptorSet write_uniform{};
+    write_uniform.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write_uniform.dstSet = set;
+    write_uniform.dstBinding = 0;
+    write_uniform.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    write_uniform.descriptorCount = 1;
+    write_uniform.pBufferInfo = &buf_info;
+    vkUpdateDescriptorSets(ctx.device, 1, &write_uniform, 0, nullptr);
+
+    return set;
+}
+
+static void setViewportAndScissor(VkCommandBuffer cmd_buf, VkExtent2D extent) {
+    VkViewport viewport{};
+    viewport.width = static_cast<float>(extent.width);
+    viewport.height = static_cast<float>(extent.height);
+    viewport.maxDepth = 1.0f;
+    vkCmdSetViewport(cmd_buf, 0, 1, &viewport);
+
+    VkRect2D scissor{};
+    scissor.extent = extent;
+    vkCmdSetScissor(cmd_buf, 0, 1, &scissor);
+}
+
+static void addStats(Renderer::FrameStats& dst, const Renderer::FrameStats& src) {
+    dst.visible_count += src.visible_count;
+    dst.culled_count += src.culled_count;
+    dst.draw_count += src.draw_count;
+    dst.instanced_draw_count += src.instanced_draw_count;
+    dst.instance_count += src.instance_count;
+    dst.pipeline_binds += src.pipeline_binds;
+    dst.pipeline_binds_saved += src.pipeline_binds_saved;
+    dst.desc_set_binds += src.desc_set_binds;
+    dst.desc_set_binds_saved += src.desc_set_binds_saved;
+    dst.vertex_buffer_binds += src.vertex_buffer_binds;
+    dst.vertex_buffer_binds_saved += src.vertex_buffer_binds_saved;
+    dst.index_buffer_binds += src.index_buffer_binds;
+    dst.index_buffer_binds_saved += src.index_buffer_binds_saved;
+    dst.triangle_count += src.triangle_count;
+    dst.cluster_count += src.cluster_count;
+    dst.cluster_culled_count += src.cluster_culled_count;
+    dst.pending_count += src.pending_count;
+}
+
+// Assets still loaded by AssetLoader are placeholders without GPU objects
+static bool isReady(const Renderable& renderable) {
+    return !renderable.geometry->is_pending && renderable.material->isReady();
+}
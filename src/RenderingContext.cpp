@@ -1,9 +1,12 @@
 #include "kk_renderer/RenderingContext.h"
 #include "kk_renderer/Window.h"
+#include "kk_renderer/GeometryPool.h"
 #include <iostream>
 #include <set>
 #include <cassert>
 #include <functional>
+#include <algorithm>
+#include <cstring>
 
 using namespace kk::renderer;
 
@@ -13,7 +16,12 @@ static VkInstance createInstance(
 );
 static VkDebugUtilsMessengerEXT createDebugMessenger(VkInstance instance);
 static VkPhysicalDevice pickGPU(VkInstance instance, const std::vector<const char*>& exts);
-static VkDevice createLogicalDevice(VkPhysicalDevice gpu, const std::vector<const char*>& exts, const std::set<uint32_t>& families);
+static VkDevice createLogicalDevice(
+    VkPhysicalDevice gpu,
+    const std::vector<const char*>& exts,
+    const std::set<uint32_t>& families,
+    const VkPhysicalDeviceFeatures& features
+);
 static uint32_t findQueueFamily(
     VkPhysicalDevice device,
     std::function<bool(uint32_t, const VkQueueFamilyProperties&)> cond
@@ -23,6 +31,14 @@ static VkCommandPool createCommandPool(VkDevice device, uint32_t dst_queue_famil
 static VkDescriptorPool createDescPool(VkDevice device);
 static std::array<VkFence, kMaxConcurrentFrames> createFences(VkDevice device);
 static std::array<VkSemaphore, kMaxConcurrentFrames> createSemaphores(VkDevice device);
+static bool hasName(const std::vector<const char*>& names, const char* name);
+static bool isLayerSupported(const char* name);
+static bool isInstanceExtensionSupported(const char* name);
+static RenderingContext createContext(
+    const std::vector<const char*>& instance_exts,
+    const std::vector<const char*>& layers,
+    const std::vector<const char*>& device_exts
+);
 
 RenderingContext RenderingContext::create() {
     std::vector<const char*> instance_exts = Window::getRequiredExtensions();
@@ -34,28 +50,76 @@ RenderingContext RenderingContext::create() {
         VK_KHR_SWAPCHAIN_EXTENSION_NAME,
     };
 
+    return createContext(instance_exts, layers, device_exts);
+}
+
+RenderingContext RenderingContext::createHeadless() {
+    // NOTE: Headless machines (e.g. CI with lavapipe) may lack validation layer, so enable it only if available
+    std::vector<const char*> instance_exts;
+    std::vector<const char*> layers;
+    if (isInstanceExtensionSupported(VK_EXT_DEBUG_UTILS_EXTENSION_NAME)) {
+        instance_exts.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+    }
+    if (isLayerSupported("VK_LAYER_KHRONOS_validation")) {
+        layers.push_back("VK_LAYER_KHRONOS_validation");
+    }
+    else {
+        std::cerr << "Warning: Validation layer is unavailable" << std::endl;
+    }
+
+    return createContext(instance_exts, layers, {});
+}
+
+static RenderingContext createContext(
+    const std::vector<const char*>& instance_exts,
+    const std::vector<const char*>& layers,
+    const std::vector<const char*>& device_exts
+) {
     RenderingContext ctx{};
     ctx.instance = createInstance(instance_exts, layers);
-    ctx.debug_messenger = createDebugMessenger(ctx.instance);
+    ctx.debug_messenger = hasName(instance_exts, VK_EXT_DEBUG_UTILS_EXTENSION_NAME) ? createDebugMessenger(ctx.instance) : VK_NULL_HANDLE;
     ctx.gpu = pickGPU(ctx.instance, device_exts);
     ctx.graphics_family = findQueueFamily(ctx.gpu, [](uint32_t i, const VkQueueFamilyProperties& prop) {
         return (prop.queueFlags & VK_QUEUE_GRAPHICS_BIT);
     });
     ctx.present_family = ctx.graphics_family; // CONCERN
-    ctx.device = createLogicalDevice(ctx.gpu, device_exts, { ctx.graphics_family, ctx.present_family });
+    // Optional features are enabled if supported
+    VkPhysicalDeviceFeatures supported{};
+    vkGetPhysicalDeviceFeatures(ctx.gpu, &supported);
+    VkPhysicalDeviceFeatures features{};
+    features.samplerAnisotropy = supported.samplerAnisotropy;
+    ctx.device = createLogicalDevice(ctx.gpu, device_exts, { ctx.graphics_family, ctx.present_family }, features);
+    ctx.max_anisotropy = 1.0f;
+    if (features.samplerAnisotropy) {
+        VkPhysicalDeviceProperties props{};
+        vkGetPhysicalDeviceProperties(ctx.gpu, &props);
+        ctx.max_anisotropy = std::min(kDefaultMaxAnisotropy, props.limits.maxSamplerAnisotropy);
+    }
     ctx.graphics_queue = getQueue(ctx.device, ctx.graphics_family);
     ctx.present_queue = getQueue(ctx.device, ctx.present_family);
+    ctx.allocator = MemoryAllocator::create(ctx.gpu, ctx.device);
     ctx.cmd_pool = createCommandPool(ctx.device, ctx.graphics_family);
     ctx.desc_pool = createDescPool(ctx.device);
     ctx.fences = createFences(ctx.device);
     ctx.present_complete = createSemaphores(ctx.device);
     ctx.render_complete = createSemaphores(ctx.device);
+    ctx.transfer = TransferBatcher::create(ctx, TransferBatcher::kDefaultStagingSize);
+    ctx.deletion_queue = DeletionQueue::create(kMaxConcurrentFrames);
+    ctx.sampler_cache = SamplerCache::create();
 
     return ctx;
 }
 
 void RenderingContext::destroy() {
     assert(vkDeviceWaitIdle(device) == VK_SUCCESS);
+    transfer.destroy(*this);
+    if (geometry_pool != nullptr) {
+        geometry_pool->destroy(*this);
+    }
+    deletion_queue.flush(*this);
+    // NOTE: Released after flush, since pending frees of pooled geometries refer to it
+    geometry_pool.reset();
+    sampler_cache.destroy(*this);
 
     for (size_t i = 0; i < kMaxConcurrentFrames; ++i) {
         vkDestroyFence(device, fences[i], nullptr);
@@ -65,9 +129,10 @@ void RenderingContext::destroy() {
 
     vkDestroyDescriptorPool(device, desc_pool, nullptr);
     vkDestroyCommandPool(device, cmd_pool, nullptr);
+    allocator.destroy();
     vkDestroyDevice(device, nullptr);
     auto destroyer = (PFN_vkDestroyDebugUtilsMessengerEXT)vkGetInstanceProcAddr(instance, "vkDestroyDebugUtilsMessengerEXT");
-    if (destroyer != nullptr) {
+    if (destroyer != nullptr && debug_messenger != VK_NULL_HANDLE) {
         destroyer(instance, debug_messenger, nullptr);
     }
     vkDestroyInstance(instance, nullptr);
@@ -127,8 +192,10 @@ static VkInstance createInstance(
     info.enabledLayerCount = static_cast<uint32_t>(layers.size());
     info.ppEnabledLayerNames = layers.data();
     VkDebugUtilsMessengerCreateInfoEXT debug_info{};
-    populateDebugMessengerCreateInfo(debug_info);
-    info.pNext = &debug_info;
+    if (hasName(exts, VK_EXT_DEBUG_UTILS_EXTENSION_NAME)) {
+        populateDebugMessengerCreateInfo(debug_info);
+        info.pNext = &debug_info;
+    }
 
     VkInstance instance;
     assert(vkCreateInstance(&info, nullptr, &instance) == VK_SUCCESS);
@@ -148,6 +215,44 @@ static VkDebugUtilsMessengerEXT createDebugMessenger(VkInstance instance) {
     return debug_messenger;
 }
 
+static bool hasName(const std::vector<const char*>& names, const char* name) {
+    return std::find_if(names.begin(), names.end(), [name](const char* n) {
+        return std::strcmp(n, name) == 0;
+    }) != names.end();
+}
+
+static bool isLayerSupported(const char* name) {
+    uint32_t layer_count = 0;
+    vkEnumerateInstanceLayerProperties(&layer_count, nullptr);
+
+    std::vector<VkLayerProperties> layers(layer_count);
+    vkEnumerateInstanceLayerProperties(&layer_count, layers.data());
+
+    for (const auto& layer : layers) {
+        if (std::strcmp(layer.layerName, name) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool isInstanceExtensionSupported(const char* name) {
+    uint32_t ext_count = 0;
+    vkEnumerateInstanceExtensionProperties(nullptr, &ext_count, nullptr);
+
+    std::vector<VkExtensionProperties> exts(ext_count);
+    vkEnumerateInstanceExtensionProperties(nullptr, &ext_count, exts.data());
+
+    for (const auto& ext : exts) {
+        if (std::strcmp(ext.extensionName, name) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 static bool isExtensionsSupported(VkPhysicalDevice gpu, const std::vector<const char*>& exts_required) {
     uint32_t ext_count = 0;
     vkEnumerateDeviceExtensionProperties(gpu, nullptr, &ext_count, nullptr);
@@ -199,9 +304,12 @@ static uint32_t findQueueFamily(
     return UINT32_MAX;
 }
 
-static VkDevice createLogicalDevice(VkPhysicalDevice gpu, const std::vector<const char*>& exts, const std::set<uint32_t>& families) {
-    VkPhysicalDeviceFeatures features{};
-
+static VkDevice createLogicalDevice(
+    VkPhysicalDevice gpu,
+    const std::vector<const char*>& exts,
+    const std::set<uint32_t>& families,
+    const VkPhysicalDeviceFeatures& features
+) {
     std::vector<VkDeviceQueueCreateInfo> queue_infos;
     queue_infos.reserve(families.size());
     float priority = 1.0f;
@@ -246,15 +354,19 @@ static VkCommandPool createCommandPool(VkDevice device, uint32_t dst_queue_famil
 }
 
 static VkDescriptorPool createDescPool(VkDevice device) {
-    VkDescriptorPoolSize pool_sizes{};
-    pool_sizes.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    pool_sizes.descriptorCount = static_cast<uint32_t>(kMaxConcurrentFrames) * 256;
+    std::array<VkDescriptorPoolSize, 3> pool_sizes{};
+    pool_sizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    pool_sizes[0].descriptorCount = static_cast<uint32_t>(kMaxConcurrentFrames) * 256;
+    pool_sizes[1].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    pool_sizes[1].descriptorCount = static_cast<uint32_t>(kMaxConcurrentFrames) * 256;
+    pool_sizes[2].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    pool_sizes[2].descriptorCount = static_cast<uint32_t>(kMaxConcurrentFrames) * 256;
 
     VkDescriptorPoolCreateInfo info{};
     info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
     info.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
-    info.poolSizeCount = 1;
-    info.pPoolSizes = &pool_sizes;
+    info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+    info.pPoolSizes = pool_sizes.data();
     info.maxSets = static_cast<uint32_t>(kMaxConcurrentFrames) * 256; // TODO: Set max number of objects
 
     VkDescriptorPool pool;
@@ -287,7 +399,7 @@ static std::array<VkSemaphore, kMaxConcurrentFrames> createSemaphores(VkDevice d
     return semaphores;
 }
 
-VkImageView RenderingContext::createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags) {
+VkImageView RenderingContext::createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mip_levels) {
     VkImageViewCreateInfo viewInfo{};
     viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
     viewInfo.image = image;
@@ -295,7 +407,7 @@ VkImageView RenderingContext::createImageView(VkImage image, VkFormat format, Vk
     viewInfo.format = format;
     viewInfo.subresourceRange.aspectMask = aspectFlags;
     viewInfo.subresourceRange.baseMipLevel = 0;
-    viewInfo.subresourceRange.levelCount = 1;
+    viewInfo.subresourceRange.levelCount = mip_levels;
     viewInfo.subresourceRange.baseArrayLayer = 0;
     viewInfo.subresourceRange.layerCount = 1;
 
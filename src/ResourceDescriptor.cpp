@@ -9,14 +9,16 @@ using namespace kk::renderer;
 ResourceDescriptor::ResourceDescriptor() : layout_(VK_NULL_HANDLE), set_(VK_NULL_HANDLE) {}
 
 void ResourceDescriptor::destroy(RenderingContext& ctx) {
-    vkDeviceWaitIdle(ctx.device);
-
-    if (set_ != VK_NULL_HANDLE) {
-        vkFreeDescriptorSets(ctx.device, ctx.desc_pool, 1, &set_);
-    }
-    if (layout_ != VK_NULL_HANDLE) {
-        vkDestroyDescriptorSetLayout(ctx.device, layout_, nullptr);
-    }
+    const VkDescriptorSet set = set_;
+    const VkDescriptorSetLayout layout = layout_;
+    ctx.deletion_queue.push([set, layout](RenderingContext& ctx) {
+        if (set != VK_NULL_HANDLE) {
+            vkFreeDescriptorSets(ctx.device, ctx.desc_pool, 1, &set);
+        }
+        if (layout != VK_NULL_HANDLE) {
+            vkDestroyDescriptorSetLayout(ctx.device, layout, nullptr);
+        }
+    });
 
     // Release resources
     for (auto& kvp : resources_) {
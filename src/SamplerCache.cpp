@@ -0,0 +1,71 @@
+#include "kk_renderer/SamplerCache.h"
+#include "kk_renderer/RenderingContext.h"
+#include <cassert>
+#include <cstring>
+
+using namespace kk::renderer;
+
+static uint32_t toBits(float value);
+
+SamplerCache SamplerCache::create() {
+    return SamplerCache();
+}
+
+void SamplerCache::destroy(RenderingContext& ctx) {
+    for (auto& sampler : samplers_) {
+        vkDestroySampler(ctx.device, sampler.second, nullptr);
+    }
+    samplers_.clear();
+}
+
+VkSampler SamplerCache::get(RenderingContext& ctx, const VkSamplerCreateInfo& info) {
+    assert(info.pNext == nullptr);
+    const Key key = makeKey(info);
+    auto found = samplers_.find(key);
+    if (found != samplers_.end()) {
+        return found->second;
+    }
+
+    VkSampler sampler;
+    assert(vkCreateSampler(ctx.device, &info, nullptr, &sampler) == VK_SUCCESS);
+    samplers_.emplace(key, sampler);
+
+    return sampler;
+}
+
+SamplerCache::Key SamplerCache::makeKey(const VkSamplerCreateInfo& info) {
+    // NOTE: Fields are copied one by one, since padding of the struct is undefined
+    return Key{ {
+        info.flags,
+        static_cast<uint32_t>(info.magFilter),
+        static_cast<uint32_t>(info.minFilter),
+        static_cast<uint32_t>(info.mipmapMode),
+        static_cast<uint32_t>(info.addressModeU),
+        static_cast<uint32_t>(info.addressModeV),
+        static_cast<uint32_t>(info.addressModeW),
+        toBits(info.mipLodBias),
+        info.anisotropyEnable,
+        toBits(info.maxAnisotropy),
+        info.compareEnable,
+        static_cast<uint32_t>(info.compareOp),
+        toBits(info.minLod),
+        toBits(info.maxLod),
+        static_cast<uint32_t>(info.borderColor) | (info.unnormalizedCoordinates << 16)
+    } };
+}
+
+// FNV-1a over the fields
+size_t SamplerCache::KeyHash::operator()(const Key& key) const {
+    uint64_t hash = 14695981039346656037ull;
+    for (uint32_t field : key) {
+        hash ^= field;
+        hash *= 1099511628211ull;
+    }
+    return static_cast<size_t>(hash);
+}
+
+static uint32_t toBits(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
@@ -1,21 +1,21 @@
 #include "kk_renderer/Shader.h"
 #include <cassert>
-#include <iostream>
+#include <stdexcept>
 #include <fstream>
 
 using namespace kk::renderer;
 
-static std::vector<char> readFile(const std::string& path);
-
 Shader Shader::create(RenderingContext& ctx, const std::string& path) {
-    const std::vector<char> code = readFile(path);
+    return Shader::create(ctx, loadCode(path));
+}
 
+Shader Shader::create(RenderingContext& ctx, const std::vector<char>& code) {
     VkShaderModuleCreateInfo info{};
     info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
     info.codeSize = code.size();
     info.pCode = reinterpret_cast<const uint32_t*>(code.data());
 
-    Shader shader;
+    Shader shader{};
     assert(vkCreateShaderModule(ctx.device, &info, nullptr, &shader.module) == VK_SUCCESS);
     
     // TODO: Get from shader reflection
@@ -29,7 +29,7 @@ Shader Shader::create(RenderingContext& ctx, const std::string& path) {
     shader.sets_bindings[1].resize(1);
     shader.sets_bindings[1][0].binding = 0;
     shader.sets_bindings[1][0].descriptorCount = 1;
-    shader.sets_bindings[1][0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    shader.sets_bindings[1][0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
     shader.sets_bindings[1][0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
     
     return shader;
@@ -39,12 +39,11 @@ void Shader::destroy(RenderingContext& ctx) {
     vkDestroyShaderModule(ctx.device, module, nullptr);
 }
 
-static std::vector<char> readFile(const std::string& path) {
+std::vector<char> Shader::loadCode(const std::string& path) {
     std::ifstream file(path, std::ios::ate | std::ios::binary);
 
     if (!file.is_open()) {
-        std::cerr << "Failed to open " << path << std::endl;
-        assert(false);
+        throw std::runtime_error("Failed to open " + path);
     }
 
     size_t fileSize = (size_t)file.tellg();
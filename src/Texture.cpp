@@ -1,45 +1,277 @@
 #include "kk_renderer/Texture.h"
-#include "kk_renderer/Buffer.h"
+#include "kk_renderer/TextureLoader.h"
+#include "kk_renderer/ThreadPool.h"
 #include <cassert>
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb/stb_image.h>
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
 #include <iostream>
+#include <stdexcept>
 
 using namespace kk::renderer;
 
-static void createImage(RenderingContext& ctx, const void* texels, size_t texel_byte, Texture& texture);
+constexpr VkDeviceSize TextureData::kLevelAlignment;
+
+static Texture createBase(
+    uint32_t width,
+    uint32_t height,
+    VkFormat format,
+    VkImageTiling tiling,
+    VkImageUsageFlags usage,
+    VkMemoryPropertyFlags props,
+    VkImageAspectFlags aspect
+);
+static void createImage(RenderingContext& ctx, const void* texels, VkDeviceSize size, const std::vector<VkDeviceSize>& level_offsets, Texture& texture);
 static void createImageView(RenderingContext& ctx, Texture& texture);
 static void createSampler(RenderingContext& ctx, Texture& texture);
+static bool canBlit(RenderingContext& ctx, VkFormat format);
+static bool canSample(RenderingContext& ctx, VkFormat format);
+static bool hasExtension(const std::string& path, const char* extension);
+static bool isSrgb(VkFormat format);
+static bool is8BitChannels(VkFormat format, size_t texel_byte);
+
+TextureData TextureData::load(const std::string& path) {
+    TextureData data{};
+    if (hasExtension(path, ".ktx2")) {
+        loadKtx2(path, data);
+        return data;
+    }
+    if (hasExtension(path, ".dds")) {
+        loadDds(path, data);
+        return data;
+    }
 
-Texture Texture::create(RenderingContext& ctx, const std::string& path) {
     int x, y, channels;
-    void* texels = stbi_load(path.c_str(), &x, &y, &channels, STBI_rgb_alpha);
+    stbi_uc* texels = stbi_load(path.c_str(), &x, &y, &channels, STBI_rgb_alpha);
     if (texels == nullptr) {
-        std::cerr << "Failed to load " << path << std::endl;
-        assert(false);
+        throw std::runtime_error("Failed to load " + path);
+    }
+
+    data.texel_byte = 4;
+    data.width = static_cast<uint32_t>(x);
+    data.height = static_cast<uint32_t>(y);
+    data.format = VK_FORMAT_R8G8B8A8_SRGB;
+    data.texels.assign(texels, texels + data.texel_byte * data.width * data.height);
+    data.level_offsets.push_back(0);
+    stbi_image_free(texels);
+
+    return data;
+}
+
+bool TextureData::generateMips() {
+    if (!is8BitChannels(format, texel_byte)) {
+        return false;
+    }
+
+    // sRGB colour is averaged in linear space, as blit does. Alpha is always linear.
+    const bool is_srgb = isSrgb(format);
+    const size_t color_channels = (texel_byte == 4) ? 3 : texel_byte;
+    static const std::vector<float> to_linear = []() {
+        std::vector<float> table(256);
+        for (size_t i = 0; i < table.size(); ++i) {
+            const float c = i / 255.0f;
+            table[i] = (c <= 0.04045f) ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+        return table;
+    }();
+
+    const uint32_t mip_levels = Texture::getMipLevels(width, height);
+    texels.resize(texel_byte * width * height);
+    level_offsets.assign(1, 0);
+    uint32_t src_width = width, src_height = height;
+    for (uint32_t level = 1; level < mip_levels; ++level) {
+        const uint32_t dst_width = std::max(src_width / 2, 1u), dst_height = std::max(src_height / 2, 1u);
+        const VkDeviceSize src_offset = level_offsets.back();
+        const VkDeviceSize src_end = src_offset + texel_byte * src_width * src_height;
+        const VkDeviceSize dst_offset = (src_end + TextureData::kLevelAlignment - 1) / TextureData::kLevelAlignment * TextureData::kLevelAlignment;
+        texels.resize(dst_offset + texel_byte * dst_width * dst_height);
+        level_offsets.push_back(dst_offset);
+
+        const uint8_t* src = texels.data() + src_offset;
+        uint8_t* dst = texels.data() + dst_offset;
+        for (uint32_t y = 0; y < dst_height; ++y) {
+            // Odd edge of a level folds into the last texel
+            const uint32_t y0 = std::min(y * 2, src_height - 1), y1 = std::min(y * 2 + 1, src_height - 1);
+            for (uint32_t x = 0; x < dst_width; ++x) {
+                const uint32_t x0 = std::min(x * 2, src_width - 1), x1 = std::min(x * 2 + 1, src_width - 1);
+                const uint8_t* corners[4] = {
+                    src + (y0 * src_width + x0) * texel_byte,
+                    src + (y0 * src_width + x1) * texel_byte,
+                    src + (y1 * src_width + x0) * texel_byte,
+                    src + (y1 * src_width + x1) * texel_byte,
+                };
+                uint8_t* out = dst + (y * dst_width + x) * texel_byte;
+                for (size_t c = 0; c < texel_byte; ++c) {
+                    if (is_srgb && c < color_channels) {
+                        const float linear = (to_linear[corners[0][c]] + to_linear[corners[1][c]] + to_linear[corners[2][c]] + to_linear[corners[3][c]]) * 0.25f;
+                        const float srgb = (linear <= 0.0031308f) ? linear * 12.92f : 1.055f * std::pow(linear, 1.0f / 2.4f) - 0.055f;
+                        out[c] = static_cast<uint8_t>(std::min(std::max(srgb * 255.0f + 0.5f, 0.0f), 255.0f));
+                    }
+                    else {
+                        out[c] = static_cast<uint8_t>((corners[0][c] + corners[1][c] + corners[2][c] + corners[3][c] + 2) / 4);
+                    }
+                }
+            }
+        }
+
+        src_width = dst_width;
+        src_height = dst_height;
     }
 
-    Texture texture = Texture::create(
+    return true;
+}
+
+Texture Texture::create(RenderingContext& ctx, const std::string& path, uint32_t flags) {
+    return Texture::create(ctx, TextureData::load(path), flags);
+}
+
+std::vector<Texture> Texture::createBatch(
+    RenderingContext& ctx,
+    const std::vector<std::string>& paths,
+    uint32_t flags,
+    size_t thread_count
+) {
+    if (thread_count == 0) {
+        thread_count = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    }
+    ThreadPool workers(std::min(thread_count, std::max<size_t>(paths.size(), 1)));
+    std::vector<std::future<TextureData>> decoded;
+    decoded.reserve(paths.size());
+    for (const auto& path : paths) {
+        decoded.push_back(workers.submit([path]() { return TextureData::load(path); }));
+    }
+
+    // Uploads are recorded as decoding proceeds. The next texture is decoded while one is recorded.
+    std::vector<Texture> textures;
+    textures.reserve(paths.size());
+    try {
+        for (auto& data : decoded) {
+            textures.push_back(Texture::create(ctx, data.get(), flags));
+        }
+    }
+    catch (const std::runtime_error&) {
+        for (auto& texture : textures) {
+            texture.destroy(ctx);
+        }
+        throw;
+    }
+    ctx.transfer.flush(ctx);
+
+    return textures;
+}
+
+Texture Texture::create(RenderingContext& ctx, const TextureData& data, uint32_t flags) {
+    // NOTE: Block-compressed data is never blitted nor decoded, so its mips are all it has
+    const bool is_compressed = getBlockByte(data.format) != 0;
+    if (is_compressed || (data.getMipLevels() > 1 && !(flags & kTextureNoMipmaps))) {
+        if (is_compressed && !canSample(ctx, data.format)) {
+            throw std::runtime_error("Texture format is unsupported by the device");
+        }
+        Texture texture = createBase(
+            data.width,
+            data.height,
+            data.format,
+            VK_IMAGE_TILING_OPTIMAL,
+            VK_IMAGE_USAGE_SAMPLED_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            VK_IMAGE_ASPECT_COLOR_BIT
+        );
+        texture.mip_levels = (flags & kTextureNoMipmaps) ? 1 : data.getMipLevels();
+        const std::vector<VkDeviceSize> level_offsets(data.level_offsets.begin(), data.level_offsets.begin() + texture.mip_levels);
+        const VkDeviceSize size = (texture.mip_levels < data.getMipLevels()) ? data.level_offsets[texture.mip_levels] : data.texels.size();
+        createImage(ctx, data.texels.data(), size, level_offsets, texture);
+        createImageView(ctx, texture);
+        createSampler(ctx, texture);
+
+        return texture;
+    }
+
+    return Texture::create(
         ctx,
-        texels,
-        4,
-        static_cast<uint32_t>(x),
-        static_cast<uint32_t>(y),
-        VK_FORMAT_R8G8B8A8_SRGB,
+        data.texels.data(),
+        data.texel_byte,
+        data.width,
+        data.height,
+        data.format,
         VK_IMAGE_TILING_OPTIMAL,
         VK_IMAGE_USAGE_SAMPLED_BIT,
         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-        VK_IMAGE_ASPECT_COLOR_BIT
+        VK_IMAGE_ASPECT_COLOR_BIT,
+        flags
     );
-    stbi_image_free(texels);
-
-    return texture;
 }
 
 Texture Texture::create(
     RenderingContext& ctx,
     const void* texels,
     size_t texel_byte,
+    uint32_t width,
+    uint32_t height,
+    VkFormat format,
+    VkImageTiling tiling,
+    VkImageUsageFlags usage,
+    VkMemoryPropertyFlags props,
+    VkImageAspectFlags aspect,
+    uint32_t flags
+) {
+    Texture texture = createBase(width, height, format, tiling, usage, props, aspect);
+    const VkDeviceSize size = texel_byte * width * height;
+    const bool has_mips = !(flags & kTextureNoMipmaps) && tiling == VK_IMAGE_TILING_OPTIMAL && (usage & VK_IMAGE_USAGE_SAMPLED_BIT);
+    if (has_mips && canBlit(ctx, format)) {
+        texture.mip_levels = getMipLevels(width, height);
+        createImage(ctx, texels, size, {}, texture);
+    }
+    else if (has_mips) {
+        // Format cannot be blitted, so the chain is generated on CPU
+        TextureData data{};
+        data.texels.assign(static_cast<const uint8_t*>(texels), static_cast<const uint8_t*>(texels) + size);
+        data.level_offsets.push_back(0);
+        data.texel_byte = texel_byte;
+        data.width = width;
+        data.height = height;
+        data.format = format;
+        if (data.generateMips()) {
+            texture.mip_levels = data.getMipLevels();
+        }
+        else {
+            std::cerr << "Warning: Mipmaps of format " << format << " are unsupported" << std::endl;
+        }
+        createImage(ctx, data.texels.data(), data.texels.size(), data.level_offsets, texture);
+    }
+    else {
+        createImage(ctx, texels, size, {}, texture);
+    }
+    createImageView(ctx, texture);
+    createSampler(ctx, texture);
+
+    return texture;
+}
+
+void Texture::destroy(RenderingContext& ctx) {
+    // NOTE: In-flight frames and pending uploads may still refer to this texture
+    // NOTE: Sampler is shared through RenderingContext::sampler_cache, which owns it
+    const VkImageView texture_view = view;
+    const VkImage texture_image = image;
+    const Allocation texture_allocation = allocation;
+    ctx.deletion_queue.push([texture_view, texture_image, texture_allocation](RenderingContext& ctx) {
+        vkDestroyImageView(ctx.device, texture_view, nullptr);
+        vkDestroyImage(ctx.device, texture_image, nullptr);
+        ctx.allocator.free(texture_allocation);
+    });
+}
+
+uint32_t Texture::getMipLevels(uint32_t width, uint32_t height) {
+    uint32_t levels = 1;
+    for (uint32_t size = std::max(width, height); size > 1; size /= 2) {
+        ++levels;
+    }
+    return levels;
+}
+
+static Texture createBase(
     uint32_t width,
     uint32_t height,
     VkFormat format,
@@ -56,24 +288,15 @@ Texture Texture::create(
     texture.usage   = usage;
     texture.props   = props;
     texture.aspect  = aspect;
-    
-    createImage(ctx, texels, texel_byte, texture);
-    createImageView(ctx, texture);
-    createSampler(ctx, texture);
+    texture.mip_levels = 1;
 
     return texture;
 }
 
-void Texture::destroy(RenderingContext& ctx) {
-    vkDeviceWaitIdle(ctx.device);
-
-    vkDestroySampler(ctx.device, sampler, nullptr);
-    vkDestroyImageView(ctx.device, view, nullptr);
-    vkFreeMemory(ctx.device, memory, nullptr);
-    vkDestroyImage(ctx.device, image, nullptr);
-}
+// Uploads mips at `level_offsets` of `texels` if given, otherwise mip 0 and blits the rest of texture.mip_levels
+static void createImage(RenderingContext& ctx, const void* texels, VkDeviceSize size, const std::vector<VkDeviceSize>& level_offsets, Texture& texture) {
+    const bool is_blitted = level_offsets.size() <= 1 && texture.mip_levels > 1;
 
-static void createImage(RenderingContext& ctx, const void* texels, size_t texel_byte, Texture& texture) {
     // Create image
     VkImageCreateInfo img_info{};
     img_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -81,12 +304,12 @@ static void createImage(RenderingContext& ctx, const void* texels, size_t texel_
     img_info.extent.width = texture.width;
     img_info.extent.height = texture.height;
     img_info.extent.depth = 1;
-    img_info.mipLevels = 1;
+    img_info.mipLevels = texture.mip_levels;
     img_info.arrayLayers = 1;
     img_info.format = texture.format;
     img_info.tiling = texture.tiling;
     img_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    img_info.usage = texture.usage | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    img_info.usage = texture.usage | VK_IMAGE_USAGE_TRANSFER_DST_BIT | (is_blitted ? VK_IMAGE_USAGE_TRANSFER_SRC_BIT : 0);
     img_info.samples = VK_SAMPLE_COUNT_1_BIT;
     img_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
     assert(vkCreateImage(ctx.device, &img_info, nullptr, &texture.image) == VK_SUCCESS);
@@ -94,30 +317,21 @@ static void createImage(RenderingContext& ctx, const void* texels, size_t texel_
     // Allocate memory
     VkMemoryRequirements mem_reqs{};
     vkGetImageMemoryRequirements(ctx.device, texture.image, &mem_reqs);
-    VkMemoryAllocateInfo alloc_info{};
-    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    alloc_info.allocationSize = mem_reqs.size;
-    alloc_info.memoryTypeIndex = ctx.findMemoryType(mem_reqs.memoryTypeBits, texture.props);
-    assert(vkAllocateMemory(ctx.device, &alloc_info, nullptr, &texture.memory) == VK_SUCCESS);
+    texture.allocation = ctx.allocator.allocate(mem_reqs, texture.props, texture.tiling == VK_IMAGE_TILING_LINEAR);
 
-    vkBindImageMemory(ctx.device, texture.image, texture.memory, 0);
+    assert(vkBindImageMemory(ctx.device, texture.image, texture.allocation.memory, texture.allocation.offset) == VK_SUCCESS);
 
-    // Set texels
-    Buffer staging = Buffer::create(
-        ctx,
-        texel_byte * texture.width * texture.height,
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-    );
-    staging.setData(ctx, texels, staging.size);
-    ctx.transitionImageLayout(texture.image, texture.format, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-    staging.copyTo(ctx, texture, { texture.width, texture.height });
-    ctx.transitionImageLayout(texture.image, texture.format, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-    staging.destroy(ctx);
+    // Set texels (transitions, copy and blits are recorded into transfer batch)
+    if (level_offsets.size() > 1) {
+        ctx.transfer.uploadImageLevels(ctx, texture.image, { texture.width, texture.height }, texels, size, level_offsets);
+    }
+    else {
+        ctx.transfer.uploadImage(ctx, texture.image, { texture.width, texture.height }, texels, size, texture.mip_levels);
+    }
 }
 
 static void createImageView(RenderingContext& ctx, Texture& texture) {
-    texture.view = ctx.createImageView(texture.image, texture.format, texture.aspect);
+    texture.view = ctx.createImageView(texture.image, texture.format, texture.aspect, texture.mip_levels);
 }
 
 static void createSampler(RenderingContext& ctx, Texture& texture) {
@@ -128,13 +342,74 @@ static void createSampler(RenderingContext& ctx, Texture& texture) {
     info.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
     info.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
     info.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-    info.anisotropyEnable = VK_FALSE;
-    info.maxAnisotropy = 0;
+    info.anisotropyEnable = (ctx.max_anisotropy > 1.0f) ? VK_TRUE : VK_FALSE;
+    info.maxAnisotropy = ctx.max_anisotropy;
     info.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
     info.unnormalizedCoordinates = VK_FALSE;
     info.compareEnable = VK_FALSE;
     info.compareOp = VK_COMPARE_OP_ALWAYS;
     info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    info.minLod = 0.0f;
+    // Mips are limited by the image view, so that textures of any mip count share the sampler
+    info.maxLod = VK_LOD_CLAMP_NONE;
 
-    assert(vkCreateSampler(ctx.device, &info, nullptr, &texture.sampler) == VK_SUCCESS);
+    texture.sampler = ctx.sampler_cache.get(ctx, info);
+}
+
+static bool canBlit(RenderingContext& ctx, VkFormat format) {
+    const VkFormatFeatureFlags required =
+        VK_FORMAT_FEATURE_BLIT_SRC_BIT |
+        VK_FORMAT_FEATURE_BLIT_DST_BIT |
+        VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    VkFormatProperties props{};
+    vkGetPhysicalDeviceFormatProperties(ctx.gpu, format, &props);
+    return (props.optimalTilingFeatures & required) == required;
+}
+
+static bool isSrgb(VkFormat format) {
+    switch (format) {
+    case VK_FORMAT_R8_SRGB:
+    case VK_FORMAT_R8G8_SRGB:
+    case VK_FORMAT_R8G8B8A8_SRGB:
+    case VK_FORMAT_B8G8R8A8_SRGB:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static bool is8BitChannels(VkFormat format, size_t texel_byte) {
+    switch (format) {
+    case VK_FORMAT_R8_UNORM:
+    case VK_FORMAT_R8_SRGB:
+        return texel_byte == 1;
+    case VK_FORMAT_R8G8_UNORM:
+    case VK_FORMAT_R8G8_SRGB:
+        return texel_byte == 2;
+    case VK_FORMAT_R8G8B8A8_UNORM:
+    case VK_FORMAT_R8G8B8A8_SRGB:
+    case VK_FORMAT_B8G8R8A8_UNORM:
+    case VK_FORMAT_B8G8R8A8_SRGB:
+        return texel_byte == 4;
+    default:
+        return false;
+    }
+}
+
+static bool canSample(RenderingContext& ctx, VkFormat format) {
+    const VkFormatFeatureFlags required = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    VkFormatProperties props{};
+    vkGetPhysicalDeviceFormatProperties(ctx.gpu, format, &props);
+    return (props.optimalTilingFeatures & required) == required;
+}
+
+// Case-insensitive
+static bool hasExtension(const std::string& path, const char* extension) {
+    const size_t length = std::strlen(extension);
+    if (path.size() < length) {
+        return false;
+    }
+    return std::equal(path.end() - length, path.end(), extension, [](char a, char b) {
+        return std::tolower(static_cast<unsigned char>(a)) == b;
+    });
 }
@@ -0,0 +1,221 @@
+#include "kk_renderer/TextureLoader.h"
+#include "kk_renderer/MappedFile.h"
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+
+using namespace kk::renderer;
+
+// NOTE: Containers are little endian, as are supported hosts
+static constexpr uint8_t kKtx2Identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+static constexpr size_t kKtx2HeaderSize = 80; // Identifier, header and index, followed by level index
+static constexpr size_t kKtx2LevelSize = 24;
+
+static constexpr char kDdsMagic[4] = { 'D', 'D', 'S', ' ' };
+static constexpr size_t kDdsHeaderSize = 4 + 124;
+static constexpr size_t kDdsDx10HeaderSize = 20;
+static constexpr uint32_t kDdsMipMapCount = 0x20000;   // DDSD_MIPMAPCOUNT
+static constexpr uint32_t kDdsFourCC = 0x4;            // DDPF_FOURCC
+static constexpr uint32_t kDdsCubemap = 0x200;         // DDSCAPS2_CUBEMAP
+static constexpr uint32_t kDdsVolume = 0x200000;       // DDSCAPS2_VOLUME
+static constexpr uint32_t kDxgiTexture2D = 3;          // D3D10_RESOURCE_DIMENSION_TEXTURE2D
+static constexpr uint32_t kDxgiTextureCube = 0x4;      // DDS_RESOURCE_MISC_TEXTURECUBE
+
+template <class T>
+static T read(const char* bytes, size_t offset) {
+    T value;
+    std::memcpy(&value, bytes + offset, sizeof(T));
+    return value;
+}
+
+static constexpr uint32_t makeFourCC(char a, char b, char c, char d) {
+    return static_cast<uint32_t>(a) | (static_cast<uint32_t>(b) << 8) | (static_cast<uint32_t>(c) << 16) | (static_cast<uint32_t>(d) << 24);
+}
+
+static VkFormat getDxgiFormat(uint32_t dxgi_format);
+static void loadContainer(const std::string& path, TextureData& data, void (*parse)(const char*, size_t, TextureData&));
+static void beginLevels(VkFormat format, uint32_t width, uint32_t height, TextureData& data);
+static void appendLevel(const char* bytes, size_t size, uint64_t offset, uint64_t level_size, TextureData& data);
+
+void kk::renderer::loadKtx2(const std::string& path, TextureData& data) {
+    loadContainer(path, data, parseKtx2);
+}
+
+void kk::renderer::loadDds(const std::string& path, TextureData& data) {
+    loadContainer(path, data, parseDds);
+}
+
+void kk::renderer::parseKtx2(const char* bytes, size_t size, TextureData& data) {
+    if (size < kKtx2HeaderSize || std::memcmp(bytes, kKtx2Identifier, sizeof(kKtx2Identifier)) != 0) {
+        throw std::runtime_error("Not a KTX2 file");
+    }
+    const VkFormat format = static_cast<VkFormat>(read<uint32_t>(bytes, 12));
+    const uint32_t width = read<uint32_t>(bytes, 20);
+    const uint32_t height = read<uint32_t>(bytes, 24);
+    const uint32_t depth = read<uint32_t>(bytes, 28);
+    const uint32_t layer_count = read<uint32_t>(bytes, 32);
+    const uint32_t face_count = read<uint32_t>(bytes, 36);
+    // NOTE: 0 levels asks the loader to generate mips, which is not possible for block-compressed data
+    const uint32_t level_count = std::max(read<uint32_t>(bytes, 40), 1u);
+    const uint32_t supercompression = read<uint32_t>(bytes, 44);
+    if (getBlockByte(format) == 0) {
+        throw std::runtime_error("Unsupported KTX2 format");
+    }
+    if (width == 0 || height == 0 || depth > 1 || layer_count > 1 || face_count != 1) {
+        throw std::runtime_error("KTX2 image is not 2D");
+    }
+    if (supercompression != 0) {
+        throw std::runtime_error("Supercompressed KTX2 is unsupported");
+    }
+    if (level_count > Texture::getMipLevels(width, height) || kKtx2HeaderSize + kKtx2LevelSize * level_count > size) {
+        throw std::runtime_error("Malformed KTX2 level index");
+    }
+
+    beginLevels(format, width, height, data);
+    for (uint32_t level = 0; level < level_count; ++level) {
+        const size_t entry = kKtx2HeaderSize + kKtx2LevelSize * level;
+        const uint64_t offset = read<uint64_t>(bytes, entry);
+        const uint64_t level_size = read<uint64_t>(bytes, entry + 8);
+        if (level_size != getBlockCompressedSize(format, std::max(width >> level, 1u), std::max(height >> level, 1u))) {
+            throw std::runtime_error("Malformed KTX2 level size");
+        }
+        appendLevel(bytes, size, offset, level_size, data);
+    }
+}
+
+void kk::renderer::parseDds(const char* bytes, size_t size, TextureData& data) {
+    if (size < kDdsHeaderSize || std::memcmp(bytes, kDdsMagic, sizeof(kDdsMagic)) != 0 || read<uint32_t>(bytes, 4) != 124) {
+        throw std::runtime_error("Not a DDS file");
+    }
+    const uint32_t flags = read<uint32_t>(bytes, 8);
+    const uint32_t height = read<uint32_t>(bytes, 12);
+    const uint32_t width = read<uint32_t>(bytes, 16);
+    const uint32_t mip_count = read<uint32_t>(bytes, 28);
+    const uint32_t pixel_flags = read<uint32_t>(bytes, 80);
+    const uint32_t four_cc = read<uint32_t>(bytes, 84);
+    const uint32_t caps2 = read<uint32_t>(bytes, 112);
+    if (!(pixel_flags & kDdsFourCC)) {
+        throw std::runtime_error("Unsupported DDS format");
+    }
+    if (width == 0 || height == 0 || (caps2 & (kDdsCubemap | kDdsVolume))) {
+        throw std::runtime_error("DDS image is not 2D");
+    }
+
+    // Legacy FourCC carries no colour space. Colour formats are taken as sRGB, as decoded images are.
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    size_t offset = kDdsHeaderSize;
+    switch (four_cc) {
+    case makeFourCC('D', 'X', 'T', '1'):
+        format = VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+        break;
+    case makeFourCC('D', 'X', 'T', '5'):
+        format = VK_FORMAT_BC3_SRGB_BLOCK;
+        break;
+    case makeFourCC('A', 'T', 'I', '2'):
+    case makeFourCC('B', 'C', '5', 'U'):
+        format = VK_FORMAT_BC5_UNORM_BLOCK;
+        break;
+    case makeFourCC('D', 'X', '1', '0'): {
+        if (size < kDdsHeaderSize + kDdsDx10HeaderSize) {
+            throw std::runtime_error("Malformed DDS DX10 header");
+        }
+        format = getDxgiFormat(read<uint32_t>(bytes, kDdsHeaderSize));
+        const uint32_t dimension = read<uint32_t>(bytes, kDdsHeaderSize + 4);
+        const uint32_t misc_flags = read<uint32_t>(bytes, kDdsHeaderSize + 8);
+        const uint32_t array_size = read<uint32_t>(bytes, kDdsHeaderSize + 12);
+        if (dimension != kDxgiTexture2D || (misc_flags & kDxgiTextureCube) || array_size > 1) {
+            throw std::runtime_error("DDS image is not 2D");
+        }
+        offset += kDdsDx10HeaderSize;
+        break;
+    }
+    default:
+        break;
+    }
+    if (getBlockByte(format) == 0) {
+        throw std::runtime_error("Unsupported DDS format");
+    }
+
+    const uint32_t level_count = ((flags & kDdsMipMapCount) && mip_count > 0) ? mip_count : 1;
+    if (level_count > Texture::getMipLevels(width, height)) {
+        throw std::runtime_error("Malformed DDS mip count");
+    }
+
+    // Mips follow the header back to back, mip 0 first
+    beginLevels(format, width, height, data);
+    for (uint32_t level = 0; level < level_count; ++level) {
+        const uint64_t level_size = getBlockCompressedSize(format, std::max(width >> level, 1u), std::max(height >> level, 1u));
+        appendLevel(bytes, size, offset, level_size, data);
+        offset += level_size;
+    }
+}
+
+size_t kk::renderer::getBlockByte(VkFormat format) {
+    switch (format) {
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+    case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+        return 8;
+    case VK_FORMAT_BC3_UNORM_BLOCK:
+    case VK_FORMAT_BC3_SRGB_BLOCK:
+    case VK_FORMAT_BC5_UNORM_BLOCK:
+    case VK_FORMAT_BC5_SNORM_BLOCK:
+    case VK_FORMAT_BC7_UNORM_BLOCK:
+    case VK_FORMAT_BC7_SRGB_BLOCK:
+        return 16;
+    default:
+        return 0;
+    }
+}
+
+VkDeviceSize kk::renderer::getBlockCompressedSize(VkFormat format, uint32_t width, uint32_t height) {
+    const VkDeviceSize blocks_x = (width + 3) / 4, blocks_y = (height + 3) / 4;
+    return blocks_x * blocks_y * getBlockByte(format);
+}
+
+static VkFormat getDxgiFormat(uint32_t dxgi_format) {
+    switch (dxgi_format) {
+    case 71: return VK_FORMAT_BC1_RGBA_UNORM_BLOCK; // DXGI_FORMAT_BC1_UNORM
+    case 72: return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;  // DXGI_FORMAT_BC1_UNORM_SRGB
+    case 77: return VK_FORMAT_BC3_UNORM_BLOCK;      // DXGI_FORMAT_BC3_UNORM
+    case 78: return VK_FORMAT_BC3_SRGB_BLOCK;       // DXGI_FORMAT_BC3_UNORM_SRGB
+    case 83: return VK_FORMAT_BC5_UNORM_BLOCK;      // DXGI_FORMAT_BC5_UNORM
+    case 84: return VK_FORMAT_BC5_SNORM_BLOCK;      // DXGI_FORMAT_BC5_SNORM
+    case 98: return VK_FORMAT_BC7_UNORM_BLOCK;      // DXGI_FORMAT_BC7_UNORM
+    case 99: return VK_FORMAT_BC7_SRGB_BLOCK;       // DXGI_FORMAT_BC7_UNORM_SRGB
+    default: return VK_FORMAT_UNDEFINED;
+    }
+}
+
+static void loadContainer(const std::string& path, TextureData& data, void (*parse)(const char*, size_t, TextureData&)) {
+    MappedFile file = MappedFile::create(path);
+    try {
+        parse(file.data, file.size, data);
+    }
+    catch (const std::runtime_error& e) {
+        file.destroy();
+        throw std::runtime_error(std::string(e.what()) + ": " + path);
+    }
+    file.destroy();
+}
+
+static void beginLevels(VkFormat format, uint32_t width, uint32_t height, TextureData& data) {
+    data.texels.clear();
+    data.level_offsets.clear();
+    data.texel_byte = getBlockByte(format);
+    data.width = width;
+    data.height = height;
+    data.format = format;
+}
+
+static void appendLevel(const char* bytes, size_t size, uint64_t offset, uint64_t level_size, TextureData& data) {
+    if (offset > size || level_size > size - offset) {
+        throw std::runtime_error("Texture level out of file");
+    }
+    const VkDeviceSize level_offset = (data.texels.size() + TextureData::kLevelAlignment - 1) / TextureData::kLevelAlignment * TextureData::kLevelAlignment;
+    data.texels.resize(level_offset);
+    data.texels.insert(data.texels.end(), bytes + offset, bytes + offset + level_size);
+    data.level_offsets.push_back(level_offset);
+}
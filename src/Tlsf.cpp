@@ -0,0 +1,271 @@
+#include "kk_renderer/Tlsf.h"
+#include <cassert>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+using namespace kk::renderer;
+
+constexpr uint32_t Tlsf::kInvalidNode;
+
+// Index of the most significant set bit. v must not be 0.
+static uint32_t fls64(uint64_t v) {
+#if defined(_MSC_VER)
+    unsigned long idx;
+    _BitScanReverse64(&idx, v);
+    return static_cast<uint32_t>(idx);
+#else
+    return 63 - static_cast<uint32_t>(__builtin_clzll(v));
+#endif
+}
+
+// Index of the least significant set bit. v must not be 0.
+static uint32_t ffs64(uint64_t v) {
+#if defined(_MSC_VER)
+    unsigned long idx;
+    _BitScanForward64(&idx, v);
+    return static_cast<uint32_t>(idx);
+#else
+    return static_cast<uint32_t>(__builtin_ctzll(v));
+#endif
+}
+
+Tlsf::Tlsf() : fl_bitmap_(0), size_(0), used_(0), allocation_count_(0) {
+    sl_bitmaps_.fill(0);
+    heads_.fill(kInvalidNode);
+}
+
+void Tlsf::init(uint64_t size) {
+    assert(size > 0);
+
+    nodes_.clear();
+    unused_nodes_.clear();
+    fl_bitmap_ = 0;
+    sl_bitmaps_.fill(0);
+    heads_.fill(kInvalidNode);
+    size_ = size;
+    used_ = 0;
+    allocation_count_ = 0;
+
+    // Whole range is one free block
+    const uint32_t node = newNode();
+    nodes_[node].offset = 0;
+    nodes_[node].size = size;
+    insertFree(node);
+}
+
+uint32_t Tlsf::allocate(uint64_t size, uint64_t alignment, uint64_t& offset) {
+    if (size == 0) {
+        size = 1;
+    }
+    if (alignment == 0) {
+        alignment = 1;
+    }
+    assert((alignment & (alignment - 1)) == 0);
+
+    // Any free block of the class found can hold the request even in the worst alignment
+    const uint32_t node = findFree(size + alignment - 1);
+    if (node == kInvalidNode) {
+        return kInvalidNode;
+    }
+    removeFree(node);
+
+    // Split off padding in front of the aligned offset
+    const uint64_t aligned = (nodes_[node].offset + alignment - 1) & ~(alignment - 1);
+    const uint64_t padding = aligned - nodes_[node].offset;
+    if (padding > 0) {
+        const uint32_t front = newNode();
+        nodes_[front].offset = nodes_[node].offset;
+        nodes_[front].size = padding;
+        nodes_[front].prev_phys = nodes_[node].prev_phys;
+        nodes_[front].next_phys = node;
+        if (nodes_[node].prev_phys != kInvalidNode) {
+            nodes_[nodes_[node].prev_phys].next_phys = front;
+        }
+        nodes_[node].prev_phys = front;
+        nodes_[node].offset = aligned;
+        nodes_[node].size -= padding;
+        insertFree(front);
+    }
+
+    // Return remainder to free lists
+    if (nodes_[node].size > size) {
+        const uint32_t back = newNode();
+        nodes_[back].offset = nodes_[node].offset + size;
+        nodes_[back].size = nodes_[node].size - size;
+        nodes_[back].prev_phys = node;
+        nodes_[back].next_phys = nodes_[node].next_phys;
+        if (nodes_[node].next_phys != kInvalidNode) {
+            nodes_[nodes_[node].next_phys].prev_phys = back;
+        }
+        nodes_[node].next_phys = back;
+        nodes_[node].size = size;
+        insertFree(back);
+    }
+
+    nodes_[node].is_free = false;
+    used_ += size;
+    ++allocation_count_;
+
+    offset = aligned;
+    return node;
+}
+
+void Tlsf::free(uint32_t node) {
+    assert(node < nodes_.size() && !nodes_[node].is_free);
+
+    used_ -= nodes_[node].size;
+    --allocation_count_;
+
+    // Coalesce with previous block
+    const uint32_t prev = nodes_[node].prev_phys;
+    if (prev != kInvalidNode && nodes_[prev].is_free) {
+        removeFree(prev);
+        nodes_[prev].size += nodes_[node].size;
+        nodes_[prev].next_phys = nodes_[node].next_phys;
+        if (nodes_[node].next_phys != kInvalidNode) {
+            nodes_[nodes_[node].next_phys].prev_phys = prev;
+        }
+        releaseNode(node);
+        node = prev;
+    }
+
+    // Coalesce with next block
+    const uint32_t next = nodes_[node].next_phys;
+    if (next != kInvalidNode && nodes_[next].is_free) {
+        removeFree(next);
+        nodes_[node].size += nodes_[next].size;
+        nodes_[node].next_phys = nodes_[next].next_phys;
+        if (nodes_[next].next_phys != kInvalidNode) {
+            nodes_[nodes_[next].next_phys].prev_phys = node;
+        }
+        releaseNode(next);
+    }
+
+    insertFree(node);
+}
+
+uint64_t Tlsf::getLargestFreeRange() const {
+    if (fl_bitmap_ == 0) {
+        return 0;
+    }
+
+    // Largest block lives in the highest non-empty class
+    const uint32_t fl = fls64(fl_bitmap_);
+    const uint32_t sl = fls64(sl_bitmaps_[fl]);
+    uint64_t largest = 0;
+    for (uint32_t node = heads_[fl * kSlCount + sl]; node != kInvalidNode; node = nodes_[node].next_free) {
+        largest = (nodes_[node].size > largest) ? nodes_[node].size : largest;
+    }
+
+    return largest;
+}
+
+void Tlsf::mapping(uint64_t size, uint32_t& fl, uint32_t& sl) {
+    fl = fls64(size);
+    // Small classes are split by first level only
+    sl = (fl < kSlLog) ? 0 : static_cast<uint32_t>(size >> (fl - kSlLog)) & ((1u << kSlLog) - 1);
+}
+
+uint32_t Tlsf::newNode() {
+    uint32_t node;
+    if (unused_nodes_.empty()) {
+        node = static_cast<uint32_t>(nodes_.size());
+        nodes_.push_back(Node{});
+    }
+    else {
+        node = unused_nodes_.back();
+        unused_nodes_.pop_back();
+    }
+
+    Node& n = nodes_[node];
+    n.offset = n.size = 0;
+    n.prev_phys = n.next_phys = kInvalidNode;
+    n.prev_free = n.next_free = kInvalidNode;
+    n.is_free = false;
+
+    return node;
+}
+
+void Tlsf::releaseNode(uint32_t node) {
+    unused_nodes_.push_back(node);
+}
+
+void Tlsf::insertFree(uint32_t node) {
+    uint32_t fl, sl;
+    mapping(nodes_[node].size, fl, sl);
+    const uint32_t list = fl * kSlCount + sl;
+
+    nodes_[node].is_free = true;
+    nodes_[node].prev_free = kInvalidNode;
+    nodes_[node].next_free = heads_[list];
+    if (heads_[list] != kInvalidNode) {
+        nodes_[heads_[list]].prev_free = node;
+    }
+    heads_[list] = node;
+
+    fl_bitmap_ |= (1ull << fl);
+    sl_bitmaps_[fl] |= (1u << sl);
+}
+
+void Tlsf::removeFree(uint32_t node) {
+    uint32_t fl, sl;
+    mapping(nodes_[node].size, fl, sl);
+    const uint32_t list = fl * kSlCount + sl;
+
+    const uint32_t prev = nodes_[node].prev_free;
+    const uint32_t next = nodes_[node].next_free;
+    if (prev != kInvalidNode) {
+        nodes_[prev].next_free = next;
+    }
+    else {
+        heads_[list] = next;
+    }
+    if (next != kInvalidNode) {
+        nodes_[next].prev_free = prev;
+    }
+
+    if (heads_[list] == kInvalidNode) {
+        sl_bitmaps_[fl] &= ~(1u << sl);
+        if (sl_bitmaps_[fl] == 0) {
+            fl_bitmap_ &= ~(1ull << fl);
+        }
+    }
+
+    nodes_[node].is_free = false;
+    nodes_[node].prev_free = nodes_[node].next_free = kInvalidNode;
+}
+
+uint32_t Tlsf::findFree(uint64_t size) const {
+    // Round request up to the next class boundary, so that every block of the class found fits
+    const uint32_t size_fl = fls64(size);
+    if (size_fl < kSlLog) {
+        if ((size & (size - 1)) != 0) {
+            size = 1ull << (size_fl + 1);
+        }
+    }
+    else {
+        const uint64_t round = (1ull << (size_fl - kSlLog)) - 1;
+        if (size > UINT64_MAX - round) {
+            return kInvalidNode;
+        }
+        size += round;
+    }
+
+    uint32_t fl, sl;
+    mapping(size, fl, sl);
+
+    uint32_t sl_map = sl_bitmaps_[fl] & (~0u << sl);
+    if (sl_map == 0) {
+        // Search larger first level classes
+        const uint64_t fl_map = (fl + 1 < kFlCount) ? (fl_bitmap_ & (~0ull << (fl + 1))) : 0;
+        if (fl_map == 0) {
+            return kInvalidNode;
+        }
+        fl = ffs64(fl_map);
+        sl_map = sl_bitmaps_[fl];
+    }
+    sl = ffs64(sl_map);
+
+    return heads_[fl * kSlCount + sl];
+}
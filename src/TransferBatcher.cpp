@@ -0,0 +1,400 @@
+#include "kk_renderer/TransferBatcher.h"
+#include "kk_renderer/RenderingContext.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+using namespace kk::renderer;
+
+constexpr VkDeviceSize TransferBatcher::kDefaultStagingSize;
+
+// NOTE: Satisfies bufferOffset requirements of buffer to image copies (multiple of 4 and texel size)
+static constexpr VkDeviceSize kStagingAlignment = 16;
+
+TransferBatcher TransferBatcher::create(RenderingContext& ctx, VkDeviceSize staging_size) {
+    TransferBatcher batcher{};
+    batcher.ring_ = createStagingBuffer(ctx, staging_size);
+    batcher.capacity_ = staging_size;
+    batcher.head_ = batcher.tail_ = 0;
+    batcher.is_recording_ = false;
+    batcher.submit_count_ = 0;
+
+    return batcher;
+}
+
+void TransferBatcher::destroy(RenderingContext& ctx) {
+    flush(ctx);
+    wait(ctx);
+
+    for (auto& batch : free_batches_) {
+        vkFreeCommandBuffers(ctx.device, ctx.cmd_pool, 1, &batch.cmd_buf);
+        vkDestroyFence(ctx.device, batch.fence, nullptr);
+    }
+    free_batches_.clear();
+
+    vkDestroyBuffer(ctx.device, ring_.buffer, nullptr);
+    ctx.allocator.free(ring_.allocation);
+}
+
+void TransferBatcher::uploadBuffer(RenderingContext& ctx, VkBuffer dst, VkDeviceSize dst_offset, const void* src, VkDeviceSize size) {
+    VkBuffer src_buffer;
+    VkDeviceSize src_offset;
+    std::memcpy(stage(ctx, size, src_buffer, src_offset), src, size);
+
+    VkBufferCopy region{};
+    region.srcOffset = src_offset;
+    region.dstOffset = dst_offset;
+    region.size = size;
+    vkCmdCopyBuffer(getCmdBuf(ctx), src_buffer, dst, 1, &region);
+}
+
+void TransferBatcher::uploadImage(RenderingContext& ctx, VkImage dst, VkExtent2D extent, const void* src, VkDeviceSize size, uint32_t mip_levels) {
+    VkBuffer src_buffer;
+    VkDeviceSize src_offset;
+    std::memcpy(stage(ctx, size, src_buffer, src_offset), src, size);
+
+    VkCommandBuffer cmd_buf = getCmdBuf(ctx);
+
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = dst;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = mip_levels;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    VkBufferImageCopy region{};
+    region.bufferOffset = src_offset;
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+    region.imageExtent = { extent.width, extent.height, 1 };
+    vkCmdCopyBufferToImage(cmd_buf, src_buffer, dst, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+    // Each mip is blitted from the previous one, which is then done and handed to shaders
+    barrier.subresourceRange.levelCount = 1;
+    int32_t width = static_cast<int32_t>(extent.width), height = static_cast<int32_t>(extent.height);
+    for (uint32_t level = 1; level < mip_levels; ++level) {
+        barrier.subresourceRange.baseMipLevel = level - 1;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        const int32_t next_width = std::max(width / 2, 1), next_height = std::max(height / 2, 1);
+        VkImageBlit blit{};
+        blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        blit.srcSubresource.mipLevel = level - 1;
+        blit.srcSubresource.baseArrayLayer = 0;
+        blit.srcSubresource.layerCount = 1;
+        blit.srcOffsets[1] = { width, height, 1 };
+        blit.dstSubresource = blit.srcSubresource;
+        blit.dstSubresource.mipLevel = level;
+        blit.dstOffsets[1] = { next_width, next_height, 1 };
+        vkCmdBlitImage(
+            cmd_buf,
+            dst, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            dst, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            1, &blit,
+            VK_FILTER_LINEAR
+        );
+
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        width = next_width;
+        height = next_height;
+    }
+
+    // Last mip is only written
+    barrier.subresourceRange.baseMipLevel = mip_levels - 1;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+void TransferBatcher::uploadImageLevels(
+    RenderingContext& ctx,
+    VkImage dst,
+    VkExtent2D extent,
+    const void* src,
+    VkDeviceSize size,
+    const std::vector<VkDeviceSize>& level_offsets
+) {
+    VkBuffer src_buffer;
+    VkDeviceSize src_offset;
+    std::memcpy(stage(ctx, size, src_buffer, src_offset), src, size);
+
+    VkCommandBuffer cmd_buf = getCmdBuf(ctx);
+    const uint32_t mip_levels = static_cast<uint32_t>(level_offsets.size());
+
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = dst;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = mip_levels;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    std::vector<VkBufferImageCopy> regions(mip_levels);
+    for (uint32_t level = 0; level < mip_levels; ++level) {
+        VkBufferImageCopy& region = regions[level];
+        region.bufferOffset = src_offset + level_offsets[level];
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = level;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageExtent = { std::max(extent.width >> level, 1u), std::max(extent.height >> level, 1u), 1 };
+    }
+    vkCmdCopyBufferToImage(cmd_buf, src_buffer, dst, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mip_levels, regions.data());
+
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+void* TransferBatcher::stage(RenderingContext& ctx, VkDeviceSize size, VkBuffer& src_buffer, VkDeviceSize& src_offset) {
+    if (!is_recording_) {
+        beginBatch(ctx);
+    }
+
+    VkDeviceSize offset = 0;
+    bool is_allocated = allocateRing(size, offset);
+    if (!is_allocated && retire(ctx, false)) {
+        is_allocated = allocateRing(size, offset);
+    }
+
+    if (!is_allocated) {
+        // Ring is full (or too small), so stage it in a temporary buffer released with this batch
+        // rather than stalling on in-flight batches
+        StagingBuffer overflow = createStagingBuffer(ctx, size);
+        current_.overflows.push_back(overflow);
+        src_buffer = overflow.buffer;
+        src_offset = 0;
+        return overflow.allocation.mapped;
+    }
+
+    src_buffer = ring_.buffer;
+    src_offset = offset;
+    return static_cast<char*>(ring_.allocation.mapped) + offset;
+}
+
+VkCommandBuffer TransferBatcher::getCmdBuf(RenderingContext& ctx) {
+    if (!is_recording_) {
+        beginBatch(ctx);
+    }
+
+    return current_.cmd_buf;
+}
+
+void TransferBatcher::flush(RenderingContext& ctx) {
+    if (!is_recording_) {
+        return;
+    }
+
+    // Make uploads visible to every subsequent submission
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+    vkCmdPipelineBarrier(
+        current_.cmd_buf,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0,
+        1, &barrier,
+        0, nullptr,
+        0, nullptr
+    );
+    assert(vkEndCommandBuffer(current_.cmd_buf) == VK_SUCCESS);
+
+    VkSubmitInfo submit_info{};
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &current_.cmd_buf;
+    assert(vkQueueSubmit(ctx.graphics_queue, 1, &submit_info, current_.fence) == VK_SUCCESS);
+
+    in_flight_.push_back(current_);
+    current_ = Batch{};
+    is_recording_ = false;
+    ++submit_count_;
+}
+
+void TransferBatcher::wait(RenderingContext& ctx) {
+    while (retire(ctx, true)) {}
+}
+
+TransferBatcher::StagingBuffer TransferBatcher::createStagingBuffer(RenderingContext& ctx, VkDeviceSize size) {
+    StagingBuffer staging{};
+
+    VkBufferCreateInfo buf_info{};
+    buf_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buf_info.size = size;
+    buf_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    buf_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    assert(vkCreateBuffer(ctx.device, &buf_info, nullptr, &staging.buffer) == VK_SUCCESS);
+
+    VkMemoryRequirements mem_reqs{};
+    vkGetBufferMemoryRequirements(ctx.device, staging.buffer, &mem_reqs);
+    staging.allocation = ctx.allocator.allocate(
+        mem_reqs,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        true
+    );
+    assert(vkBindBufferMemory(ctx.device, staging.buffer, staging.allocation.memory, staging.allocation.offset) == VK_SUCCESS);
+
+    return staging;
+}
+
+void TransferBatcher::beginBatch(RenderingContext& ctx) {
+    if (free_batches_.empty()) {
+        Batch batch{};
+
+        VkCommandBufferAllocateInfo alloc_info{};
+        alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        alloc_info.commandPool = ctx.cmd_pool;
+        alloc_info.commandBufferCount = 1;
+        assert(vkAllocateCommandBuffers(ctx.device, &alloc_info, &batch.cmd_buf) == VK_SUCCESS);
+
+        VkFenceCreateInfo fence_info{};
+        fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        assert(vkCreateFence(ctx.device, &fence_info, nullptr, &batch.fence) == VK_SUCCESS);
+
+        free_batches_.push_back(batch);
+    }
+
+    current_ = free_batches_.back();
+    free_batches_.pop_back();
+    current_.uses_ring = false;
+    current_.ring_begin = 0;
+    current_.overflows.clear();
+
+    VkCommandBufferBeginInfo begin_info{};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    assert(vkBeginCommandBuffer(current_.cmd_buf, &begin_info) == VK_SUCCESS);
+
+    // Earlier submissions may still read resources overwritten by this batch
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(
+        current_.cmd_buf,
+        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0,
+        1, &barrier,
+        0, nullptr,
+        0, nullptr
+    );
+
+    is_recording_ = true;
+}
+
+bool TransferBatcher::allocateRing(VkDeviceSize size, VkDeviceSize& offset) {
+    if (size > capacity_) {
+        return false;
+    }
+
+    bool is_live = current_.uses_ring;
+    for (const auto& batch : in_flight_) {
+        is_live = is_live || batch.uses_ring;
+    }
+    if (!is_live) {
+        head_ = tail_ = 0;
+    }
+
+    // Live data is [tail_, head_) in circular order
+    const VkDeviceSize start = (head_ + kStagingAlignment - 1) & ~(kStagingAlignment - 1);
+    if (!is_live || head_ > tail_) {
+        if (start + size <= capacity_) {
+            offset = start;
+        }
+        else if (size <= tail_) {
+            offset = 0; // Wrap around
+        }
+        else {
+            return false;
+        }
+    }
+    else if (head_ < tail_ && start + size <= tail_) {
+        offset = start;
+    }
+    else {
+        return false;
+    }
+
+    head_ = offset + size;
+    if (!current_.uses_ring) {
+        current_.uses_ring = true;
+        current_.ring_begin = offset;
+    }
+    updateTail();
+
+    return true;
+}
+
+bool TransferBatcher::retire(RenderingContext& ctx, bool block) {
+    bool is_retired = false;
+    while (!in_flight_.empty()) {
+        Batch& batch = in_flight_.front();
+        if (block && !is_retired) {
+            assert(vkWaitForFences(ctx.device, 1, &batch.fence, VK_TRUE, UINT64_MAX) == VK_SUCCESS);
+        }
+        else if (vkGetFenceStatus(ctx.device, batch.fence) != VK_SUCCESS) {
+            break;
+        }
+
+        for (auto& overflow : batch.overflows) {
+            vkDestroyBuffer(ctx.device, overflow.buffer, nullptr);
+            ctx.allocator.free(overflow.allocation);
+        }
+        batch.overflows.clear();
+        assert(vkResetFences(ctx.device, 1, &batch.fence) == VK_SUCCESS);
+
+        free_batches_.push_back(batch);
+        in_flight_.pop_front();
+        is_retired = true;
+    }
+
+    updateTail();
+    return is_retired;
+}
+
+void TransferBatcher::updateTail() {
+    for (const auto& batch : in_flight_) {
+        if (batch.uses_ring) {
+            tail_ = batch.ring_begin;
+            return;
+        }
+    }
+    if (current_.uses_ring) {
+        tail_ = current_.ring_begin;
+    }
+}
@@ -0,0 +1,211 @@
+#include "kk_renderer/TransformStore.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <cstring>
+#include <cassert>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define KK_RENDERER_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+using namespace kk;
+using namespace kk::renderer;
+
+static size_t roundUp4(size_t n) {
+    return (n + 3) & ~static_cast<size_t>(3);
+}
+
+TransformStore::Handle TransformStore::add(const Transform& transform) {
+    Handle handle;
+    if (!free_handles_.empty()) {
+        handle = free_handles_.back();
+        free_handles_.pop_back();
+    }
+    else {
+        handle = static_cast<Handle>(count_);
+        resize(count_ + 1);
+    }
+
+    set(handle, transform);
+    return handle;
+}
+
+void TransformStore::remove(Handle handle) {
+    // Reset to identity, so that the slot never produces invalid values
+    set(handle, Transform{});
+    free_handles_.push_back(handle);
+}
+
+void TransformStore::set(Handle handle, const Transform& transform) {
+    assert(handle < count_);
+    px_[handle] = transform.position.x;
+    py_[handle] = transform.position.y;
+    pz_[handle] = transform.position.z;
+    qx_[handle] = transform.rotation.x;
+    qy_[handle] = transform.rotation.y;
+    qz_[handle] = transform.rotation.z;
+    qw_[handle] = transform.rotation.w;
+    sx_[handle] = transform.scale.x;
+    sy_[handle] = transform.scale.y;
+    sz_[handle] = transform.scale.z;
+    dirty_[handle] = 1;
+}
+
+Transform TransformStore::get(Handle handle) const {
+    assert(handle < count_);
+    Transform transform;
+    transform.position = Vec3(px_[handle], py_[handle], pz_[handle]);
+    transform.rotation = Quat(qw_[handle], qx_[handle], qy_[handle], qz_[handle]);
+    transform.scale = Vec3(sx_[handle], sy_[handle], sz_[handle]);
+
+    return transform;
+}
+
+void TransformStore::update(const Mat4& view_proj) {
+    const bool is_vp_changed = std::memcmp(&view_proj, &view_proj_, sizeof(Mat4)) != 0;
+    view_proj_ = view_proj;
+
+    // Process every 4 transforms, skipping blocks without modification
+    const size_t padded = roundUp4(count_);
+    for (size_t i = 0; i < padded; i += 4) {
+        uint32_t block_dirty;
+        std::memcpy(&block_dirty, &dirty_[i], sizeof(uint32_t));
+        if (block_dirty != 0) {
+            updateModels(i, 4);
+            std::memset(&dirty_[i], 0, 4);
+        }
+        if (block_dirty != 0 || is_vp_changed) {
+            updateMvps(view_proj, i, 4);
+        }
+    }
+}
+
+Mat4 TransformStore::computeModel(const Transform& transform) {
+    return
+        glm::scale(glm::mat4(1.0f), transform.scale) *
+        glm::mat4_cast(transform.rotation) *
+        glm::translate(glm::mat4(1.0f), transform.position)
+        ;
+}
+
+void TransformStore::resize(size_t count) {
+    const size_t padded = roundUp4(count);
+    px_.resize(padded, 0.0f);
+    py_.resize(padded, 0.0f);
+    pz_.resize(padded, 0.0f);
+    qx_.resize(padded, 0.0f);
+    qy_.resize(padded, 0.0f);
+    qz_.resize(padded, 0.0f);
+    qw_.resize(padded, 1.0f);
+    sx_.resize(padded, 1.0f);
+    sy_.resize(padded, 1.0f);
+    sz_.resize(padded, 1.0f);
+    dirty_.resize(padded, 1);
+    models_.resize(padded, Mat4(1.0f));
+    mvps_.resize(padded, Mat4(1.0f));
+    count_ = count;
+}
+
+// Model = S * R * T, equivalent to computeModel():
+//   M[c][r] = s_r * R[c][r] (c < 3)
+//   M[3][r] = s_r * (R[0][r] * px + R[1][r] * py + R[2][r] * pz)
+#ifdef KK_RENDERER_USE_SSE
+void TransformStore::updateModels(size_t first, size_t count) {
+    assert(first % 4 == 0 && count % 4 == 0);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+    const __m128 zero = _mm_setzero_ps();
+
+    for (size_t i = first; i < first + count; i += 4) {
+        // Each register holds one component of 4 transforms
+        const __m128 x = _mm_loadu_ps(&qx_[i]), y = _mm_loadu_ps(&qy_[i]), z = _mm_loadu_ps(&qz_[i]), w = _mm_loadu_ps(&qw_[i]);
+        const __m128 sx = _mm_loadu_ps(&sx_[i]), sy = _mm_loadu_ps(&sy_[i]), sz = _mm_loadu_ps(&sz_[i]);
+        const __m128 px = _mm_loadu_ps(&px_[i]), py = _mm_loadu_ps(&py_[i]), pz = _mm_loadu_ps(&pz_[i]);
+
+        const __m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+        const __m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+        const __m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+
+        // Rotation (column major, as glm::mat4_cast)
+        const __m128 r00 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz)));
+        const __m128 r01 = _mm_mul_ps(two, _mm_add_ps(xy, wz));
+        const __m128 r02 = _mm_mul_ps(two, _mm_sub_ps(xz, wy));
+        const __m128 r10 = _mm_mul_ps(two, _mm_sub_ps(xy, wz));
+        const __m128 r11 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz)));
+        const __m128 r12 = _mm_mul_ps(two, _mm_add_ps(yz, wx));
+        const __m128 r20 = _mm_mul_ps(two, _mm_add_ps(xz, wy));
+        const __m128 r21 = _mm_mul_ps(two, _mm_sub_ps(yz, wx));
+        const __m128 r22 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy)));
+
+        __m128 c0[4] = { _mm_mul_ps(sx, r00), _mm_mul_ps(sy, r01), _mm_mul_ps(sz, r02), zero };
+        __m128 c1[4] = { _mm_mul_ps(sx, r10), _mm_mul_ps(sy, r11), _mm_mul_ps(sz, r12), zero };
+        __m128 c2[4] = { _mm_mul_ps(sx, r20), _mm_mul_ps(sy, r21), _mm_mul_ps(sz, r22), zero };
+        __m128 c3[4] = {
+            _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0[0], px), _mm_mul_ps(c1[0], py)), _mm_mul_ps(c2[0], pz)),
+            _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0[1], px), _mm_mul_ps(c1[1], py)), _mm_mul_ps(c2[1], pz)),
+            _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0[2], px), _mm_mul_ps(c1[2], py)), _mm_mul_ps(c2[2], pz)),
+            one
+        };
+
+        // Transpose to get the column of each transform
+        _MM_TRANSPOSE4_PS(c0[0], c0[1], c0[2], c0[3]);
+        _MM_TRANSPOSE4_PS(c1[0], c1[1], c1[2], c1[3]);
+        _MM_TRANSPOSE4_PS(c2[0], c2[1], c2[2], c2[3]);
+        _MM_TRANSPOSE4_PS(c3[0], c3[1], c3[2], c3[3]);
+        for (size_t j = 0; j < 4; ++j) {
+            float* m = &models_[i + j][0][0];
+            _mm_storeu_ps(m + 0, c0[j]);
+            _mm_storeu_ps(m + 4, c1[j]);
+            _mm_storeu_ps(m + 8, c2[j]);
+            _mm_storeu_ps(m + 12, c3[j]);
+        }
+    }
+}
+
+void TransformStore::updateMvps(const Mat4& view_proj, size_t first, size_t count) {
+    const __m128 vp0 = _mm_loadu_ps(&view_proj[0][0]);
+    const __m128 vp1 = _mm_loadu_ps(&view_proj[1][0]);
+    const __m128 vp2 = _mm_loadu_ps(&view_proj[2][0]);
+    const __m128 vp3 = _mm_loadu_ps(&view_proj[3][0]);
+
+    for (size_t i = first; i < first + count; ++i) {
+        const float* m = &models_[i][0][0];
+        float* out = &mvps_[i][0][0];
+        for (size_t c = 0; c < 4; ++c) {
+            const __m128 col = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(vp0, _mm_set1_ps(m[c * 4 + 0])), _mm_mul_ps(vp1, _mm_set1_ps(m[c * 4 + 1]))),
+                _mm_add_ps(_mm_mul_ps(vp2, _mm_set1_ps(m[c * 4 + 2])), _mm_mul_ps(vp3, _mm_set1_ps(m[c * 4 + 3])))
+            );
+            _mm_storeu_ps(out + c * 4, col);
+        }
+    }
+}
+#else
+void TransformStore::updateModels(size_t first, size_t count) {
+    for (size_t i = first; i < first + count; ++i) {
+        const float x = qx_[i], y = qy_[i], z = qz_[i], w = qw_[i];
+        const float r[3][3] = {
+            { 1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + w * z), 2.0f * (x * z - w * y) },
+            { 2.0f * (x * y - w * z), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + w * x) },
+            { 2.0f * (x * z + w * y), 2.0f * (y * z - w * x), 1.0f - 2.0f * (x * x + y * y) }
+        };
+        const float s[3] = { sx_[i], sy_[i], sz_[i] };
+
+        Mat4& m = models_[i];
+        for (int row = 0; row < 3; ++row) {
+            for (int col = 0; col < 3; ++col) {
+                m[col][row] = s[row] * r[col][row];
+            }
+            m[3][row] = m[0][row] * px_[i] + m[1][row] * py_[i] + m[2][row] * pz_[i];
+        }
+        m[0][3] = m[1][3] = m[2][3] = 0.0f;
+        m[3][3] = 1.0f;
+    }
+}
+
+void TransformStore::updateMvps(const Mat4& view_proj, size_t first, size_t count) {
+    for (size_t i = first; i < first + count; ++i) {
+        mvps_[i] = view_proj * models_[i];
+    }
+}
+#endif
@@ -0,0 +1,58 @@
+#include "kk_renderer/UniformAllocator.h"
+#include <algorithm>
+
+using namespace kk::renderer;
+
+static Buffer createBlock(RenderingContext& ctx, VkDeviceSize size);
+
+UniformAllocator UniformAllocator::create(RenderingContext& ctx, VkDeviceSize block_size) {
+    VkPhysicalDeviceProperties props{};
+    vkGetPhysicalDeviceProperties(ctx.gpu, &props);
+
+    UniformAllocator allocator{};
+    allocator.alignment = props.limits.minUniformBufferOffsetAlignment;
+    if (allocator.alignment == 0) {
+        allocator.alignment = 1;
+    }
+    allocator.block_size = block_size;
+    allocator.current = 0;
+    allocator.head = 0;
+    allocator.blocks.push_back(createBlock(ctx, block_size));
+
+    return allocator;
+}
+
+void UniformAllocator::destroy(RenderingContext& ctx) {
+    for (auto& block : blocks) {
+        block.destroy(ctx);
+    }
+    blocks.clear();
+}
+
+void* UniformAllocator::allocate(RenderingContext& ctx, VkDeviceSize size, uint32_t& block, uint32_t& offset) {
+    // NOTE: minUniformBufferOffsetAlignment is guaranteed to be power of 2
+    VkDeviceSize aligned_head = (head + alignment - 1) & ~(alignment - 1);
+    while (aligned_head + size > blocks[current].size) {
+        // Blocks too small for the slice are left unused for this frame
+        ++current;
+        aligned_head = 0;
+        if (current == blocks.size()) {
+            blocks.push_back(createBlock(ctx, std::max(block_size, size)));
+        }
+    }
+
+    block = static_cast<uint32_t>(current);
+    offset = static_cast<uint32_t>(aligned_head);
+    head = aligned_head + size;
+
+    return static_cast<char*>(blocks[current].mapped) + aligned_head;
+}
+
+static Buffer createBlock(RenderingContext& ctx, VkDeviceSize size) {
+    return Buffer::create(
+        ctx,
+        size,
+        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, // Also serves per-instance vertex input
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+    );
+}
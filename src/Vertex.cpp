@@ -1,4 +1,7 @@
 #include "kk_renderer/Vertex.h"
+#include <glm/gtc/packing.hpp>
+#include <algorithm>
+#include <cmath>
 
 using namespace kk::renderer;
 
@@ -39,3 +42,90 @@ bool kk::renderer::operator==(const Vertex& lhs, const Vertex& rhs) {
         lhs.color == rhs.color
     );
 }
+
+static uint16_t quantizeUnorm16(float value) {
+    return static_cast<uint16_t>(std::lround(std::min(std::max(value, 0.0f), 1.0f) * 65535.0f));
+}
+
+PackedVertex PackedVertex::pack(const Vertex& vertex, const Vec3& min, const Vec3& extent) {
+    PackedVertex packed{};
+    for (int i = 0; i < 3; ++i) {
+        // NOTE: Flat axis (zero extent) is always 0
+        packed.position[i] = extent[i] > 0.0f ? quantizeUnorm16((vertex.position[i] - min[i]) / extent[i]) : 0;
+    }
+    const uint32_t uv = glm::packHalf2x16(vertex.uv);
+    packed.uv[0] = static_cast<uint16_t>(uv & 0xFFFF);
+    packed.uv[1] = static_cast<uint16_t>(uv >> 16);
+
+    return packed;
+}
+
+uint32_t PackedVertex::packColor(const Vec4& color) {
+    return glm::packUnorm4x8(color);
+}
+
+void kk::renderer::getVertexInputDescriptions(
+    VertexFormat format,
+    std::vector<VkVertexInputBindingDescription>& bindings,
+    std::vector<VkVertexInputAttributeDescription>& attributes
+) {
+    if (format == VertexFormat::kFloat) {
+        bindings.push_back(Vertex::getBindingDescription());
+        for (const auto& attr : Vertex::getAttributeDescriptions()) {
+            attributes.push_back(attr);
+        }
+        return;
+    }
+
+    VkVertexInputBindingDescription binding_desc{};
+    binding_desc.binding = 0;
+    binding_desc.stride = sizeof(PackedVertex);
+    binding_desc.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    bindings.push_back(binding_desc);
+
+    // NOTE: Stride 0 makes every vertex read the same color
+    binding_desc.binding = PackedVertex::kColorBinding;
+    binding_desc.stride = format == VertexFormat::kPackedConstantColor ? 0 : sizeof(uint32_t);
+    bindings.push_back(binding_desc);
+
+    VkVertexInputAttributeDescription attr_desc{};
+    attr_desc.binding = 0;
+    attr_desc.location = 0;
+    attr_desc.format = VK_FORMAT_R16G16B16A16_UNORM;
+    attr_desc.offset = offsetof(PackedVertex, position);
+    attributes.push_back(attr_desc);
+
+    attr_desc.location = 1;
+    attr_desc.format = VK_FORMAT_R16G16_SFLOAT;
+    attr_desc.offset = offsetof(PackedVertex, uv);
+    attributes.push_back(attr_desc);
+
+    attr_desc.binding = PackedVertex::kColorBinding;
+    attr_desc.location = 2;
+    attr_desc.format = VK_FORMAT_R8G8B8A8_UNORM;
+    attr_desc.offset = 0;
+    attributes.push_back(attr_desc);
+}
+
+VkVertexInputBindingDescription InstanceData::getBindingDescription() {
+    VkVertexInputBindingDescription binding_desc{};
+    binding_desc.binding = 1;
+    binding_desc.stride = sizeof(InstanceData);
+    binding_desc.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+    return binding_desc;
+}
+
+std::array<VkVertexInputAttributeDescription, 4> InstanceData::getAttributeDescriptions() {
+    std::array<VkVertexInputAttributeDescription, 4> attr_descs{};
+
+    // NOTE: mat4 input occupies 4 locations, one per column
+    for (uint32_t i = 0; i < attr_descs.size(); ++i) {
+        attr_descs[i].binding = 1;
+        attr_descs[i].location = 3 + i;
+        attr_descs[i].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+        attr_descs[i].offset = offsetof(InstanceData, mvp) + sizeof(Vec4) * i;
+    }
+
+    return attr_descs;
+}
@@ -0,0 +1,87 @@
+#include "kk_renderer/VertexWeldTable.h"
+#include <cstring>
+
+using namespace kk::renderer;
+
+static constexpr uint32_t kEmpty = UINT32_MAX;
+
+// Rehashes before more than half of the slots are used, keeping probe sequences short
+static size_t slotCountFor(size_t count) {
+    size_t slot_count = 16;
+    while (slot_count < count * 2) {
+        slot_count *= 2;
+    }
+    return slot_count;
+}
+
+static inline uint64_t mix(uint64_t h, uint64_t word) {
+    h ^= word;
+    h *= 0x9E3779B97F4A7C15ull;
+    return h ^ (h >> 32);
+}
+
+VertexWeldTable::VertexWeldTable(size_t expected_count) : count_(0) {
+    slots_.assign(slotCountFor(expected_count), Slot{ 0, kEmpty });
+    mask_ = slots_.size() - 1;
+}
+
+uint32_t VertexWeldTable::weld(const Vertex& vertex, std::vector<Vertex>& vertices) {
+    const uint32_t tag = static_cast<uint32_t>(hash(vertex));
+
+    // Linear probing. Full comparison only on tag match.
+    size_t pos = tag & mask_;
+    while (slots_[pos].index != kEmpty) {
+        const Slot& slot = slots_[pos];
+        if (slot.tag == tag && std::memcmp(&vertices[slot.index], &vertex, sizeof(Vertex)) == 0) {
+            return slot.index;
+        }
+        pos = (pos + 1) & mask_;
+    }
+
+    const uint32_t index = static_cast<uint32_t>(vertices.size());
+    vertices.push_back(vertex);
+    slots_[pos] = Slot{ tag, index };
+    if (++count_ * 2 > slots_.size()) {
+        grow();
+    }
+
+    return index;
+}
+
+uint64_t VertexWeldTable::hash(const Vertex& vertex) {
+    static_assert(sizeof(Vertex) == 36, "Vertex must have no padding to be hashed by bytes");
+    uint64_t words[5] = {};
+    std::memcpy(words, &vertex, sizeof(Vertex));
+
+    uint64_t h = 0xCBF29CE484222325ull;
+    for (uint64_t word : words) {
+        h = mix(h, word);
+    }
+
+    // Final avalanche (MurmurHash3 fmix64), so that low bits depend on every input bit
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ull;
+    h ^= h >> 33;
+
+    return h;
+}
+
+void VertexWeldTable::grow() {
+    std::vector<Slot> old_slots(slots_.size() * 2, Slot{ 0, kEmpty });
+    old_slots.swap(slots_);
+    mask_ = slots_.size() - 1;
+
+    // Tags are kept, so vertices are not hashed again
+    for (const Slot& slot : old_slots) {
+        if (slot.index == kEmpty) {
+            continue;
+        }
+        size_t pos = slot.tag & mask_;
+        while (slots_[pos].index != kEmpty) {
+            pos = (pos + 1) & mask_;
+        }
+        slots_[pos] = slot;
+    }
+}
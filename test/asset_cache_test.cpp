@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+#include "kk_renderer/kk_renderer.h"
+#include "kk_renderer/AssetCache.h"
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#ifndef TEST_RESOURCE_DIR
+#define TEST_RESOURCE_DIR "./resources"
+#endif
+
+using namespace kk;
+using namespace kk::renderer;
+
+static const std::string kTriangleVert = TEST_RESOURCE_DIR + std::string("/shaders/triangle.vert.spv");
+static const std::string kTriangleFrag = TEST_RESOURCE_DIR + std::string("/shaders/triangle.frag.spv");
+static const std::string kTextureVert = TEST_RESOURCE_DIR + std::string("/shaders/texture.vert.spv");
+
+TEST(AssetCacheTest, SharedByPathAndContent) {
+    RenderingContext ctx = RenderingContext::createHeadless();
+    AssetCache cache;
+
+    std::shared_ptr<Texture> texture = cache.getTexture(ctx, TEST_RESOURCE_DIR + std::string("/textures/viking_room.png"));
+    std::shared_ptr<Texture> same = cache.getTexture(ctx, TEST_RESOURCE_DIR + std::string("/textures/viking_room.png"));
+    EXPECT_EQ(texture, same);
+    EXPECT_EQ(cache.getStats().miss_count, 1u);
+    EXPECT_EQ(cache.getStats().hit_count, 1u);
+    EXPECT_EQ(cache.getStats().memory_used, texture->allocation.size);
+
+    // A copy at another path is the same content
+    const std::string copy_path = "asset_cache_test_copy.spv";
+    {
+        std::ifstream src(kTriangleVert, std::ios::binary);
+        std::ofstream dst(copy_path, std::ios::binary);
+        dst << src.rdbuf();
+    }
+    std::shared_ptr<Shader> shader = cache.getShader(ctx, kTriangleVert);
+    EXPECT_EQ(cache.getShader(ctx, copy_path), shader);
+    EXPECT_NE(cache.getShader(ctx, kTriangleFrag), shader);
+    EXPECT_EQ(cache.getStats().miss_count, 3u);
+    EXPECT_EQ(cache.getStats().hit_count, 2u);
+    EXPECT_EQ(cache.getStats().entry_count, 3u);
+    std::remove(copy_path.c_str());
+
+    // Flags create another asset from the same file
+    std::shared_ptr<Texture> no_mips = cache.getTexture(ctx, TEST_RESOURCE_DIR + std::string("/textures/viking_room.png"), kTextureNoMipmaps);
+    EXPECT_NE(no_mips, texture);
+    EXPECT_EQ(no_mips->mip_levels, 1u);
+
+    EXPECT_THROW(cache.getShader(ctx, TEST_RESOURCE_DIR + std::string("/shaders/missing.spv")), std::runtime_error);
+
+    cache.destroy(ctx);
+    ctx.destroy();
+}
+
+TEST(AssetCacheTest, EvictsUnreferencedInLruOrder) {
+    RenderingContext ctx = RenderingContext::createHeadless();
+    AssetCache cache(0);
+
+    // Referenced assets are kept over budget
+    std::shared_ptr<Shader> vert = cache.getShader(ctx, kTriangleVert);
+    std::shared_ptr<Shader> frag = cache.getShader(ctx, kTriangleFrag);
+    EXPECT_EQ(cache.getStats().entry_count, 2u);
+    EXPECT_EQ(cache.getStats().eviction_count, 0u);
+
+    // Unreferenced ones are evicted, least recently used first
+    const VkDeviceSize budget = cache.getStats().memory_used - Shader::loadCode(kTriangleFrag).size() + Shader::loadCode(kTextureVert).size();
+    cache.setBudget(budget);
+    vert.reset();
+    frag.reset();
+    cache.getShader(ctx, kTriangleVert);
+    cache.getShader(ctx, kTextureVert);
+    EXPECT_EQ(cache.getStats().eviction_count, 1u);
+    EXPECT_EQ(cache.getStats().entry_count, 2u);
+    EXPECT_EQ(cache.getStats().hit_count, 1u);
+    EXPECT_EQ(cache.getStats().memory_used, budget);
+
+    cache.getShader(ctx, kTriangleVert);
+    EXPECT_EQ(cache.getStats().hit_count, 2u);
+    cache.getShader(ctx, kTriangleFrag);
+    EXPECT_EQ(cache.getStats().miss_count, 4u);
+
+    cache.setBudget(0);
+    cache.trim(ctx);
+    EXPECT_EQ(cache.getStats().entry_count, 0u);
+    EXPECT_EQ(cache.getStats().memory_used, 0u);
+
+    cache.destroy(ctx);
+    ctx.destroy();
+}
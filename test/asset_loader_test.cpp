@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+#include "kk_renderer/kk_renderer.h"
+#include "kk_renderer/AssetLoader.h"
+#include <memory>
+#include <stdexcept>
+#ifndef TEST_RESOURCE_DIR
+#define TEST_RESOURCE_DIR "./resources"
+#endif
+
+using namespace kk;
+using namespace kk::renderer;
+
+TEST(AssetLoaderTest, PendingAssetsAreSkipped) {
+    RenderingContext ctx = RenderingContext::createHeadless();
+    Renderer renderer = Renderer::createOffscreen(ctx, 64, 64);
+    AssetLoader loader(2);
+
+    AssetHandle<Geometry> geometry = loader.loadGeometryAsync(TEST_RESOURCE_DIR + std::string("/models/viking_room.obj"), kGeometryOptimize);
+    AssetHandle<Texture> texture = loader.loadTextureAsync(TEST_RESOURCE_DIR + std::string("/textures/viking_room.png"));
+    AssetHandle<Shader> vert = loader.loadShaderAsync(TEST_RESOURCE_DIR + std::string("/shaders/texture.vert.spv"));
+    AssetHandle<Shader> frag = loader.loadShaderAsync(TEST_RESOURCE_DIR + std::string("/shaders/texture.frag.spv"));
+    EXPECT_EQ(loader.getPendingCount(), 4u);
+    EXPECT_FALSE(geometry.isReady());
+
+    // Placeholders can be bound before they are loaded
+    auto material = std::make_shared<Material>();
+    material->setTexture(texture.asset);
+    material->setVertexShader(vert.asset);
+    material->setFragmentShader(frag.asset);
+    EXPECT_FALSE(material->isReady());
+    renderer.compileMaterial(ctx, material);
+    EXPECT_FALSE(material->isCompiled());
+    Renderable renderable{ geometry.asset, material };
+    PerspectiveCamera camera(45.0f, 1.0f, 0.1f, 1000.0f);
+    camera.transform.position.z = -3.0f;
+
+    ASSERT_TRUE(renderer.beginFrame(ctx));
+    renderer.render(ctx, renderable, Transform{}, camera);
+    renderer.endFrame(ctx);
+    EXPECT_EQ(renderer.getFrameStats().pending_count, 1u);
+    EXPECT_EQ(renderer.getFrameStats().draw_count, 0u);
+
+    // Frames keep going while assets are created as their data arrive
+    size_t finished_count = 0;
+    while (finished_count < 4) {
+        ASSERT_TRUE(renderer.beginFrame(ctx));
+        finished_count += loader.update(ctx);
+        renderer.render(ctx, renderable, Transform{}, camera);
+        renderer.endFrame(ctx);
+    }
+    EXPECT_EQ(loader.getPendingCount(), 0u);
+    EXPECT_NO_THROW(geometry.loaded.get());
+    EXPECT_TRUE(geometry.isReady());
+    EXPECT_TRUE(material->isReady());
+    EXPECT_GT(geometry.asset->index_count, 0u);
+
+    ASSERT_TRUE(renderer.beginFrame(ctx));
+    renderer.render(ctx, renderable, Transform{}, camera);
+    renderer.endFrame(ctx);
+    EXPECT_EQ(renderer.getFrameStats().pending_count, 0u);
+    EXPECT_EQ(renderer.getFrameStats().draw_count, 1u);
+
+    vkDeviceWaitIdle(ctx.device);
+    material->destroy(ctx);
+    vert.asset->destroy(ctx);
+    frag.asset->destroy(ctx);
+    texture.asset->destroy(ctx);
+    geometry.asset->destroy(ctx);
+    renderer.destroy(ctx);
+    ctx.destroy();
+}
+
+TEST(AssetLoaderTest, FailedLoad) {
+    RenderingContext ctx = RenderingContext::createHeadless();
+    AssetLoader loader(1);
+
+    AssetHandle<Texture> texture = loader.loadTextureAsync(TEST_RESOURCE_DIR + std::string("/textures/missing.png"));
+    loader.wait(ctx);
+    EXPECT_EQ(loader.getPendingCount(), 0u);
+    EXPECT_THROW(texture.loaded.get(), std::runtime_error);
+    EXPECT_FALSE(texture.isReady());
+
+    ctx.destroy();
+}
@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 #include "kk_renderer/kk_renderer.h"
+#include "kk_renderer/ObjLoader.h"
+#include <cstdio>
 #ifndef TEST_RESOURCE_DIR
 #define TEST_RESOURCE_DIR "./resources"
 #endif
@@ -15,6 +17,158 @@ TEST(DrawModelTest, ModelCreation) {
     ctx.destroy();
 }
 
+TEST(DrawModelTest, ModelCacheCreation) {
+    RenderingContext ctx = RenderingContext::createHeadless();
+    const std::string path = TEST_RESOURCE_DIR + std::string("/models/viking_room.obj");
+    const std::string cache_path = "viking_room_test.kkmesh";
+    std::remove(cache_path.c_str());
+
+    // First load parses OBJ and writes cache, second one loads cache
+    Geometry expected = Geometry::create(ctx, path);
+    Geometry written = Geometry::create(ctx, path, cache_path);
+    Geometry cached = Geometry::create(ctx, path, cache_path);
+    EXPECT_EQ(cached.vertices, expected.vertices);
+    EXPECT_EQ(cached.indices, expected.indices);
+    EXPECT_EQ(cached.bounds.center, expected.bounds.center);
+    EXPECT_EQ(cached.bounds.radius, expected.bounds.radius);
+
+    // LODs and meshlets are cached with the indices
+    const std::string lod_cache_path = "viking_room_lod_test.kkmesh";
+    std::remove(lod_cache_path.c_str());
+    Geometry lod_written = Geometry::create(ctx, path, lod_cache_path, kGeometryGenerateLods | kGeometryBuildMeshlets);
+    Geometry lod_cached = Geometry::create(ctx, path, lod_cache_path, kGeometryGenerateLods | kGeometryBuildMeshlets);
+    ASSERT_EQ(lod_cached.lods.size(), lod_written.lods.size());
+    EXPECT_GT(lod_cached.lods.size(), 1u);
+    EXPECT_EQ(lod_cached.lods.back().index_count, lod_written.lods.back().index_count);
+    EXPECT_EQ(lod_cached.indices, lod_written.indices);
+    ASSERT_EQ(lod_cached.meshlets.size(), lod_written.meshlets.size());
+    EXPECT_GT(lod_cached.meshlets.size(), 1u);
+    EXPECT_EQ(lod_cached.meshlets.back().first_index, lod_written.meshlets.back().first_index);
+    EXPECT_EQ(lod_cached.meshlet_bounds.size(), lod_cached.meshlets.size());
+    lod_cached.destroy(ctx);
+    lod_written.destroy(ctx);
+    std::remove(lod_cache_path.c_str());
+
+    // Corrupted cache falls back to OBJ
+    {
+        std::FILE* file = std::fopen(cache_path.c_str(), "r+b");
+        ASSERT_NE(file, nullptr);
+        std::fputc('X', file);
+        std::fclose(file);
+    }
+    Geometry fallback = Geometry::create(ctx, path, cache_path);
+    EXPECT_EQ(fallback.indices, expected.indices);
+    std::remove(cache_path.c_str());
+
+    // Cache with indices out of its vertices falls back to OBJ
+    {
+        Geometry broken{};
+        broken.vertices = std::vector<Vertex>(3);
+        broken.indices = { 0, 1, 3 };
+        broken.vertex_count = 3;
+        broken.index_count = 3;
+        ASSERT_TRUE(broken.writeCache(cache_path, path));
+    }
+    Geometry out_of_range = Geometry::create(ctx, path, cache_path);
+    EXPECT_EQ(out_of_range.indices, expected.indices);
+    std::remove(cache_path.c_str());
+    out_of_range.destroy(ctx);
+
+    fallback.destroy(ctx);
+    cached.destroy(ctx);
+    written.destroy(ctx);
+    expected.destroy(ctx);
+    ctx.destroy();
+}
+
+TEST(DrawModelTest, PackedModelCreation) {
+    RenderingContext ctx = RenderingContext::createHeadless();
+    const std::string path = TEST_RESOURCE_DIR + std::string("/models/viking_room.obj");
+    Geometry full = Geometry::create(ctx, path);
+    Geometry packed = Geometry::create(ctx, path, kGeometryPackVertices);
+
+    // Loader sets every color to white, so the color stream collapses to one element
+    EXPECT_EQ(full.vertex_format, VertexFormat::kFloat);
+    EXPECT_EQ(packed.vertex_format, VertexFormat::kPackedConstantColor);
+    EXPECT_LT(packed.vertex_buffer.size * 2, full.vertex_buffer.size);
+    EXPECT_EQ(packed.vertices, full.vertices);
+
+    // Dequantized positions are within one step of 16 bit quantization
+    const Vec3 extent = packed.bounds.max - packed.bounds.min;
+    for (const auto& vertex : packed.vertices) {
+        const PackedVertex p = PackedVertex::pack(vertex, packed.bounds.min, extent);
+        const Vec4 position = packed.dequantize * Vec4(p.position[0] / 65535.0f, p.position[1] / 65535.0f, p.position[2] / 65535.0f, 1.0f);
+        EXPECT_NEAR(position.x, vertex.position.x, extent.x / 65535.0f);
+        EXPECT_NEAR(position.y, vertex.position.y, extent.y / 65535.0f);
+        EXPECT_NEAR(position.z, vertex.position.z, extent.z / 65535.0f);
+    }
+
+    packed.destroy(ctx);
+    full.destroy(ctx);
+    ctx.destroy();
+}
+
+TEST(DrawModelTest, DropCpuData) {
+    RenderingContext ctx = RenderingContext::createHeadless();
+    const std::string path = TEST_RESOURCE_DIR + std::string("/models/viking_room.obj");
+    Geometry full = Geometry::create(ctx, path, kGeometryBuildMeshlets);
+    Geometry dropped = Geometry::create(ctx, path, kGeometryBuildMeshlets | kGeometryDropCpuData);
+
+    // Only vertex and index arrays are freed. What drawing and culling read is kept.
+    EXPECT_TRUE(dropped.vertices.empty());
+    EXPECT_TRUE(dropped.indices.empty());
+    EXPECT_EQ(dropped.vertex_count, full.vertices.size());
+    EXPECT_EQ(dropped.index_count, full.indices.size());
+    EXPECT_EQ(dropped.bounds.center, full.bounds.center);
+    EXPECT_EQ(dropped.bounds.radius, full.bounds.radius);
+    EXPECT_EQ(dropped.lods.size(), full.lods.size());
+    EXPECT_EQ(dropped.meshlets.size(), full.meshlets.size());
+    EXPECT_EQ(dropped.meshlet_bounds.size(), full.meshlets.size());
+    EXPECT_FALSE(dropped.writeCache("viking_room_dropped_test.kkmesh", path));
+
+    // Cache is written before CPU data is dropped, and then serves both
+    const std::string cache_path = "viking_room_drop_test.kkmesh";
+    std::remove(cache_path.c_str());
+    Geometry written = Geometry::create(ctx, path, cache_path, kGeometryBuildMeshlets | kGeometryDropCpuData);
+    Geometry cached = Geometry::create(ctx, path, cache_path, kGeometryBuildMeshlets);
+    EXPECT_TRUE(written.indices.empty());
+    EXPECT_EQ(cached.indices, full.indices);
+    std::remove(cache_path.c_str());
+
+    cached.destroy(ctx);
+    written.destroy(ctx);
+    dropped.destroy(ctx);
+    full.destroy(ctx);
+    ctx.destroy();
+}
+
+TEST(DrawModelTest, MoveCreation) {
+    RenderingContext ctx = RenderingContext::createHeadless();
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    loadObj(TEST_RESOURCE_DIR + std::string("/models/viking_room.obj"), vertices, indices);
+    Geometry copied = Geometry::create(ctx, vertices, indices);
+    Geometry optimized_copied = Geometry::create(ctx, vertices, indices, kGeometryOptimize);
+    Geometry optimized_moved = Geometry::create(ctx, std::vector<Vertex>(vertices), std::vector<uint32_t>(indices), kGeometryOptimize);
+    EXPECT_EQ(optimized_moved.vertices, optimized_copied.vertices);
+    EXPECT_EQ(optimized_moved.indices, optimized_copied.indices);
+
+    // Vectors are taken over, not copied
+    const Vertex* vertex_data = vertices.data();
+    const uint32_t* index_data = indices.data();
+    Geometry moved = Geometry::create(ctx, std::move(vertices), std::move(indices));
+    EXPECT_EQ(moved.vertices.data(), vertex_data);
+    EXPECT_EQ(moved.indices.data(), index_data);
+    EXPECT_EQ(moved.vertices, copied.vertices);
+    EXPECT_EQ(moved.index_count, copied.index_count);
+
+    moved.destroy(ctx);
+    optimized_moved.destroy(ctx);
+    optimized_copied.destroy(ctx);
+    copied.destroy(ctx);
+    ctx.destroy();
+}
+
 TEST(DrawModelTest, ModelDrawing) {
     const std::pair<size_t, size_t> size = { 800, 800 };
     const std::string name = "draw model test";
@@ -59,3 +213,115 @@ TEST(DrawModelTest, ModelDrawing) {
     ctx.destroy();
     window.destroy();
 }
+
+TEST(DrawModelTest, InstancedDrawing) {
+    const size_t grid = 32;
+    const std::pair<size_t, size_t> size = { 800, 800 };
+    const std::string name = "instanced drawing test";
+    Window window = Window::create(size.first, size.second, name);
+
+    RenderingContext ctx = RenderingContext::create();
+    Swapchain swapchain = Swapchain::create(ctx, window);
+
+    auto sphere = std::make_shared<Geometry>(Geometry::create(ctx, TEST_RESOURCE_DIR + std::string("/models/sphere.obj")));
+    auto vert = std::make_shared<Shader>(Shader::create(ctx, TEST_RESOURCE_DIR + std::string("/shaders/texture.vert.spv")));
+    auto vert_instanced = std::make_shared<Shader>(Shader::create(ctx, TEST_RESOURCE_DIR + std::string("/shaders/texture_instanced.vert.spv")));
+    auto frag = std::make_shared<Shader>(Shader::create(ctx, TEST_RESOURCE_DIR + std::string("/shaders/texture.frag.spv")));
+    auto texture = std::make_shared<Texture>(Texture::create(ctx, TEST_RESOURCE_DIR + std::string("/textures/statue.jpg")));
+    auto material = std::make_shared<Material>();
+    material->setVertexShader(vert);
+    material->setInstancedVertexShader(vert_instanced);
+    material->setFragmentShader(frag);
+    material->setTexture(texture);
+
+    Renderable renderable{ sphere, material };
+    std::vector<Transform> transforms(grid * grid);
+    for (size_t i = 0; i < transforms.size(); ++i) {
+        transforms[i].position = Vec3((i % grid) - grid / 2.0f, (i / grid) - grid / 2.0f, 0.0f) * 2.5f;
+        transforms[i].scale = Vec3(0.05f, 0.05f, 0.05f);
+    }
+    PerspectiveCamera camera(45.0f, swapchain.extent.width / (float)swapchain.extent.height, 0.1f, 10.0f);
+    camera.transform.position.z = -5.0f;
+
+    Renderer renderer = Renderer::create(ctx, swapchain);
+    renderer.setSubmitMode(Renderer::SubmitMode::kDeferred);
+    while (!window.isClosed()) {
+        window.pollEvents();
+        if (renderer.beginFrame(ctx, swapchain)) {
+            for (const auto& tf : transforms) {
+                renderer.render(ctx, renderable, tf, camera);
+            }
+            renderer.endFrame(ctx, swapchain);
+
+            const Renderer::FrameStats& stats = renderer.getFrameStats();
+            EXPECT_EQ(stats.instanced_draw_count, 1u);
+            EXPECT_EQ(stats.instance_count, transforms.size());
+        }
+    }
+
+    vkDeviceWaitIdle(ctx.device);
+    material->destroy(ctx);
+    texture->destroy(ctx);
+    frag->destroy(ctx);
+    vert_instanced->destroy(ctx);
+    vert->destroy(ctx);
+    sphere->destroy(ctx);
+    renderer.destroy(ctx);
+    swapchain.destroy(ctx);
+    ctx.destroy();
+    window.destroy();
+}
+
+TEST(DrawModelTest, ParallelRecording) {
+    const size_t grid = 32;
+    const std::pair<size_t, size_t> size = { 800, 800 };
+    const std::string name = "parallel recording test";
+    Window window = Window::create(size.first, size.second, name);
+
+    RenderingContext ctx = RenderingContext::create();
+    Swapchain swapchain = Swapchain::create(ctx, window);
+
+    auto sphere = std::make_shared<Geometry>(Geometry::create(ctx, TEST_RESOURCE_DIR + std::string("/models/sphere.obj")));
+    auto vert = std::make_shared<Shader>(Shader::create(ctx, TEST_RESOURCE_DIR + std::string("/shaders/texture.vert.spv")));
+    auto frag = std::make_shared<Shader>(Shader::create(ctx, TEST_RESOURCE_DIR + std::string("/shaders/texture.frag.spv")));
+    auto texture = std::make_shared<Texture>(Texture::create(ctx, TEST_RESOURCE_DIR + std::string("/textures/statue.jpg")));
+    auto material = std::make_shared<Material>();
+    material->setVertexShader(vert);
+    material->setFragmentShader(frag);
+    material->setTexture(texture);
+
+    Renderable renderable{ sphere, material };
+    std::vector<Transform> transforms(grid * grid);
+    for (size_t i = 0; i < transforms.size(); ++i) {
+        transforms[i].position = Vec3((i % grid) - grid / 2.0f, (i / grid) - grid / 2.0f, 0.0f) * 2.5f;
+        transforms[i].scale = Vec3(0.05f, 0.05f, 0.05f);
+    }
+    PerspectiveCamera camera(45.0f, swapchain.extent.width / (float)swapchain.extent.height, 0.1f, 10.0f);
+    camera.transform.position.z = -5.0f;
+
+    Renderer renderer = Renderer::create(ctx, swapchain);
+    renderer.enableParallelRecording(ctx, 4);
+    while (!window.isClosed()) {
+        window.pollEvents();
+        if (renderer.beginFrame(ctx, swapchain)) {
+            for (const auto& tf : transforms) {
+                renderer.render(ctx, renderable, tf, camera);
+            }
+            renderer.endFrame(ctx, swapchain);
+
+            const Renderer::FrameStats& stats = renderer.getFrameStats();
+            EXPECT_EQ(stats.draw_count, stats.visible_count);
+        }
+    }
+
+    vkDeviceWaitIdle(ctx.device);
+    material->destroy(ctx);
+    texture->destroy(ctx);
+    frag->destroy(ctx);
+    vert->destroy(ctx);
+    sphere->destroy(ctx);
+    renderer.destroy(ctx);
+    swapchain.destroy(ctx);
+    ctx.destroy();
+    window.destroy();
+}
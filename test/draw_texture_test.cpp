@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include "kk_renderer/kk_renderer.h"
+#include <stdexcept>
 #ifndef TEST_RESOURCE_DIR
 #define TEST_RESOURCE_DIR "./resources"
 #endif
@@ -88,3 +89,60 @@ TEST(DrawTextureTest, TextureDrawing) {
     ctx.destroy();
     window.destroy();
 }
+
+TEST(DrawTextureTest, BatchCreation) {
+    RenderingContext ctx = RenderingContext::createHeadless();
+    const std::vector<std::string> paths = {
+        TEST_RESOURCE_DIR + std::string("/textures/statue.jpg"),
+        TEST_RESOURCE_DIR + std::string("/textures/viking_room.png"),
+        TEST_RESOURCE_DIR + std::string("/textures/statue.jpg"),
+    };
+
+    // Every upload of the batch goes into one submit
+    const size_t submits_before = ctx.transfer.getSubmitCount();
+    std::vector<Texture> textures = Texture::createBatch(ctx, paths, 0, 2);
+    EXPECT_EQ(ctx.transfer.getSubmitCount() - submits_before, 1u);
+    ASSERT_EQ(textures.size(), paths.size());
+    EXPECT_EQ(textures[0].width, textures[2].width);
+    EXPECT_EQ(textures[1].width, 1024u);
+
+    // A missing image fails the whole batch
+    EXPECT_THROW(Texture::createBatch(ctx, { paths[0], TEST_RESOURCE_DIR + std::string("/textures/missing.png") }), std::runtime_error);
+
+    for (auto& texture : textures) {
+        texture.destroy(ctx);
+    }
+    ctx.destroy();
+}
+
+TEST(DrawTextureTest, SharedSampler) {
+    RenderingContext ctx = RenderingContext::createHeadless();
+    // Different sizes and mip counts
+    Texture statue = Texture::create(ctx, TEST_RESOURCE_DIR + std::string("/textures/statue.jpg"));
+    Texture room = Texture::create(ctx, TEST_RESOURCE_DIR + std::string("/textures/viking_room.png"));
+    Texture room_no_mips = Texture::create(ctx, TEST_RESOURCE_DIR + std::string("/textures/viking_room.png"), kTextureNoMipmaps);
+    EXPECT_EQ(statue.sampler, room.sampler);
+    EXPECT_EQ(room.sampler, room_no_mips.sampler);
+    EXPECT_EQ(ctx.sampler_cache.getSamplerCount(), 1u);
+
+    // Sampler outlives textures using it
+    const VkSampler sampler = statue.sampler;
+    statue.destroy(ctx);
+    room.destroy(ctx);
+    room_no_mips.destroy(ctx);
+    Texture again = Texture::create(ctx, TEST_RESOURCE_DIR + std::string("/textures/statue.jpg"));
+    EXPECT_EQ(again.sampler, sampler);
+
+    // Other settings get their own sampler
+    VkSamplerCreateInfo info{};
+    info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    info.magFilter = VK_FILTER_NEAREST;
+    info.minFilter = VK_FILTER_NEAREST;
+    const VkSampler nearest = ctx.sampler_cache.get(ctx, info);
+    EXPECT_NE(nearest, sampler);
+    EXPECT_EQ(ctx.sampler_cache.get(ctx, info), nearest);
+    EXPECT_EQ(ctx.sampler_cache.getSamplerCount(), 2u);
+
+    again.destroy(ctx);
+    ctx.destroy();
+}
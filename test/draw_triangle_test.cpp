@@ -177,3 +177,55 @@ TEST(DrawTriangleTest, MultipleTransformDrawing) {
     ctx.destroy();
     window.destroy();
 }
+
+TEST(DrawTriangleTest, DeferredMultipleTransformDrawing) {
+    const size_t triangle_count = 5;
+    const std::pair<size_t, size_t> size = { 800, 800 };
+    const std::string name = "deferred multiple transform test";
+    Window window = Window::create(size.first, size.second, name);
+    RenderingContext ctx = RenderingContext::create();
+    Swapchain swapchain = Swapchain::create(ctx, window);
+
+    // Prepare an object
+    auto triangle = std::make_shared<Geometry>(Geometry::create(ctx, kTriangleVertices, kTriangleIndices));
+    auto texture = std::make_shared<Texture>(Texture::create(ctx, TEST_RESOURCE_DIR + std::string("/textures/statue.jpg")));
+    auto vert = std::make_shared<Shader>(Shader::create(ctx, TEST_RESOURCE_DIR + std::string("/shaders/triangle.vert.spv")));
+    auto frag = std::make_shared<Shader>(Shader::create(ctx, TEST_RESOURCE_DIR + std::string("/shaders/triangle.frag.spv")));
+    auto material = std::make_shared<Material>();
+    material->setTexture(texture);
+    material->setVertexShader(vert);
+    material->setFragmentShader(frag);
+    std::vector<Renderable> renderables(triangle_count);
+    std::vector<Transform> transforms(triangle_count);
+    for (size_t i = 0; i < triangle_count; ++i) {
+        renderables[i] = Renderable(triangle, material);
+        transforms[i].position.x = i / 2.0f;
+        transforms[i].scale = Vec3(0.2f, 0.2f, 0.2f);
+    }
+    PerspectiveCamera camera(45.0f, swapchain.extent.width / (float)swapchain.extent.height, 0.1f, 10.0f);
+    camera.transform.position.z = -2.0f;
+
+    Renderer renderer = Renderer::create(ctx, swapchain);
+    renderer.setSubmitMode(Renderer::SubmitMode::kDeferred);
+    while (!window.isClosed()) {
+        window.pollEvents();
+        
+        if (renderer.beginFrame(ctx, swapchain)) {
+            for (size_t i = 0; i < triangle_count; ++i) {
+                renderer.render(ctx, renderables[i], transforms[i], camera);
+            }
+            renderer.endFrame(ctx, swapchain);
+        }
+    }
+
+    vkDeviceWaitIdle(ctx.device);
+    material->destroy(ctx);
+    frag->destroy(ctx);
+    vert->destroy(ctx);
+    texture->destroy(ctx);
+    triangle->destroy(ctx);
+    renderer.destroy(ctx);
+    swapchain.destroy(ctx);
+    ctx.destroy();
+    window.destroy();
+}
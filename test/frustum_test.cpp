@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+#include "kk_renderer/Frustum.h"
+#include "kk_renderer/PerspectiveCamera.h"
+#include "kk_renderer/Geometry.h"
+#include <random>
+#include <vector>
+
+using namespace kk;
+using namespace kk::renderer;
+
+static Frustum createFrustum() {
+    PerspectiveCamera camera(45.0f, 1.0f, 0.1f, 10.0f);
+    camera.transform.position.z = -2.0f;
+    return Frustum::create(camera.getProjection() * camera.getView());
+}
+
+TEST(FrustumTest, SphereIntersection) {
+    const Frustum frustum = createFrustum();
+
+    // Camera at z = -2 looks toward +z
+    EXPECT_TRUE(frustum.intersects(Vec3(0.0f, 0.0f, 0.0f), 0.5f));
+    EXPECT_FALSE(frustum.intersects(Vec3(0.0f, 0.0f, -5.0f), 0.5f));  // Behind
+    EXPECT_FALSE(frustum.intersects(Vec3(0.0f, 0.0f, 20.0f), 0.5f));  // Beyond far
+    EXPECT_FALSE(frustum.intersects(Vec3(10.0f, 0.0f, 0.0f), 0.5f));  // Outside side
+    EXPECT_TRUE(frustum.intersects(Vec3(10.0f, 0.0f, 0.0f), 10.0f));  // Large enough to reach inside
+}
+
+TEST(FrustumTest, BatchMatchesScalar) {
+    const Frustum frustum = createFrustum();
+
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> dist(-10.0f, 10.0f);
+    const size_t count = 1001;
+    std::vector<float> xs(count), ys(count), zs(count), radii(count);
+    for (size_t i = 0; i < count; ++i) {
+        xs[i] = dist(rng);
+        ys[i] = dist(rng);
+        zs[i] = dist(rng);
+        radii[i] = std::abs(dist(rng)) * 0.2f;
+    }
+
+    std::vector<uint8_t> visible(count);
+    const size_t visible_count = frustum.cullSpheres(xs.data(), ys.data(), zs.data(), radii.data(), count, visible.data());
+
+    size_t expected_count = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const bool expected = frustum.intersects(Vec3(xs[i], ys[i], zs[i]), radii[i]);
+        EXPECT_EQ(visible[i] != 0, expected);
+        expected_count += expected ? 1 : 0;
+    }
+    EXPECT_EQ(visible_count, expected_count);
+    EXPECT_LT(visible_count, count);
+}
+
+TEST(FrustumTest, GeometryBounds) {
+    std::vector<Vertex> vertices(3);
+    vertices[0].position = Vec3(-1.0f, 0.0f, 0.0f);
+    vertices[1].position = Vec3(3.0f, 2.0f, 0.0f);
+    vertices[2].position = Vec3(1.0f, -2.0f, 4.0f);
+
+    const Bounds bounds = Bounds::create(vertices);
+    EXPECT_EQ(bounds.min, Vec3(-1.0f, -2.0f, 0.0f));
+    EXPECT_EQ(bounds.max, Vec3(3.0f, 2.0f, 4.0f));
+    EXPECT_EQ(bounds.center, Vec3(1.0f, 0.0f, 2.0f));
+    for (const auto& vertex : vertices) {
+        EXPECT_LE(glm::length(vertex.position - bounds.center), bounds.radius + 1e-5f);
+    }
+}
+
+static ClusterBounds createRandomClusters(size_t count) {
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> dist(-10.0f, 10.0f);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    ClusterBounds clusters;
+    for (size_t i = 0; i < count; ++i) {
+        clusters.x.push_back(dist(rng));
+        clusters.y.push_back(dist(rng));
+        clusters.z.push_back(dist(rng));
+        clusters.radius.push_back(std::abs(dist(rng)) * 0.1f);
+        const Vec3 axis = glm::normalize(Vec3(unit(rng), unit(rng), unit(rng)));
+        clusters.axis_x.push_back(axis.x);
+        clusters.axis_y.push_back(axis.y);
+        clusters.axis_z.push_back(axis.z);
+        clusters.cutoff.push_back(std::abs(unit(rng)));
+    }
+    return clusters;
+}
+
+TEST(FrustumTest, ClusterBatchMatchesScalar) {
+    const Frustum frustum = createFrustum();
+    const ClusterBounds clusters = createRandomClusters(1001);
+    const Vec3 eye(0.0f, 0.0f, -2.0f);
+
+    // Batch of 4 and remainder of 1 both take the result of the scalar test
+    std::vector<uint8_t> visible(clusters.size()), spheres_only(clusters.size());
+    const size_t visible_count = frustum.cullClusters(clusters, eye, 1.0f, visible.data());
+    frustum.cullClusters(clusters, eye, 0.0f, spheres_only.data());
+
+    size_t expected_count = 0, backfacing_count = 0;
+    for (size_t i = 0; i < clusters.size(); ++i) {
+        const Vec3 center(clusters.x[i], clusters.y[i], clusters.z[i]);
+        const Vec3 axis(clusters.axis_x[i], clusters.axis_y[i], clusters.axis_z[i]);
+        const bool is_inside = frustum.intersects(center, clusters.radius[i]);
+        const bool is_backfacing = glm::dot(center - eye, axis) >= clusters.cutoff[i] * glm::length(center - eye) + clusters.radius[i];
+        EXPECT_EQ(spheres_only[i] != 0, is_inside);
+        EXPECT_EQ(visible[i] != 0, is_inside && !is_backfacing);
+        expected_count += (is_inside && !is_backfacing) ? 1 : 0;
+        backfacing_count += (is_inside && is_backfacing) ? 1 : 0;
+    }
+    EXPECT_EQ(visible_count, expected_count);
+    EXPECT_GT(backfacing_count, 0u);
+}
+
+TEST(FrustumTest, ClusterBackfacing) {
+    const Frustum frustum = createFrustum();
+
+    // Flat cluster at the origin facing -z, toward the camera at z = -2
+    ClusterBounds clusters;
+    clusters.x = { 0.0f };
+    clusters.y = { 0.0f };
+    clusters.z = { 0.0f };
+    clusters.radius = { 0.1f };
+    clusters.axis_x = { 0.0f };
+    clusters.axis_y = { 0.0f };
+    clusters.axis_z = { -1.0f };
+    clusters.cutoff = { 0.0f };
+
+    uint8_t visible = 0;
+    EXPECT_EQ(frustum.cullClusters(clusters, Vec3(0.0f, 0.0f, -2.0f), 1.0f, &visible), 1u);
+    EXPECT_EQ(visible, 1);
+    // Opposite winding convention makes it a back face
+    EXPECT_EQ(frustum.cullClusters(clusters, Vec3(0.0f, 0.0f, -2.0f), -1.0f, &visible), 0u);
+    EXPECT_EQ(visible, 0);
+
+    // Cones too wide are never culled
+    clusters.cutoff = { 1.0f };
+    EXPECT_EQ(frustum.cullClusters(clusters, Vec3(0.0f, 0.0f, -2.0f), -1.0f, &visible), 1u);
+}
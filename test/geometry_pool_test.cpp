@@ -0,0 +1,161 @@
+#include <gtest/gtest.h>
+#include "kk_renderer/kk_renderer.h"
+#include <memory>
+#include <cstring>
+#ifndef TEST_RESOURCE_DIR
+#define TEST_RESOURCE_DIR "./resources"
+#endif
+
+using namespace kk;
+using namespace kk::renderer;
+
+static const std::vector<Vertex> kTriangleVertices = {
+    {{ 0.0f, -0.5f, 0.0f}, {}, {1.0f, 0.0f, 0.0f, 1.0f}},
+    {{ 0.5f,  0.5f, 0.0f}, {}, {1.0f, 0.0f, 0.0f, 1.0f}},
+    {{-0.5f,  0.5f, 0.0f}, {}, {1.0f, 0.0f, 0.0f, 1.0f}},
+};
+
+static const std::vector<uint32_t> kTriangleIndices = {
+    0, 1, 2
+};
+
+// Renders `geometry` at identity into a 64x64 offscreen target, and returns the centre pixel
+static std::array<uint8_t, 4> renderCenter(RenderingContext& ctx, const std::shared_ptr<Geometry>& geometry) {
+    const uint32_t size = 64;
+    Renderer renderer = Renderer::createOffscreen(ctx, size, size);
+    auto texture = std::make_shared<Texture>(Texture::create(ctx, TEST_RESOURCE_DIR + std::string("/textures/statue.jpg")));
+    auto vert = std::make_shared<Shader>(Shader::create(ctx, TEST_RESOURCE_DIR + std::string("/shaders/triangle.vert.spv")));
+    auto frag = std::make_shared<Shader>(Shader::create(ctx, TEST_RESOURCE_DIR + std::string("/shaders/triangle.frag.spv")));
+    auto material = std::make_shared<Material>();
+    material->setTexture(texture);
+    material->setVertexShader(vert);
+    material->setFragmentShader(frag);
+    material->setVertexFormat(geometry->vertex_format);
+    Renderable renderable{ geometry, material };
+
+    std::vector<uint8_t> pixels;
+    EXPECT_TRUE(renderer.beginFrame(ctx));
+    renderer.render(ctx, renderable, Mat4(1.0f));
+    renderer.endFrame(ctx);
+    EXPECT_TRUE(renderer.readback(ctx, pixels, true));
+
+    std::array<uint8_t, 4> center{};
+    std::copy(&pixels[((size / 2) * size + size / 2) * 4], &pixels[((size / 2) * size + size / 2) * 4] + 4, center.begin());
+
+    vkDeviceWaitIdle(ctx.device);
+    material->destroy(ctx);
+    vert->destroy(ctx);
+    frag->destroy(ctx);
+    texture->destroy(ctx);
+    renderer.destroy(ctx);
+    return center;
+}
+
+TEST(GeometryPoolTest, AllocateFreeCompact) {
+    RenderingContext ctx = RenderingContext::createHeadless();
+    ctx.geometry_pool = std::make_shared<GeometryPool>(GeometryPool::create(ctx, 1024 * 1024, 1024 * 1024));
+
+    Geometry a = Geometry::create(ctx, kTriangleVertices, kTriangleIndices, kGeometryPooled);
+    Geometry b = Geometry::create(ctx, kTriangleVertices, kTriangleIndices, kGeometryPooled);
+    auto c = std::make_shared<Geometry>(Geometry::create(ctx, kTriangleVertices, kTriangleIndices, kGeometryPooled));
+    ASSERT_NE(a.pool, nullptr);
+    ASSERT_NE(c->pool, nullptr);
+
+    // Pool buffers are shared, and ranges are addressable by vertexOffset / firstIndex
+    EXPECT_EQ(a.vertex_buffer.buffer, c->vertex_buffer.buffer);
+    EXPECT_EQ(a.index_buffer.buffer, c->index_buffer.buffer);
+    for (const Geometry* geometry : { &a, &b, c.get() }) {
+        const GeometryPool::Range range = geometry->getPoolRange();
+        EXPECT_EQ(range.vertex_offset, static_cast<VkDeviceSize>(range.base_vertex) * sizeof(Vertex));
+    }
+    EXPECT_NE(a.getPoolRange().vertex_offset, b.getPoolRange().vertex_offset);
+    EXPECT_NE(a.getPoolRange().first_index, b.getPoolRange().first_index);
+    EXPECT_EQ(ctx.geometry_pool->getStats().allocation_count, 3u);
+
+    // Freed ranges are released once frames are done with them
+    b.destroy(ctx);
+    vkDeviceWaitIdle(ctx.device);
+    ctx.deletion_queue.flush(ctx);
+    EXPECT_EQ(ctx.geometry_pool->getStats().allocation_count, 2u);
+
+    // Compaction closes the hole, and the moved geometry still draws
+    const GeometryPool::Range before = c->getPoolRange();
+    ctx.geometry_pool->compact(ctx);
+    const GeometryPool::Range after = c->getPoolRange();
+    EXPECT_LE(after.vertex_offset, before.vertex_offset);
+    EXPECT_LE(after.first_index, before.first_index);
+    const GeometryPool::Stats stats = ctx.geometry_pool->getStats();
+    EXPECT_EQ(stats.vertex_largest_free, stats.vertex_capacity - stats.vertex_used);
+    EXPECT_EQ(stats.index_largest_free, stats.index_capacity - stats.index_used);
+
+    const std::array<uint8_t, 4> center = renderCenter(ctx, c);
+    EXPECT_EQ(center[0], 255);
+    EXPECT_EQ(center[1], 0);
+
+    a.destroy(ctx);
+    c->destroy(ctx);
+    ctx.destroy();
+}
+
+TEST(GeometryPoolTest, CompactWithoutIndices) {
+    RenderingContext ctx = RenderingContext::createHeadless();
+    GeometryPool pool = GeometryPool::create(ctx, 1024, 1024);
+
+    // Vertex-only ranges, so that nothing is copied in index buffer
+    const std::vector<float> a_data(16, 1.0f), b_data(16, 2.0f);
+    const GeometryPool::Handle a = pool.allocate(ctx, a_data.data(), 64, 16, nullptr, 0, VK_INDEX_TYPE_UINT32);
+    const GeometryPool::Handle b = pool.allocate(ctx, b_data.data(), 64, 16, nullptr, 0, VK_INDEX_TYPE_UINT32);
+    ASSERT_NE(b, GeometryPool::kInvalidHandle);
+    pool.free(ctx, a);
+    ctx.transfer.flush(ctx);
+    vkDeviceWaitIdle(ctx.device);
+    ctx.deletion_queue.flush(ctx);
+
+    // Data of the moved range is at its new offset
+    const VkDeviceSize before = pool.getRange(b).vertex_offset;
+    pool.compact(ctx);
+    const VkDeviceSize after = pool.getRange(b).vertex_offset;
+    EXPECT_LT(after, before);
+    Buffer host = Buffer::create(ctx, 1024, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    pool.getVertexBuffer().copyTo(ctx, host, 1024);
+    ctx.transfer.flush(ctx);
+    ctx.transfer.wait(ctx);
+    EXPECT_EQ(std::memcmp(static_cast<const char*>(host.mapped) + after, b_data.data(), 64), 0);
+
+    host.destroy(ctx);
+    pool.destroy(ctx);
+    ctx.destroy();
+}
+
+TEST(GeometryPoolTest, PackedPooledDraw) {
+    RenderingContext ctx = RenderingContext::createHeadless();
+    ctx.geometry_pool = std::make_shared<GeometryPool>(GeometryPool::create(ctx, 1024 * 1024, 1024 * 1024));
+
+    // Float geometry in front, so that packed data does not start at offset 0
+    Geometry padding = Geometry::create(ctx, kTriangleVertices, kTriangleIndices, kGeometryPooled);
+    auto packed = std::make_shared<Geometry>(Geometry::create(ctx, kTriangleVertices, kTriangleIndices, kGeometryPooled | kGeometryPackVertices));
+    ASSERT_NE(packed->pool, nullptr);
+    EXPECT_EQ(packed->getPoolRange().vertex_offset % sizeof(PackedVertex), 0u);
+
+    const std::array<uint8_t, 4> center = renderCenter(ctx, packed);
+    EXPECT_EQ(center[0], 255);
+    EXPECT_EQ(center[1], 0);
+
+    padding.destroy(ctx);
+    packed->destroy(ctx);
+    ctx.destroy();
+}
+
+TEST(GeometryPoolTest, FullPoolFallback) {
+    RenderingContext ctx = RenderingContext::createHeadless();
+    ctx.geometry_pool = std::make_shared<GeometryPool>(GeometryPool::create(ctx, 64, 64));
+
+    // Triangle does not fit into 64 bytes of vertices, so it owns buffers
+    Geometry geometry = Geometry::create(ctx, kTriangleVertices, kTriangleIndices, kGeometryPooled);
+    EXPECT_EQ(geometry.pool, nullptr);
+    EXPECT_NE(geometry.vertex_buffer.buffer, ctx.geometry_pool->getVertexBuffer().buffer);
+    EXPECT_EQ(ctx.geometry_pool->getStats().allocation_count, 0u);
+
+    geometry.destroy(ctx);
+    ctx.destroy();
+}
@@ -0,0 +1,230 @@
+#include <gtest/gtest.h>
+#include "kk_renderer/MeshOptimizer.h"
+#include "kk_renderer/ObjLoader.h"
+#include <algorithm>
+#include <random>
+#include <array>
+#ifndef TEST_RESOURCE_DIR
+#define TEST_RESOURCE_DIR "./resources"
+#endif
+
+using namespace kk;
+using namespace kk::renderer;
+
+using Triangle = std::array<Vertex, 3>;
+
+// Triangles by value, rotated to start at the smallest vertex, so that order and winding preserving rotations compare equal
+static std::vector<std::array<float, 9>> toTriangles(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices) {
+    std::vector<std::array<float, 9>> triangles;
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        std::array<float, 9> tri;
+        size_t first = 0;
+        for (size_t k = 1; k < 3; ++k) {
+            const Vec3& p = vertices[indices[i + k]].position;
+            const Vec3& q = vertices[indices[i + first]].position;
+            if (std::tie(p.x, p.y, p.z) < std::tie(q.x, q.y, q.z)) {
+                first = k;
+            }
+        }
+        for (size_t k = 0; k < 3; ++k) {
+            const Vec3& p = vertices[indices[i + (first + k) % 3]].position;
+            tri[k * 3 + 0] = p.x;
+            tri[k * 3 + 1] = p.y;
+            tri[k * 3 + 2] = p.z;
+        }
+        triangles.push_back(tri);
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+// Grid with triangles in random order, the worst case for post-transform cache
+static void makeShuffledGrid(size_t grid, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+    for (size_t y = 0; y < grid; ++y) {
+        for (size_t x = 0; x < grid; ++x) {
+            Vertex vertex{};
+            vertex.position = Vec3(static_cast<float>(x), static_cast<float>(y), 0.0f);
+            vertices.push_back(vertex);
+        }
+    }
+    std::vector<std::array<uint32_t, 3>> triangles;
+    for (uint32_t y = 0; y + 1 < grid; ++y) {
+        for (uint32_t x = 0; x + 1 < grid; ++x) {
+            const uint32_t i = static_cast<uint32_t>(y * grid + x);
+            triangles.push_back({ i, i + 1, i + static_cast<uint32_t>(grid) });
+            triangles.push_back({ i + 1, i + static_cast<uint32_t>(grid) + 1, i + static_cast<uint32_t>(grid) });
+        }
+    }
+    std::shuffle(triangles.begin(), triangles.end(), std::mt19937(3));
+    for (const auto& triangle : triangles) {
+        indices.insert(indices.end(), triangle.begin(), triangle.end());
+    }
+}
+
+TEST(MeshOptimizerTest, AnalyzeVertexCache) {
+    // Two triangles sharing an edge: 4 transforms for 2 triangles and 4 vertices
+    const std::vector<uint32_t> indices = { 0, 1, 2, 2, 1, 3 };
+    const VertexCacheStats stats = analyzeVertexCache(indices, 4);
+    EXPECT_FLOAT_EQ(stats.acmr, 2.0f);
+    EXPECT_FLOAT_EQ(stats.atvr, 1.0f);
+}
+
+TEST(MeshOptimizerTest, VertexCacheImprovesAcmr) {
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    makeShuffledGrid(64, vertices, indices);
+    const auto expected = toTriangles(vertices, indices);
+
+    const VertexCacheStats before = analyzeVertexCache(indices, vertices.size());
+    optimizeVertexCache(indices, vertices.size());
+    const VertexCacheStats after = analyzeVertexCache(indices, vertices.size());
+
+    EXPECT_EQ(toTriangles(vertices, indices), expected);
+    EXPECT_GT(before.acmr, 2.5f);
+    EXPECT_LT(after.acmr, 0.8f);
+    EXPECT_LT(after.atvr, 1.5f);
+}
+
+TEST(MeshOptimizerTest, FullPipelineKeepsTriangles) {
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    loadObj(TEST_RESOURCE_DIR + std::string("/models/viking_room.obj"), vertices, indices);
+    const auto expected = toTriangles(vertices, indices);
+    const VertexCacheStats before = analyzeVertexCache(indices, vertices.size());
+
+    optimizeMesh(vertices, indices);
+    const VertexCacheStats after = analyzeVertexCache(indices, vertices.size());
+    EXPECT_EQ(toTriangles(vertices, indices), expected);
+    EXPECT_LT(after.acmr, before.acmr);
+
+    // Vertices are in first use order
+    uint32_t next = 0;
+    for (uint32_t index : indices) {
+        ASSERT_LE(index, next);
+        if (index == next) {
+            ++next;
+        }
+    }
+    EXPECT_EQ(next, vertices.size());
+}
+
+TEST(MeshOptimizerTest, VertexFetchDropsUnusedVertices) {
+    std::vector<Vertex> vertices(5);
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        vertices[i].position.x = static_cast<float>(i);
+    }
+    std::vector<uint32_t> indices = { 4, 2, 0 };
+    optimizeVertexFetch(vertices, indices);
+
+    ASSERT_EQ(vertices.size(), 3u);
+    EXPECT_EQ(indices, (std::vector<uint32_t>{ 0, 1, 2 }));
+    EXPECT_EQ(vertices[0].position.x, 4.0f);
+    EXPECT_EQ(vertices[1].position.x, 2.0f);
+    EXPECT_EQ(vertices[2].position.x, 0.0f);
+}
+
+TEST(MeshOptimizerTest, SimplifyFlatGrid) {
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    makeShuffledGrid(32, vertices, indices);
+
+    // Flat interior collapses without error, until the border vertices alone are left
+    std::vector<uint32_t> simplified;
+    float error = -1.0f;
+    simplifyMesh(vertices, indices.data(), indices.size(), indices.size() / 10, 1e-3f, simplified, &error);
+    EXPECT_LE(simplified.size(), indices.size() / 10);
+    EXPECT_GT(simplified.size(), 0u);
+    EXPECT_LT(error, 1e-3f);
+
+    // Outline is kept
+    Vec3 min(1e9f), max(-1e9f);
+    for (uint32_t index : simplified) {
+        min = glm::min(min, vertices[index].position);
+        max = glm::max(max, vertices[index].position);
+    }
+    EXPECT_EQ(min, Vec3(0.0f));
+    EXPECT_EQ(max, Vec3(31.0f, 31.0f, 0.0f));
+}
+
+TEST(MeshOptimizerTest, SimplifyRespectsErrorBound) {
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    loadObj(TEST_RESOURCE_DIR + std::string("/models/viking_room.obj"), vertices, indices);
+
+    std::vector<uint32_t> coarse, fine;
+    float coarse_error = 0.0f, fine_error = 0.0f;
+    simplifyMesh(vertices, indices.data(), indices.size(), 0, 0.05f, coarse, &coarse_error);
+    simplifyMesh(vertices, indices.data(), indices.size(), 0, 0.005f, fine, &fine_error);
+    EXPECT_LE(coarse_error, 0.05f);
+    EXPECT_LE(fine_error, 0.005f);
+    EXPECT_LT(coarse.size(), fine.size());
+    EXPECT_LT(fine.size(), indices.size());
+}
+
+TEST(MeshOptimizerTest, GenerateLods) {
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    loadObj(TEST_RESOURCE_DIR + std::string("/models/viking_room.obj"), vertices, indices);
+    const size_t lod0_count = indices.size();
+
+    std::vector<MeshLod> lods;
+    generateLods(vertices, indices, LodSettings::getDefault(), lods);
+    ASSERT_GE(lods.size(), 2u);
+    EXPECT_EQ(lods[0].first_index, 0u);
+    EXPECT_EQ(lods[0].index_count, lod0_count);
+    for (size_t i = 1; i < lods.size(); ++i) {
+        EXPECT_EQ(lods[i].first_index, lods[i - 1].first_index + lods[i - 1].index_count);
+        EXPECT_LT(lods[i].index_count, lods[i - 1].index_count);
+        EXPECT_GE(lods[i].error, lods[i - 1].error);
+    }
+    EXPECT_EQ(indices.size(), lods.back().first_index + lods.back().index_count);
+    for (uint32_t index : indices) {
+        ASSERT_LT(index, vertices.size());
+    }
+}
+
+TEST(MeshOptimizerTest, BuildMeshlets) {
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    loadObj(TEST_RESOURCE_DIR + std::string("/models/viking_room.obj"), vertices, indices);
+    const auto expected = toTriangles(vertices, indices);
+
+    std::vector<Meshlet> meshlets;
+    buildMeshlets(vertices, indices, meshlets);
+    EXPECT_EQ(toTriangles(vertices, indices), expected);
+
+    // Meshlets tile the index buffer in order, each within the limits and enclosed by its sphere
+    ASSERT_FALSE(meshlets.empty());
+    uint32_t next_index = 0;
+    for (const auto& meshlet : meshlets) {
+        EXPECT_EQ(meshlet.first_index, next_index);
+        EXPECT_LE(meshlet.index_count, kMaxMeshletTriangles * 3);
+        next_index += meshlet.index_count;
+
+        std::vector<uint32_t> unique(indices.begin() + meshlet.first_index, indices.begin() + meshlet.first_index + meshlet.index_count);
+        std::sort(unique.begin(), unique.end());
+        unique.erase(std::unique(unique.begin(), unique.end()), unique.end());
+        EXPECT_LE(unique.size(), kMaxMeshletVertices);
+        for (uint32_t index : unique) {
+            EXPECT_LE(glm::length(vertices[index].position - meshlet.center), meshlet.radius * 1.0001f + 1e-6f);
+        }
+    }
+    EXPECT_EQ(next_index, indices.size());
+    EXPECT_EQ(getClusterBounds(meshlets).size(), meshlets.size());
+}
+
+TEST(MeshOptimizerTest, MeshletConeOfFlatGrid) {
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    makeShuffledGrid(32, vertices, indices);
+
+    std::vector<Meshlet> meshlets;
+    buildMeshlets(vertices, indices, meshlets);
+    ASSERT_GT(meshlets.size(), 1u);
+
+    // Every triangle of the grid faces +z, so each cone is the +z axis with no spread
+    for (const auto& meshlet : meshlets) {
+        EXPECT_NEAR(meshlet.cone_axis.z, 1.0f, 1e-4f);
+        EXPECT_NEAR(meshlet.cone_cutoff, 0.0f, 1e-3f);
+    }
+}
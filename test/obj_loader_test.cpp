@@ -0,0 +1,167 @@
+#include <gtest/gtest.h>
+#include "kk_renderer/ObjLoader.h"
+#define TINYOBJLOADER_IMPLEMENTATION
+#include <tinyobjloader/tiny_obj_loader.h>
+#include <unordered_map>
+#include <fstream>
+#include <random>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#ifndef TEST_RESOURCE_DIR
+#define TEST_RESOURCE_DIR "./resources"
+#endif
+
+using namespace kk;
+using namespace kk::renderer;
+
+namespace {
+    struct VertexHash {
+        size_t operator()(const Vertex& v) const {
+            return std::hash<float>()(v.position.x) ^ (std::hash<float>()(v.position.y) << 1) ^ (std::hash<float>()(v.uv.x) << 2);
+        }
+    };
+}
+
+// Reference: tinyobj with deduplication by value
+static void loadWithTinyobj(const std::string& path, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+    tinyobj::attrib_t attr;
+    std::vector<tinyobj::shape_t> shapes;
+    std::vector<tinyobj::material_t> materials;
+    std::string warn, err;
+    ASSERT_TRUE(tinyobj::LoadObj(&attr, &shapes, &materials, &warn, &err, path.c_str())) << err;
+
+    std::unordered_map<Vertex, uint32_t, VertexHash> unique_vertices;
+    for (const auto& shape : shapes) {
+        for (const auto& index : shape.mesh.indices) {
+            Vertex vertex{};
+            vertex.position = {
+                attr.vertices[3 * index.vertex_index + 0],
+                attr.vertices[3 * index.vertex_index + 1],
+                attr.vertices[3 * index.vertex_index + 2]
+            };
+            vertex.uv = {
+                attr.texcoords[2 * index.texcoord_index + 0],
+                1.0f - attr.texcoords[2 * index.texcoord_index + 1]
+            };
+            vertex.color = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+            const auto inserted = unique_vertices.emplace(vertex, static_cast<uint32_t>(vertices.size()));
+            if (inserted.second) {
+                vertices.push_back(vertex);
+            }
+            indices.push_back(inserted.first->second);
+        }
+    }
+}
+
+static void expectSameMesh(
+    const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+    const std::vector<Vertex>& expected_vertices, const std::vector<uint32_t>& expected_indices
+) {
+    ASSERT_EQ(vertices.size(), expected_vertices.size());
+    ASSERT_EQ(indices.size(), expected_indices.size());
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        ASSERT_EQ(vertices[i], expected_vertices[i]) << "vertex " << i;
+    }
+    EXPECT_EQ(indices, expected_indices);
+}
+
+TEST(ObjLoaderTest, ParseFloatMatchesStrtof) {
+    const char* texts[] = {
+        "0", "-0", "1", "-1.5", "0.000001", "3.14159265358979", "123456.789", "+2.5",
+        "1e10", "-2.5E-3", "6.02214076e23", "1.17549435e-38", "0.1234567890123456789012345", ".5", "5."
+    };
+    for (const char* text : texts) {
+        const char* cur = text;
+        const char* end = text + std::strlen(text);
+        EXPECT_EQ(parseFloat(cur, end), std::strtof(text, nullptr)) << text;
+        EXPECT_EQ(cur, end) << text;
+    }
+
+    // Random numbers as printed by exporters. Allow 1 ulp for double rounding.
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> dist(-1000.0f, 1000.0f);
+    char text[64];
+    for (size_t i = 0; i < 100000; ++i) {
+        std::snprintf(text, sizeof(text), (i % 2 == 0) ? "%.6f" : "%.9g", dist(rng));
+        const char* cur = text;
+        const float expected = std::strtof(text, nullptr);
+        const float actual = parseFloat(cur, text + std::strlen(text));
+        ASSERT_LE(std::fabs(actual - expected), std::fabs(std::nextafter(expected, 2.0f * expected + 1.0f) - expected)) << text;
+    }
+
+    const char* empty = "  x";
+    const char* cur = empty;
+    EXPECT_EQ(parseFloat(cur, empty + 3), 0.0f);
+    EXPECT_EQ(cur, empty);
+}
+
+TEST(ObjLoaderTest, MatchesTinyobj) {
+    const std::string path = TEST_RESOURCE_DIR + std::string("/models/viking_room.obj");
+    std::vector<Vertex> expected_vertices, vertices;
+    std::vector<uint32_t> expected_indices, indices;
+    loadWithTinyobj(path, expected_vertices, expected_indices);
+    loadObj(path, vertices, indices);
+
+    expectSameMesh(vertices, indices, expected_vertices, expected_indices);
+}
+
+TEST(ObjLoaderTest, PolygonsAndRelativeIndicesAcrossChunks) {
+    // Grid of quads large enough to be split into several chunks, half of them with relative indices
+    const std::string path = "obj_loader_test_grid.obj";
+    const size_t grid = 300;
+    {
+        std::ofstream out(path);
+        out << "# grid\no grid\n";
+        for (size_t y = 0; y < grid; ++y) {
+            for (size_t x = 0; x < grid; ++x) {
+                out << "v " << x * 0.125f << " " << y * 0.25f << " -1.5e-1\r\n";
+                out << "vt " << x / float(grid) << " " << y / float(grid) << "\n";
+                out << "vn 0 0 1\n";
+            }
+        }
+        for (size_t y = 0; y + 1 < grid; ++y) {
+            for (size_t x = 0; x + 1 < grid; ++x) {
+                const size_t i = y * grid + x + 1;
+                const size_t corners[4] = { i, i + 1, i + grid + 1, i + grid };
+                out << "f";
+                for (size_t c : corners) {
+                    if (y % 2 == 0) {
+                        out << " " << c << "/" << c << "/1";
+                    }
+                    else {
+                        const long relative = static_cast<long>(c) - static_cast<long>(grid * grid) - 1;
+                        out << " " << relative << "/" << relative;
+                    }
+                }
+                out << "\n";
+            }
+        }
+    }
+
+    std::vector<Vertex> expected_vertices, single_vertices, vertices;
+    std::vector<uint32_t> expected_indices, single_indices, indices;
+    loadWithTinyobj(path, expected_vertices, expected_indices);
+    loadObj(path, single_vertices, single_indices, 1);
+    loadObj(path, vertices, indices, 8);
+    std::remove(path.c_str());
+
+    EXPECT_EQ(expected_indices.size(), (grid - 1) * (grid - 1) * 6);
+    expectSameMesh(single_vertices, single_indices, expected_vertices, expected_indices);
+    expectSameMesh(vertices, indices, expected_vertices, expected_indices);
+}
+
+TEST(ObjLoaderTest, ThrowsOnMissingFileAndBadFace) {
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    EXPECT_THROW(loadObj("no_such_file.obj", vertices, indices), std::runtime_error);
+
+    const std::string path = "obj_loader_test_bad.obj";
+    {
+        std::ofstream out(path);
+        out << "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 4\n";
+    }
+    EXPECT_THROW(loadObj(path, vertices, indices), std::runtime_error);
+    std::remove(path.c_str());
+}
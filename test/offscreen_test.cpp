@@ -0,0 +1,385 @@
+#include <gtest/gtest.h>
+#include "kk_renderer/kk_renderer.h"
+#include "kk_renderer/UniformAllocator.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <cstring>
+#ifndef TEST_RESOURCE_DIR
+#define TEST_RESOURCE_DIR "./resources"
+#endif
+
+using namespace kk;
+using namespace kk::renderer;
+
+static const std::vector<Vertex> kTriangleVertices = {
+    {{ 0.0f, -0.5f, 0.0f}, {}, {1.0f, 0.0f, 0.0f, 1.0f}},
+    {{ 0.5f,  0.5f, 0.0f}, {}, {1.0f, 0.0f, 0.0f, 1.0f}},
+    {{-0.5f,  0.5f, 0.0f}, {}, {1.0f, 0.0f, 0.0f, 1.0f}},
+};
+
+static const std::vector<uint32_t> kTriangleIndices = {
+    0, 1, 2
+};
+
+// Unit quad with UV covering the whole texture
+static const std::vector<Vertex> kQuadVertices = {
+    {{-0.5f, -0.5f, 0.0f}, {0.0f, 0.0f}, {1.0f, 1.0f, 1.0f, 1.0f}},
+    {{ 0.5f, -0.5f, 0.0f}, {1.0f, 0.0f}, {1.0f, 1.0f, 1.0f, 1.0f}},
+    {{ 0.5f,  0.5f, 0.0f}, {1.0f, 1.0f}, {1.0f, 1.0f, 1.0f, 1.0f}},
+    {{-0.5f,  0.5f, 0.0f}, {0.0f, 1.0f}, {1.0f, 1.0f, 1.0f, 1.0f}},
+};
+
+static const std::vector<uint32_t> kQuadIndices = {
+    0, 1, 2, 2, 3, 0
+};
+
+static const uint8_t* pixelAt(const std::vector<uint8_t>& pixels, uint32_t width, uint32_t x, uint32_t y) {
+    return &pixels[(y * width + x) * 4];
+}
+
+TEST(OffscreenTest, HeadlessContextCreation) {
+    RenderingContext ctx = RenderingContext::createHeadless();
+    ctx.destroy();
+}
+
+TEST(OffscreenTest, UniformBlockChaining) {
+    RenderingContext ctx = RenderingContext::createHeadless();
+    UniformAllocator uniform = UniformAllocator::create(ctx, 1024);
+
+    // Full blocks chain a new one instead of failing
+    uint32_t block = 0, offset = 0;
+    for (int i = 0; i < 64; ++i) {
+        ASSERT_NE(uniform.allocate(ctx, sizeof(Mat4), block, offset), nullptr);
+        EXPECT_LE(offset + sizeof(Mat4), uniform.blocks[block].size);
+    }
+    EXPECT_GT(uniform.blocks.size(), 1u);
+    // Larger than a block
+    ASSERT_NE(uniform.allocate(ctx, 4096, block, offset), nullptr);
+    EXPECT_EQ(offset, 0u);
+    EXPECT_GE(uniform.blocks[block].size, 4096u);
+
+    // Blocks are reused after reset
+    const size_t block_count = uniform.blocks.size();
+    uniform.reset();
+    for (int i = 0; i < 64; ++i) {
+        uniform.allocate(ctx, sizeof(Mat4), block, offset);
+    }
+    EXPECT_EQ(uniform.blocks.size(), block_count);
+
+    uniform.destroy(ctx);
+    ctx.destroy();
+}
+
+TEST(OffscreenTest, BufferCopyAfterUpload) {
+    RenderingContext ctx = RenderingContext::createHeadless();
+    Buffer device = Buffer::create(ctx, 256, VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    Buffer host = Buffer::create(ctx, 256, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    // Copy sees the upload recorded before it
+    std::vector<uint8_t> data(256);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<uint8_t>(i);
+    }
+    device.setData(ctx, data.data(), data.size());
+    device.copyTo(ctx, host, data.size());
+    ctx.transfer.flush(ctx);
+    ctx.transfer.wait(ctx);
+    EXPECT_EQ(std::memcmp(host.mapped, data.data(), data.size()), 0);
+
+    device.destroy(ctx);
+    host.destroy(ctx);
+    ctx.destroy();
+}
+
+TEST(OffscreenTest, TriangleReadback) {
+    const uint32_t width = 64, height = 64;
+    const size_t frame_count = 8;
+    RenderingContext ctx = RenderingContext::createHeadless();
+    Renderer renderer = Renderer::createOffscreen(ctx, width, height);
+    EXPECT_TRUE(renderer.isOffscreen());
+
+    auto geometry = std::make_shared<Geometry>(Geometry::create(ctx, kTriangleVertices, kTriangleIndices));
+    auto texture = std::make_shared<Texture>(Texture::create(ctx, TEST_RESOURCE_DIR + std::string("/textures/statue.jpg")));
+    auto vert = std::make_shared<Shader>(Shader::create(ctx, TEST_RESOURCE_DIR + std::string("/shaders/triangle.vert.spv")));
+    auto frag = std::make_shared<Shader>(Shader::create(ctx, TEST_RESOURCE_DIR + std::string("/shaders/triangle.frag.spv")));
+    auto material = std::make_shared<Material>();
+    material->setTexture(texture);
+    material->setVertexShader(vert);
+    material->setFragmentShader(frag);
+    Renderable renderable{ geometry, material };
+
+    std::vector<uint8_t> pixels;
+    std::vector<uint64_t> frames;
+    for (size_t i = 0; i < frame_count; ++i) {
+        ASSERT_TRUE(renderer.beginFrame(ctx));
+        renderer.render(ctx, renderable, Mat4(1.0f));
+        renderer.endFrame(ctx);
+
+        // Read back the previous frame while this frame is in flight
+        uint64_t frame = 0;
+        if (i > 0 && renderer.readback(ctx, pixels, true, &frame)) {
+            frames.push_back(frame);
+        }
+    }
+    uint64_t frame = 0;
+    while (renderer.readback(ctx, pixels, true, &frame)) {
+        frames.push_back(frame);
+    }
+
+    // Every frame is read back exactly once, in submission order
+    ASSERT_EQ(frames.size(), frame_count);
+    for (size_t i = 1; i < frames.size(); ++i) {
+        EXPECT_EQ(frames[i], frames[i - 1] + 1);
+    }
+
+    // Triangle covers the centre, and the corners keep the clear colour
+    ASSERT_EQ(pixels.size(), width * height * 4);
+    const uint8_t* center = pixelAt(pixels, width, width / 2, height / 2);
+    EXPECT_EQ(center[0], 255);
+    EXPECT_EQ(center[1], 0);
+    EXPECT_EQ(center[2], 0);
+    const uint8_t* corner = pixelAt(pixels, width, 0, 0);
+    EXPECT_EQ(corner[0], 0);
+    EXPECT_EQ(corner[3], 255);
+
+    vkDeviceWaitIdle(ctx.device);
+    material->destroy(ctx);
+    vert->destroy(ctx);
+    frag->destroy(ctx);
+    texture->destroy(ctx);
+    geometry->destroy(ctx);
+    renderer.destroy(ctx);
+    ctx.destroy();
+}
+
+TEST(OffscreenTest, PackedTriangleReadback) {
+    const uint32_t width = 64, height = 64;
+    RenderingContext ctx = RenderingContext::createHeadless();
+    Renderer renderer = Renderer::createOffscreen(ctx, width, height);
+
+    auto geometry = std::make_shared<Geometry>(Geometry::create(ctx, kTriangleVertices, kTriangleIndices, kGeometryPackVertices));
+    EXPECT_EQ(geometry->vertex_format, VertexFormat::kPackedConstantColor);
+    EXPECT_EQ(geometry->index_type, VK_INDEX_TYPE_UINT16);
+    auto texture = std::make_shared<Texture>(Texture::create(ctx, TEST_RESOURCE_DIR + std::string("/textures/statue.jpg")));
+    auto vert = std::make_shared<Shader>(Shader::create(ctx, TEST_RESOURCE_DIR + std::string("/shaders/triangle.vert.spv")));
+    auto frag = std::make_shared<Shader>(Shader::create(ctx, TEST_RESOURCE_DIR + std::string("/shaders/triangle.frag.spv")));
+    auto material = std::make_shared<Material>();
+    material->setTexture(texture);
+    material->setVertexShader(vert);
+    material->setFragmentShader(frag);
+    material->setVertexFormat(geometry->vertex_format);
+    Renderable renderable{ geometry, material };
+
+    ASSERT_TRUE(renderer.beginFrame(ctx));
+    renderer.render(ctx, renderable, Mat4(1.0f));
+    renderer.endFrame(ctx);
+    std::vector<uint8_t> pixels;
+    ASSERT_TRUE(renderer.readback(ctx, pixels, true));
+
+    // Same image as the float vertices
+    const uint8_t* center = pixelAt(pixels, width, width / 2, height / 2);
+    EXPECT_EQ(center[0], 255);
+    EXPECT_EQ(center[1], 0);
+    const uint8_t* corner = pixelAt(pixels, width, 0, 0);
+    EXPECT_EQ(corner[0], 0);
+
+    vkDeviceWaitIdle(ctx.device);
+    material->destroy(ctx);
+    vert->destroy(ctx);
+    frag->destroy(ctx);
+    texture->destroy(ctx);
+    geometry->destroy(ctx);
+    renderer.destroy(ctx);
+    ctx.destroy();
+}
+
+TEST(OffscreenTest, MaterialSharedAcrossVertexFormats) {
+    const uint32_t width = 64, height = 64;
+    RenderingContext ctx = RenderingContext::createHeadless();
+    Renderer renderer = Renderer::createOffscreen(ctx, width, height);
+
+    auto float_geometry = std::make_shared<Geometry>(Geometry::create(ctx, kTriangleVertices, kTriangleIndices));
+    auto packed_geometry = std::make_shared<Geometry>(Geometry::create(ctx, kTriangleVertices, kTriangleIndices, kGeometryPackVertices));
+    auto texture = std::make_shared<Texture>(Texture::create(ctx, TEST_RESOURCE_DIR + std::string("/textures/statue.jpg")));
+    auto vert = std::make_shared<Shader>(Shader::create(ctx, TEST_RESOURCE_DIR + std::string("/shaders/triangle.vert.spv")));
+    auto frag = std::make_shared<Shader>(Shader::create(ctx, TEST_RESOURCE_DIR + std::string("/shaders/triangle.frag.spv")));
+    // Vertex format is left default (kFloat)
+    auto material = std::make_shared<Material>();
+    material->setTexture(texture);
+    material->setVertexShader(vert);
+    material->setFragmentShader(frag);
+    Renderable float_renderable{ float_geometry, material };
+    Renderable packed_renderable{ packed_geometry, material };
+
+    ASSERT_TRUE(renderer.beginFrame(ctx));
+    renderer.render(ctx, float_renderable, glm::translate(Mat4(1.0f), Vec3(-0.5f, 0.0f, 0.0f)));
+    renderer.render(ctx, packed_renderable, glm::translate(Mat4(1.0f), Vec3(0.5f, 0.0f, 0.0f)));
+    renderer.endFrame(ctx);
+    std::vector<uint8_t> pixels;
+    ASSERT_TRUE(renderer.readback(ctx, pixels, true));
+
+    EXPECT_NE(material->getPipeline(VertexFormat::kFloat), VK_NULL_HANDLE);
+    EXPECT_NE(material->getPipeline(VertexFormat::kPackedConstantColor), VK_NULL_HANDLE);
+    EXPECT_EQ(material->getPipeline(VertexFormat::kPacked), VK_NULL_HANDLE);
+    const uint8_t* left = pixelAt(pixels, width, width / 4, height / 2);
+    EXPECT_EQ(left[0], 255);
+    const uint8_t* right = pixelAt(pixels, width, width * 3 / 4, height / 2);
+    EXPECT_EQ(right[0], 255);
+
+    vkDeviceWaitIdle(ctx.device);
+    material->destroy(ctx);
+    vert->destroy(ctx);
+    frag->destroy(ctx);
+    texture->destroy(ctx);
+    packed_geometry->destroy(ctx);
+    float_geometry->destroy(ctx);
+    renderer.destroy(ctx);
+    ctx.destroy();
+}
+
+TEST(OffscreenTest, LodSelection) {
+    const uint32_t width = 64, height = 64;
+    RenderingContext ctx = RenderingContext::createHeadless();
+    Renderer renderer = Renderer::createOffscreen(ctx, width, height);
+
+    auto geometry = std::make_shared<Geometry>(Geometry::create(ctx, TEST_RESOURCE_DIR + std::string("/models/viking_room.obj"), kGeometryGenerateLods));
+    ASSERT_GE(geometry->lods.size(), 2u);
+    auto texture = std::make_shared<Texture>(Texture::create(ctx, TEST_RESOURCE_DIR + std::string("/textures/viking_room.png")));
+    auto vert = std::make_shared<Shader>(Shader::create(ctx, TEST_RESOURCE_DIR + std::string("/shaders/texture.vert.spv")));
+    auto frag = std::make_shared<Shader>(Shader::create(ctx, TEST_RESOURCE_DIR + std::string("/shaders/texture.frag.spv")));
+    auto material = std::make_shared<Material>();
+    material->setTexture(texture);
+    material->setVertexShader(vert);
+    material->setFragmentShader(frag);
+    Renderable renderable{ geometry, material };
+    PerspectiveCamera camera(45.0f, 1.0f, 0.1f, 1000.0f);
+    camera.transform.position.z = -3.0f;
+
+    // Far object is drawn with the coarsest LOD, and more detail as it comes closer
+    const auto drawAt = [&](float z) {
+        Transform tf{};
+        tf.position.z = z;
+        EXPECT_TRUE(renderer.beginFrame(ctx));
+        renderer.render(ctx, renderable, tf, camera);
+        renderer.endFrame(ctx);
+        return renderer.getFrameStats().triangle_count;
+    };
+    const size_t far_triangles = drawAt(500.0f);
+    EXPECT_EQ(far_triangles, geometry->lods.back().index_count / 3);
+    EXPECT_GT(drawAt(0.0f), far_triangles);
+
+    vkDeviceWaitIdle(ctx.device);
+    material->destroy(ctx);
+    vert->destroy(ctx);
+    frag->destroy(ctx);
+    texture->destroy(ctx);
+    geometry->destroy(ctx);
+    renderer.destroy(ctx);
+    ctx.destroy();
+}
+
+TEST(OffscreenTest, ClusterCulling) {
+    const uint32_t width = 64, height = 64;
+    RenderingContext ctx = RenderingContext::createHeadless();
+    Renderer renderer = Renderer::createOffscreen(ctx, width, height);
+
+    auto geometry = std::make_shared<Geometry>(Geometry::create(ctx, TEST_RESOURCE_DIR + std::string("/models/viking_room.obj"), kGeometryBuildMeshlets));
+    ASSERT_GT(geometry->meshlets.size(), 1u);
+    auto texture = std::make_shared<Texture>(Texture::create(ctx, TEST_RESOURCE_DIR + std::string("/textures/viking_room.png")));
+    auto vert = std::make_shared<Shader>(Shader::create(ctx, TEST_RESOURCE_DIR + std::string("/shaders/texture.vert.spv")));
+    auto frag = std::make_shared<Shader>(Shader::create(ctx, TEST_RESOURCE_DIR + std::string("/shaders/texture.frag.spv")));
+    auto material = std::make_shared<Material>();
+    material->setTexture(texture);
+    material->setVertexShader(vert);
+    material->setFragmentShader(frag);
+    Renderable renderable{ geometry, material };
+    PerspectiveCamera camera(45.0f, 1.0f, 0.1f, 1000.0f);
+    camera.transform.position.z = -3.0f;
+
+    // Object partially out of view: some meshlets are culled, the rest drawn as fewer triangles
+    const size_t total_triangles = geometry->lods[0].index_count / 3;
+    for (auto mode : { Renderer::SubmitMode::kImmediate, Renderer::SubmitMode::kDeferred }) {
+        renderer.setSubmitMode(mode);
+        Transform tf{};
+        tf.position.x = 1.0f;
+        ASSERT_TRUE(renderer.beginFrame(ctx));
+        renderer.render(ctx, renderable, tf, camera);
+        renderer.endFrame(ctx);
+        const Renderer::FrameStats& stats = renderer.getFrameStats();
+        EXPECT_EQ(stats.cluster_count, geometry->meshlets.size());
+        EXPECT_GT(stats.cluster_culled_count, 0u);
+        EXPECT_LT(stats.cluster_culled_count, stats.cluster_count);
+        EXPECT_GT(stats.triangle_count, 0u);
+        EXPECT_LT(stats.triangle_count, total_triangles);
+        EXPECT_EQ(stats.visible_count, 1u);
+    }
+
+    vkDeviceWaitIdle(ctx.device);
+    material->destroy(ctx);
+    vert->destroy(ctx);
+    frag->destroy(ctx);
+    texture->destroy(ctx);
+    geometry->destroy(ctx);
+    renderer.destroy(ctx);
+    ctx.destroy();
+}
+
+TEST(OffscreenTest, MipmappedTextureReadback) {
+    const uint32_t width = 64, height = 64;
+    const uint32_t texture_size = 256;
+    RenderingContext ctx = RenderingContext::createHeadless();
+    Renderer renderer = Renderer::createOffscreen(ctx, width, height);
+
+    // Checker of 1 texel squares, whose every mip after mip 0 is uniformly grey
+    std::vector<uint8_t> texels(texture_size * texture_size * 4);
+    for (uint32_t y = 0; y < texture_size; ++y) {
+        for (uint32_t x = 0; x < texture_size; ++x) {
+            const uint8_t value = ((x + y) % 2 == 0) ? 255 : 0;
+            uint8_t* texel = &texels[(y * texture_size + x) * 4];
+            texel[0] = texel[1] = texel[2] = value;
+            texel[3] = 255;
+        }
+    }
+    auto texture = std::make_shared<Texture>(Texture::create(
+        ctx,
+        texels.data(),
+        4,
+        texture_size,
+        texture_size,
+        VK_FORMAT_R8G8B8A8_UNORM,
+        VK_IMAGE_TILING_OPTIMAL,
+        VK_IMAGE_USAGE_SAMPLED_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        VK_IMAGE_ASPECT_COLOR_BIT
+    ));
+    EXPECT_EQ(texture->mip_levels, Texture::getMipLevels(texture_size, texture_size));
+
+    auto geometry = std::make_shared<Geometry>(Geometry::create(ctx, kQuadVertices, kQuadIndices));
+    auto vert = std::make_shared<Shader>(Shader::create(ctx, TEST_RESOURCE_DIR + std::string("/shaders/texture.vert.spv")));
+    auto frag = std::make_shared<Shader>(Shader::create(ctx, TEST_RESOURCE_DIR + std::string("/shaders/texture.frag.spv")));
+    auto material = std::make_shared<Material>();
+    material->setTexture(texture);
+    material->setVertexShader(vert);
+    material->setFragmentShader(frag);
+    Renderable renderable{ geometry, material };
+
+    // Quad of 8x8 pixels, so that 32x32 texels fall into a pixel
+    std::vector<uint8_t> pixels;
+    ASSERT_TRUE(renderer.beginFrame(ctx));
+    renderer.render(ctx, renderable, glm::scale(Mat4(1.0f), Vec3(0.25f)));
+    renderer.endFrame(ctx);
+    ASSERT_TRUE(renderer.readback(ctx, pixels, true));
+
+    // Minified checker is filtered into grey instead of aliasing into black or white
+    const uint8_t* center = pixelAt(pixels, width, width / 2, height / 2);
+    EXPECT_NEAR(center[0], 128, 16);
+    EXPECT_NEAR(center[1], 128, 16);
+
+    vkDeviceWaitIdle(ctx.device);
+    material->destroy(ctx);
+    vert->destroy(ctx);
+    frag->destroy(ctx);
+    texture->destroy(ctx);
+    geometry->destroy(ctx);
+    renderer.destroy(ctx);
+    ctx.destroy();
+}
@@ -0,0 +1,41 @@
+#include <gtest/gtest.h>
+#include "kk_renderer/RadixSort.h"
+#include <vector>
+#include <random>
+#include <algorithm>
+
+using namespace kk::renderer;
+
+TEST(RadixSortTest, MatchesStableSort) {
+    std::mt19937_64 rng(42);
+    std::vector<SortItem> items(10000), tmp;
+    for (uint32_t i = 0; i < items.size(); ++i) {
+        // Few distinct upper bits to exercise duplicated keys and skipped passes
+        items[i].key = (rng() & 0xFF000000000FFFFFull) | (static_cast<uint64_t>(i % 7) << 40);
+        items[i].value = i;
+    }
+
+    std::vector<SortItem> expected = items;
+    std::stable_sort(expected.begin(), expected.end(), [](const SortItem& a, const SortItem& b) {
+        return a.key < b.key;
+    });
+
+    radixSort(items, tmp);
+    ASSERT_EQ(items.size(), expected.size());
+    for (size_t i = 0; i < items.size(); ++i) {
+        EXPECT_EQ(items[i].key, expected[i].key);
+        EXPECT_EQ(items[i].value, expected[i].value);
+    }
+}
+
+TEST(RadixSortTest, SameKeysKeepOrder) {
+    std::vector<SortItem> items, tmp;
+    for (uint32_t i = 0; i < 100; ++i) {
+        items.push_back({ 7, i });
+    }
+
+    radixSort(items, tmp);
+    for (uint32_t i = 0; i < items.size(); ++i) {
+        EXPECT_EQ(items[i].value, i);
+    }
+}
@@ -0,0 +1,228 @@
+#include <gtest/gtest.h>
+#include "kk_renderer/Texture.h"
+#include "kk_renderer/TextureLoader.h"
+#include <stdexcept>
+#include <cstring>
+#include <vector>
+
+using namespace kk::renderer;
+
+static TextureData createData(uint32_t width, uint32_t height, VkFormat format, size_t texel_byte, uint8_t (*texel)(uint32_t, uint32_t, size_t)) {
+    TextureData data{};
+    data.width = width;
+    data.height = height;
+    data.format = format;
+    data.texel_byte = texel_byte;
+    data.level_offsets.push_back(0);
+    data.texels.resize(width * height * texel_byte);
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            for (size_t c = 0; c < texel_byte; ++c) {
+                data.texels[(y * width + x) * texel_byte + c] = texel(x, y, c);
+            }
+        }
+    }
+    return data;
+}
+
+template <class T>
+static void put(std::vector<char>& bytes, size_t offset, T value) {
+    if (bytes.size() < offset + sizeof(T)) {
+        bytes.resize(offset + sizeof(T));
+    }
+    std::memcpy(&bytes[offset], &value, sizeof(T));
+}
+
+// Level `level` filled with its index, so that levels are told apart after parsing
+static std::vector<char> makeLevel(VkFormat format, uint32_t width, uint32_t height, uint32_t level) {
+    return std::vector<char>(getBlockCompressedSize(format, std::max(width >> level, 1u), std::max(height >> level, 1u)), static_cast<char>(level + 1));
+}
+
+// KTX2 with levels stored smallest first, as writers do
+static std::vector<char> makeKtx2(VkFormat format, uint32_t width, uint32_t height, uint32_t level_count) {
+    static const uint8_t identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+    std::vector<char> bytes(80 + 24 * level_count);
+    std::memcpy(bytes.data(), identifier, sizeof(identifier));
+    put<uint32_t>(bytes, 12, format);
+    put<uint32_t>(bytes, 16, 1);
+    put<uint32_t>(bytes, 20, width);
+    put<uint32_t>(bytes, 24, height);
+    put<uint32_t>(bytes, 36, 1);
+    put<uint32_t>(bytes, 40, level_count);
+    for (uint32_t level = level_count; level-- > 0;) {
+        const std::vector<char> data = makeLevel(format, width, height, level);
+        put<uint64_t>(bytes, 80 + 24 * level, bytes.size());
+        put<uint64_t>(bytes, 80 + 24 * level + 8, data.size());
+        put<uint64_t>(bytes, 80 + 24 * level + 16, data.size());
+        bytes.insert(bytes.end(), data.begin(), data.end());
+    }
+    return bytes;
+}
+
+static std::vector<char> makeDds(const char* four_cc, uint32_t dxgi_format, uint32_t width, uint32_t height, uint32_t level_count, VkFormat format) {
+    std::vector<char> bytes(128);
+    std::memcpy(bytes.data(), "DDS ", 4);
+    put<uint32_t>(bytes, 4, 124);
+    put<uint32_t>(bytes, 8, 0x1007 | 0x20000);
+    put<uint32_t>(bytes, 12, height);
+    put<uint32_t>(bytes, 16, width);
+    put<uint32_t>(bytes, 28, level_count);
+    put<uint32_t>(bytes, 76, 32);
+    put<uint32_t>(bytes, 80, 0x4);
+    std::memcpy(&bytes[84], four_cc, 4);
+    if (std::memcmp(four_cc, "DX10", 4) == 0) {
+        bytes.resize(128 + 20);
+        put<uint32_t>(bytes, 128, dxgi_format);
+        put<uint32_t>(bytes, 132, 3);
+        put<uint32_t>(bytes, 140, 1);
+    }
+    for (uint32_t level = 0; level < level_count; ++level) {
+        const std::vector<char> data = makeLevel(format, width, height, level);
+        bytes.insert(bytes.end(), data.begin(), data.end());
+    }
+    return bytes;
+}
+
+// Every level of `data` is 16 byte aligned and holds the fill of makeLevel()
+static void expectLevels(const TextureData& data, uint32_t width, uint32_t height, uint32_t level_count) {
+    ASSERT_EQ(data.getMipLevels(), level_count);
+    for (uint32_t level = 0; level < level_count; ++level) {
+        const VkDeviceSize offset = data.level_offsets[level];
+        const VkDeviceSize size = getBlockCompressedSize(data.format, std::max(width >> level, 1u), std::max(height >> level, 1u));
+        EXPECT_EQ(offset % TextureData::kLevelAlignment, 0u);
+        ASSERT_LE(offset + size, data.texels.size());
+        EXPECT_EQ(data.texels[offset], level + 1);
+        EXPECT_EQ(data.texels[offset + size - 1], level + 1);
+    }
+}
+
+TEST(TextureDataTest, MipLevels) {
+    EXPECT_EQ(Texture::getMipLevels(1, 1), 1u);
+    EXPECT_EQ(Texture::getMipLevels(256, 256), 9u);
+    EXPECT_EQ(Texture::getMipLevels(1024, 3), 11u);
+    EXPECT_EQ(Texture::getMipLevels(5, 7), 3u);
+}
+
+TEST(TextureDataTest, CheckerMips) {
+    TextureData data = createData(16, 8, VK_FORMAT_R8G8B8A8_UNORM, 4, [](uint32_t x, uint32_t y, size_t c) -> uint8_t {
+        return (c == 3) ? 255 : (((x + y) % 2 == 0) ? 255 : 0);
+    });
+    ASSERT_TRUE(data.generateMips());
+    ASSERT_EQ(data.getMipLevels(), 5u);
+
+    // Levels are in order and aligned for buffer to image copies, and the last one is 1x1
+    for (uint32_t level = 1; level < data.getMipLevels(); ++level) {
+        EXPECT_GT(data.level_offsets[level], data.level_offsets[level - 1]);
+        EXPECT_EQ(data.level_offsets[level] % 16, 0u);
+    }
+    EXPECT_EQ(data.texels.size(), data.level_offsets.back() + 4);
+
+    // Every texel after mip 0 averages to grey, alpha is kept
+    for (uint32_t level = 1; level < data.getMipLevels(); ++level) {
+        const uint8_t* texel = &data.texels[data.level_offsets[level]];
+        EXPECT_EQ(texel[0], 128);
+        EXPECT_EQ(texel[3], 255);
+    }
+}
+
+TEST(TextureDataTest, SrgbAveragedInLinearSpace) {
+    TextureData data = createData(2, 2, VK_FORMAT_R8G8B8A8_SRGB, 4, [](uint32_t x, uint32_t, size_t c) -> uint8_t {
+        return (c == 3) ? ((x == 0) ? 255 : 0) : ((x == 0) ? 255 : 0);
+    });
+    ASSERT_TRUE(data.generateMips());
+    ASSERT_EQ(data.getMipLevels(), 2u);
+
+    // Linear 0.5 is 188 in sRGB, while alpha is averaged as is
+    const uint8_t* texel = &data.texels[data.level_offsets[1]];
+    EXPECT_NEAR(texel[0], 188, 1);
+    EXPECT_EQ(texel[3], 128);
+}
+
+TEST(TextureDataTest, OddSizeAndUnsupportedFormat) {
+    TextureData odd = createData(3, 5, VK_FORMAT_R8_UNORM, 1, [](uint32_t, uint32_t, size_t) -> uint8_t {
+        return 100;
+    });
+    ASSERT_TRUE(odd.generateMips());
+    ASSERT_EQ(odd.getMipLevels(), 3u);
+    EXPECT_EQ(odd.texels[odd.level_offsets[1]], 100);
+    EXPECT_EQ(odd.texels[odd.level_offsets[2]], 100);
+
+    TextureData hdr = createData(4, 4, VK_FORMAT_R16G16B16A16_SFLOAT, 8, [](uint32_t, uint32_t, size_t) -> uint8_t {
+        return 0;
+    });
+    const std::vector<uint8_t> before = hdr.texels;
+    EXPECT_FALSE(hdr.generateMips());
+    EXPECT_EQ(hdr.getMipLevels(), 1u);
+    EXPECT_EQ(hdr.texels, before);
+}
+
+TEST(TextureDataTest, BlockCompressedSize) {
+    EXPECT_EQ(getBlockByte(VK_FORMAT_BC1_RGBA_SRGB_BLOCK), 8u);
+    EXPECT_EQ(getBlockByte(VK_FORMAT_BC7_UNORM_BLOCK), 16u);
+    EXPECT_EQ(getBlockByte(VK_FORMAT_R8G8B8A8_SRGB), 0u);
+    // Partial blocks at edges and mips smaller than a block take whole blocks
+    EXPECT_EQ(getBlockCompressedSize(VK_FORMAT_BC1_RGBA_SRGB_BLOCK, 1024, 1024), 1024u * 1024u / 2);
+    EXPECT_EQ(getBlockCompressedSize(VK_FORMAT_BC3_SRGB_BLOCK, 5, 3), 2u * 1u * 16u);
+    EXPECT_EQ(getBlockCompressedSize(VK_FORMAT_BC7_SRGB_BLOCK, 1, 1), 16u);
+}
+
+TEST(TextureDataTest, Ktx2Levels) {
+    for (VkFormat format : { VK_FORMAT_BC1_RGBA_SRGB_BLOCK, VK_FORMAT_BC3_SRGB_BLOCK, VK_FORMAT_BC5_UNORM_BLOCK, VK_FORMAT_BC7_SRGB_BLOCK }) {
+        const std::vector<char> bytes = makeKtx2(format, 64, 32, 7);
+        TextureData data{};
+        parseKtx2(bytes.data(), bytes.size(), data);
+        EXPECT_EQ(data.format, format);
+        EXPECT_EQ(data.width, 64u);
+        EXPECT_EQ(data.height, 32u);
+        EXPECT_EQ(data.texel_byte, getBlockByte(format));
+        expectLevels(data, 64, 32, 7);
+    }
+}
+
+TEST(TextureDataTest, DdsLevels) {
+    struct Case {
+        const char* four_cc;
+        uint32_t dxgi_format;
+        VkFormat format;
+    };
+    const Case cases[] = {
+        { "DXT1", 0, VK_FORMAT_BC1_RGBA_SRGB_BLOCK },
+        { "DXT5", 0, VK_FORMAT_BC3_SRGB_BLOCK },
+        { "ATI2", 0, VK_FORMAT_BC5_UNORM_BLOCK },
+        { "DX10", 98, VK_FORMAT_BC7_UNORM_BLOCK },
+        { "DX10", 72, VK_FORMAT_BC1_RGBA_SRGB_BLOCK },
+    };
+    for (const Case& c : cases) {
+        const std::vector<char> bytes = makeDds(c.four_cc, c.dxgi_format, 20, 12, 4, c.format);
+        TextureData data{};
+        parseDds(bytes.data(), bytes.size(), data);
+        EXPECT_EQ(data.format, c.format);
+        expectLevels(data, 20, 12, 4);
+    }
+}
+
+TEST(TextureDataTest, MalformedContainers) {
+    TextureData data{};
+    std::vector<char> bytes = makeKtx2(VK_FORMAT_BC7_SRGB_BLOCK, 16, 16, 3);
+
+    // Truncated level data
+    EXPECT_THROW(parseKtx2(bytes.data(), bytes.size() - 1, data), std::runtime_error);
+    // Supercompressed
+    std::vector<char> supercompressed = bytes;
+    put<uint32_t>(supercompressed, 44, 1);
+    EXPECT_THROW(parseKtx2(supercompressed.data(), supercompressed.size(), data), std::runtime_error);
+    // Uncompressed format
+    std::vector<char> uncompressed = bytes;
+    put<uint32_t>(uncompressed, 12, VK_FORMAT_R8G8B8A8_SRGB);
+    EXPECT_THROW(parseKtx2(uncompressed.data(), uncompressed.size(), data), std::runtime_error);
+    // Other container
+    EXPECT_THROW(parseDds(bytes.data(), bytes.size(), data), std::runtime_error);
+
+    // More mips than the size allows
+    std::vector<char> dds = makeDds("DXT1", 0, 4, 4, 4, VK_FORMAT_BC1_RGBA_SRGB_BLOCK);
+    EXPECT_THROW(parseDds(dds.data(), dds.size(), data), std::runtime_error);
+    // Cube map
+    dds = makeDds("DXT1", 0, 4, 4, 1, VK_FORMAT_BC1_RGBA_SRGB_BLOCK);
+    put<uint32_t>(dds, 112, 0x200);
+    EXPECT_THROW(parseDds(dds.data(), dds.size(), data), std::runtime_error);
+}
@@ -0,0 +1,36 @@
+#include <gtest/gtest.h>
+#include "kk_renderer/ThreadPool.h"
+#include <atomic>
+#include <vector>
+
+using namespace kk::renderer;
+
+TEST(ThreadPoolTest, RunsEveryTask) {
+    ThreadPool pool(4);
+    EXPECT_EQ(pool.getThreadCount(), 4u);
+
+    std::atomic<int> sum(0);
+    std::vector<std::future<int>> futures;
+    for (int i = 0; i < 1000; ++i) {
+        futures.push_back(pool.submit([i, &sum]() {
+            sum += i;
+            return i * 2;
+        }));
+    }
+
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_EQ(futures[i].get(), i * 2);
+    }
+    EXPECT_EQ(sum.load(), 999 * 1000 / 2);
+}
+
+TEST(ThreadPoolTest, CompletesQueuedTasksOnDestruction) {
+    std::atomic<int> count(0);
+    {
+        ThreadPool pool(2);
+        for (int i = 0; i < 100; ++i) {
+            pool.submit([&count]() { ++count; });
+        }
+    }
+    EXPECT_EQ(count.load(), 100);
+}
@@ -0,0 +1,60 @@
+#include <gtest/gtest.h>
+#include "kk_renderer/Tlsf.h"
+#include <vector>
+
+using namespace kk::renderer;
+
+TEST(TlsfTest, AlignedAllocation) {
+    Tlsf tlsf;
+    tlsf.init(1024);
+
+    uint64_t a_offset = 0, b_offset = 0;
+    const uint32_t a = tlsf.allocate(10, 1, a_offset);
+    const uint32_t b = tlsf.allocate(64, 256, b_offset);
+    ASSERT_NE(a, Tlsf::kInvalidNode);
+    ASSERT_NE(b, Tlsf::kInvalidNode);
+    EXPECT_EQ(b_offset % 256, 0u);
+    EXPECT_TRUE(a_offset + 10 <= b_offset || b_offset + 64 <= a_offset);
+    EXPECT_EQ(tlsf.getUsedSize(), 74u);
+    EXPECT_EQ(tlsf.getAllocationCount(), 2u);
+
+    tlsf.free(a);
+    tlsf.free(b);
+    EXPECT_TRUE(tlsf.isEmpty());
+    EXPECT_EQ(tlsf.getLargestFreeRange(), 1024u);
+}
+
+TEST(TlsfTest, OutOfSpace) {
+    Tlsf tlsf;
+    tlsf.init(256);
+
+    uint64_t offset = 0;
+    EXPECT_EQ(tlsf.allocate(512, 1, offset), Tlsf::kInvalidNode);
+
+    const uint32_t whole = tlsf.allocate(256, 1, offset);
+    ASSERT_NE(whole, Tlsf::kInvalidNode);
+    EXPECT_EQ(tlsf.allocate(1, 1, offset), Tlsf::kInvalidNode);
+}
+
+TEST(TlsfTest, CoalesceFreeRanges) {
+    Tlsf tlsf;
+    tlsf.init(4096);
+
+    std::vector<uint32_t> nodes;
+    uint64_t offset = 0;
+    for (int i = 0; i < 16; ++i) {
+        nodes.push_back(tlsf.allocate(256, 1, offset));
+        ASSERT_NE(nodes.back(), Tlsf::kInvalidNode);
+    }
+    EXPECT_EQ(tlsf.getLargestFreeRange(), 0u);
+
+    // Free every other range, then the rest
+    for (size_t i = 0; i < nodes.size(); i += 2) {
+        tlsf.free(nodes[i]);
+    }
+    EXPECT_EQ(tlsf.getLargestFreeRange(), 256u);
+    for (size_t i = 1; i < nodes.size(); i += 2) {
+        tlsf.free(nodes[i]);
+    }
+    EXPECT_EQ(tlsf.getLargestFreeRange(), 4096u);
+}
@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+#include "kk_renderer/TransformStore.h"
+#include <random>
+#include <vector>
+
+using namespace kk;
+using namespace kk::renderer;
+
+static void expectNear(const Mat4& a, const Mat4& b) {
+    for (int c = 0; c < 4; ++c) {
+        for (int r = 0; r < 4; ++r) {
+            EXPECT_NEAR(a[c][r], b[c][r], 1e-4f);
+        }
+    }
+}
+
+static Transform randomTransform(std::mt19937& rng) {
+    std::uniform_real_distribution<float> dist(-2.0f, 2.0f);
+    Transform tf;
+    tf.position = Vec3(dist(rng), dist(rng), dist(rng));
+    tf.rotation = glm::normalize(Quat(dist(rng), dist(rng), dist(rng), dist(rng)));
+    tf.scale = Vec3(dist(rng), dist(rng), dist(rng));
+    return tf;
+}
+
+TEST(TransformStoreTest, MatchesGlmPath) {
+    std::mt19937 rng(7);
+    const Mat4 view_proj = glm::perspective(glm::radians(45.0f), 1.5f, 0.1f, 10.0f) * glm::translate(Mat4(1.0f), Vec3(0.0f, 0.0f, -3.0f));
+
+    // NOTE: Not a multiple of 4 to exercise padding
+    TransformStore store;
+    std::vector<Transform> transforms(13);
+    std::vector<TransformStore::Handle> handles;
+    for (auto& tf : transforms) {
+        tf = randomTransform(rng);
+        handles.push_back(store.add(tf));
+    }
+    store.update(view_proj);
+
+    for (size_t i = 0; i < transforms.size(); ++i) {
+        const Mat4 model =
+            glm::scale(Mat4(1.0f), transforms[i].scale) *
+            glm::mat4_cast(transforms[i].rotation) *
+            glm::translate(Mat4(1.0f), transforms[i].position);
+        expectNear(store.getModel(handles[i]), model);
+        expectNear(store.getMvp(handles[i]), view_proj * model);
+    }
+}
+
+TEST(TransformStoreTest, UpdatesOnlyModified) {
+    std::mt19937 rng(11);
+    const Mat4 view_proj(1.0f);
+
+    TransformStore store;
+    const TransformStore::Handle a = store.add(randomTransform(rng));
+    const TransformStore::Handle b = store.add(randomTransform(rng));
+    store.update(view_proj);
+    const Mat4 b_model = store.getModel(b);
+
+    const Transform moved = randomTransform(rng);
+    store.set(a, moved);
+    store.update(view_proj);
+    expectNear(store.getModel(a), TransformStore::computeModel(moved));
+    expectNear(store.getMvp(a), TransformStore::computeModel(moved));
+    expectNear(store.getModel(b), b_model);
+
+    // Removed handle is reused
+    store.remove(a);
+    EXPECT_EQ(store.add(Transform{}), a);
+}
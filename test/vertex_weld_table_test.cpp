@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+#include "kk_renderer/VertexWeldTable.h"
+#include <map>
+#include <cstring>
+#include <random>
+
+using namespace kk;
+using namespace kk::renderer;
+
+static Vertex makeVertex(uint32_t key) {
+    Vertex vertex{};
+    vertex.position = Vec3(static_cast<float>(key % 97), static_cast<float>(key / 97), 0.5f);
+    vertex.uv = Vec2(static_cast<float>(key) * 0.25f, 1.0f);
+    vertex.color = Vec4(1.0f);
+    return vertex;
+}
+
+TEST(VertexWeldTableTest, DeduplicatesLikeOrderedMap) {
+    // Start small to go through several rehashes
+    VertexWeldTable table(4);
+    std::vector<Vertex> vertices;
+    std::map<uint32_t, uint32_t> expected;
+
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<uint32_t> dist(0, 20000);
+    for (size_t i = 0; i < 200000; ++i) {
+        const uint32_t key = dist(rng);
+        const uint32_t index = table.weld(makeVertex(key), vertices);
+
+        const auto inserted = expected.emplace(key, static_cast<uint32_t>(expected.size()));
+        ASSERT_EQ(index, inserted.first->second);
+    }
+
+    EXPECT_EQ(table.size(), expected.size());
+    EXPECT_EQ(vertices.size(), expected.size());
+    EXPECT_LE(table.size() * 2, table.getCapacity());
+    for (const auto& kvp : expected) {
+        EXPECT_EQ(vertices[kvp.second], makeVertex(kvp.first));
+    }
+}
+
+TEST(VertexWeldTableTest, PresizedTableDoesNotGrow) {
+    VertexWeldTable table(1000);
+    const size_t capacity = table.getCapacity();
+    std::vector<Vertex> vertices;
+    for (uint32_t i = 0; i < 1000; ++i) {
+        table.weld(makeVertex(i), vertices);
+    }
+    EXPECT_EQ(table.getCapacity(), capacity);
+}
+
+TEST(VertexWeldTableTest, HashSpreadsColorAndPositionBits) {
+    // Vertices differing in a single component must land on different low bits
+    Vertex a = makeVertex(1), b = a, c = a;
+    b.color.w = 0.5f;
+    c.position.z = std::nextafter(c.position.z, 1.0f);
+    const uint64_t ha = VertexWeldTable::hash(a);
+    EXPECT_NE(ha & 0xFFFF, VertexWeldTable::hash(b) & 0xFFFF);
+    EXPECT_NE(ha & 0xFFFF, VertexWeldTable::hash(c) & 0xFFFF);
+    EXPECT_EQ(ha, VertexWeldTable::hash(makeVertex(1)));
+}